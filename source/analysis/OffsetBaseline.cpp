@@ -0,0 +1,90 @@
+// OffsetBaseline.cpp
+
+#include "OffsetBaseline.hpp"
+
+#include <algorithm>
+
+OffsetBaseline::OffsetBaseline(std::size_t channels):
+    channels { channels }
+{}
+
+void OffsetBaseline::reset(std::size_t channels)
+{
+    this->channels = channels;
+    times.clear();
+    values.clear();
+}
+
+void OffsetBaseline::add(double time, std::span<const float> offsets)
+{
+    times.push_back(time);
+    values.insert(values.end(), offsets.begin(), offsets.begin() + channels);
+}
+
+std::size_t OffsetBaseline::measurements() const
+{
+    return times.size();
+}
+
+void OffsetBaseline::locate(double time, std::size_t& a, std::size_t& b, float& fraction) const
+{
+    fraction = 0.00f;
+
+    if (time <= times.front())
+    {
+        a = b = 0;
+        return;
+    }
+
+    if (time >= times.back())
+    {
+        a = b = times.size() - 1;
+        return;
+    }
+
+    // times[a] <= time < times[b]
+    auto upper = std::upper_bound(times.begin(), times.end(), time);
+    b = static_cast<std::size_t>(upper - times.begin());
+    a = b - 1;
+
+    double span = times[b] - times[a];
+
+    if (span > 0.00)
+        fraction = static_cast<float>((time - times[a]) / span);
+}
+
+void OffsetBaseline::at(double time, std::span<float> offsets) const
+{
+    if (times.empty())
+        return;
+
+    std::size_t a;
+    std::size_t b;
+    float fraction;
+
+    locate(time, a, b, fraction);
+
+    for (std::size_t k = 0; k < channels; ++k)
+    {
+        float first = values[a * channels + k];
+        float second = values[b * channels + k];
+        offsets[k] = first + fraction * (second - first);
+    }
+}
+
+float OffsetBaseline::at(double time, std::size_t channel) const
+{
+    if (times.empty())
+        return 0.00f;
+
+    std::size_t a;
+    std::size_t b;
+    float fraction;
+
+    locate(time, a, b, fraction);
+
+    float first = values[a * channels + channel];
+    float second = values[b * channels + channel];
+
+    return first + fraction * (second - first);
+}
@@ -0,0 +1,49 @@
+// OffsetBaseline.hpp
+
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstddef>
+
+// The intrinsic current of each channel, measured with every tube
+// disconnected, at the times it was measured during a run. Between two
+// measurements the offset is taken to drift linearly, so a sample is
+// corrected with the offset expected at its own time rather than the one
+// measured at the start of the run. Before the first measurement and after
+// the latest one the nearest measurement holds: a sample taken while the
+// next measurement is still to come is not extrapolated, and is corrected
+// again once that measurement exists.
+class OffsetBaseline
+{
+public:
+    explicit OffsetBaseline(std::size_t channels = 0);
+
+    // Starts over with `channels` channels and no measurements.
+    void reset(std::size_t channels);
+
+    // Measurements must come in time order, in seconds since the run began.
+    // The span holds one offset per channel.
+    void add(double time, std::span<const float> offsets);
+
+    std::size_t measurements() const;
+
+    // Writes the offset of every channel at `time` into `offsets`. Nothing
+    // is written before the first measurement.
+    void at(double time, std::span<float> offsets) const;
+
+    // The offset of one channel at `time`, or 0 before the first measurement.
+    float at(double time, std::size_t channel) const;
+
+private:
+    // The measurements on either side of `time` and how far it lies from
+    // the first towards the second, between 0 and 1.
+    void locate(double time, std::size_t& a, std::size_t& b, float& fraction) const;
+
+private:
+    std::size_t channels;
+    std::vector<double> times;
+
+    // Measurement m of channel k is values[m * channels + k].
+    std::vector<float> values;
+};
@@ -0,0 +1,437 @@
+// SampleKernels.cpp
+
+#include "SampleKernels.hpp"
+
+#include <bit>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+#if !defined(DCCS_KERNELS_SCALAR_ONLY)
+    #if defined(__AVX2__)
+        #define DCCS_KERNELS_AVX2
+        #include <immintrin.h>
+    #elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+        #define DCCS_KERNELS_SSE2
+        #include <emmintrin.h>
+    #endif
+#endif
+
+std::size_t SampleBuffer::size() const
+{
+    return current.size();
+}
+
+void SampleBuffer::reserve(std::size_t n)
+{
+    channel.reserve(n);
+    tube.reserve(n);
+    time.reserve(n);
+    current.reserve(n);
+    voltage.reserve(n);
+}
+
+void SampleBuffer::clear()
+{
+    channel.clear();
+    tube.clear();
+    time.clear();
+    current.clear();
+    voltage.clear();
+}
+
+void SampleBuffer::push_back(int channel, int tube, float time, float current, float voltage)
+{
+    this->channel.push_back(channel);
+    this->tube.push_back(tube);
+    this->time.push_back(time);
+    this->current.push_back(current);
+    this->voltage.push_back(voltage);
+}
+
+static void checkSizes(std::size_t values, std::size_t other)
+{
+    if (values != other)
+        throw std::invalid_argument("SampleKernels: mismatched buffer sizes");
+}
+
+/*
+ * Scalar reference implementation.
+ */
+
+void SampleKernels::scalar::scale(std::span<float> values, float factor)
+{
+    for (auto& v : values)
+        v *= factor;
+}
+
+void SampleKernels::scalar::addOffsets(std::span<float> values, std::span<const float> offsets)
+{
+    checkSizes(values.size(), offsets.size());
+
+    for (std::size_t i = 0; i < values.size(); ++i)
+        values[i] += offsets[i];
+}
+
+void SampleKernels::scalar::subtractOffsets(std::span<float> values, std::span<const float> offsets)
+{
+    checkSizes(values.size(), offsets.size());
+
+    for (std::size_t i = 0; i < values.size(); ++i)
+        values[i] -= offsets[i];
+}
+
+void SampleKernels::scalar::subtractOffset(std::span<float> values, float offset)
+{
+    for (auto& v : values)
+        v -= offset;
+}
+
+SampleStatistics SampleKernels::scalar::statistics(std::span<const float> values)
+{
+    SampleStatistics result;
+
+    if (values.empty())
+        return result;
+
+    double sum = 0.00;
+    float min = values[0];
+    float max = values[0];
+
+    for (auto v : values)
+    {
+        sum += v;
+        min = std::min(min, v);
+        max = std::max(max, v);
+    }
+
+    double mean = sum / values.size();
+    double squares = 0.00;
+
+    for (auto v : values)
+        squares += (v - mean) * (v - mean);
+
+    result.count = values.size();
+    result.mean = mean;
+    result.variance = (values.size() > 1) ? squares / (values.size() - 1) : 0.00;
+    result.min = min;
+    result.max = max;
+
+    return result;
+}
+
+std::size_t SampleKernels::scalar::thresholdMask(
+    std::span<const float> values, 
+    float threshold, 
+    std::span<std::uint8_t> mask
+)
+{
+    if (mask.size() < values.size())
+        throw std::invalid_argument("SampleKernels: mask is too small");
+
+    std::size_t above = 0;
+
+    for (std::size_t i = 0; i < values.size(); ++i)
+    {
+        mask[i] = values[i] > threshold;
+        above += mask[i];
+    }
+
+    return above;
+}
+
+/*
+ * Vectorised implementation. Each kernel runs over full vector-width blocks
+ * and hands the remaining tail to the scalar loop.
+ */
+
+#if defined(DCCS_KERNELS_AVX2)
+
+using Vec = __m256;
+constexpr std::size_t width = 8;
+
+static inline Vec load(const float* p) { return _mm256_loadu_ps(p); }
+static inline void store(float* p, Vec v) { _mm256_storeu_ps(p, v); }
+static inline Vec broadcast(float x) { return _mm256_set1_ps(x); }
+static inline Vec add(Vec a, Vec b) { return _mm256_add_ps(a, b); }
+static inline Vec sub(Vec a, Vec b) { return _mm256_sub_ps(a, b); }
+static inline Vec mul(Vec a, Vec b) { return _mm256_mul_ps(a, b); }
+static inline Vec vmin(Vec a, Vec b) { return _mm256_min_ps(a, b); }
+static inline Vec vmax(Vec a, Vec b) { return _mm256_max_ps(a, b); }
+static inline int greaterMask(Vec a, Vec b) { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GT_OQ)); }
+
+#elif defined(DCCS_KERNELS_SSE2)
+
+using Vec = __m128;
+constexpr std::size_t width = 4;
+
+static inline Vec load(const float* p) { return _mm_loadu_ps(p); }
+static inline void store(float* p, Vec v) { _mm_storeu_ps(p, v); }
+static inline Vec broadcast(float x) { return _mm_set1_ps(x); }
+static inline Vec add(Vec a, Vec b) { return _mm_add_ps(a, b); }
+static inline Vec sub(Vec a, Vec b) { return _mm_sub_ps(a, b); }
+static inline Vec mul(Vec a, Vec b) { return _mm_mul_ps(a, b); }
+static inline Vec vmin(Vec a, Vec b) { return _mm_min_ps(a, b); }
+static inline Vec vmax(Vec a, Vec b) { return _mm_max_ps(a, b); }
+static inline int greaterMask(Vec a, Vec b) { return _mm_movemask_ps(_mm_cmpgt_ps(a, b)); }
+
+#endif
+
+#if defined(DCCS_KERNELS_AVX2) || defined(DCCS_KERNELS_SSE2)
+
+// Expands a movemask result into one byte per lane, so a whole block of the
+// threshold mask is written with a single copy.
+static constexpr auto maskBytes = []() {
+    std::array<std::uint64_t, 256> table {};
+
+    for (std::size_t bits = 0; bits < table.size(); ++bits)
+        for (std::size_t k = 0; k < 8; ++k)
+            if (bits & (1u << k))
+                table[bits] |= std::uint64_t(1) << (8 * k);
+
+    return table;
+}();
+
+// Statistics walk the data in cache-sized blocks, so the min/max pass and the
+// summing pass over a block hit the cache rather than memory.
+constexpr std::size_t blockSize = 4096;
+
+// Sums are accumulated in double precision lanes; a float accumulator loses
+// the low digits long before a multi-million sample archive is summed.
+static double sumAsDouble(const float* data, std::size_t n, double shift, std::size_t& processed, bool squared)
+{
+    processed = n - (n % width);
+
+#if defined(DCCS_KERNELS_AVX2)
+    __m256d accumulator = _mm256_setzero_pd();
+    __m256d s = _mm256_set1_pd(shift);
+
+    for (std::size_t i = 0; i < processed; i += width)
+    {
+        Vec v = load(data + i);
+        __m256d lo = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(v)), s);
+        __m256d hi = _mm256_sub_pd(_mm256_cvtps_pd(_mm256_extractf128_ps(v, 1)), s);
+
+        if (squared)
+        {
+            lo = _mm256_mul_pd(lo, lo);
+            hi = _mm256_mul_pd(hi, hi);
+        }
+
+        accumulator = _mm256_add_pd(accumulator, _mm256_add_pd(lo, hi));
+    }
+
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, accumulator);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#else
+    __m128d accumulator = _mm_setzero_pd();
+    __m128d s = _mm_set1_pd(shift);
+
+    for (std::size_t i = 0; i < processed; i += width)
+    {
+        Vec v = load(data + i);
+        __m128d lo = _mm_sub_pd(_mm_cvtps_pd(v), s);
+        __m128d hi = _mm_sub_pd(_mm_cvtps_pd(_mm_movehl_ps(v, v)), s);
+
+        if (squared)
+        {
+            lo = _mm_mul_pd(lo, lo);
+            hi = _mm_mul_pd(hi, hi);
+        }
+
+        accumulator = _mm_add_pd(accumulator, _mm_add_pd(lo, hi));
+    }
+
+    alignas(16) double lanes[2];
+    _mm_store_pd(lanes, accumulator);
+    return lanes[0] + lanes[1];
+#endif
+}
+
+const char* SampleKernels::implementation()
+{
+#if defined(DCCS_KERNELS_AVX2)
+    return "avx2";
+#else
+    return "sse2";
+#endif
+}
+
+void SampleKernels::scale(std::span<float> values, float factor)
+{
+    std::size_t n = values.size() - (values.size() % width);
+    Vec f = broadcast(factor);
+
+    for (std::size_t i = 0; i < n; i += width)
+        store(values.data() + i, mul(load(values.data() + i), f));
+
+    scalar::scale(values.subspan(n), factor);
+}
+
+void SampleKernels::addOffsets(std::span<float> values, std::span<const float> offsets)
+{
+    checkSizes(values.size(), offsets.size());
+    std::size_t n = values.size() - (values.size() % width);
+
+    for (std::size_t i = 0; i < n; i += width)
+        store(values.data() + i, add(load(values.data() + i), load(offsets.data() + i)));
+
+    scalar::addOffsets(values.subspan(n), offsets.subspan(n));
+}
+
+void SampleKernels::subtractOffsets(std::span<float> values, std::span<const float> offsets)
+{
+    checkSizes(values.size(), offsets.size());
+    std::size_t n = values.size() - (values.size() % width);
+
+    for (std::size_t i = 0; i < n; i += width)
+        store(values.data() + i, sub(load(values.data() + i), load(offsets.data() + i)));
+
+    scalar::subtractOffsets(values.subspan(n), offsets.subspan(n));
+}
+
+void SampleKernels::subtractOffset(std::span<float> values, float offset)
+{
+    std::size_t n = values.size() - (values.size() % width);
+    Vec o = broadcast(offset);
+
+    for (std::size_t i = 0; i < n; i += width)
+        store(values.data() + i, sub(load(values.data() + i), o));
+
+    scalar::subtractOffset(values.subspan(n), offset);
+}
+
+SampleStatistics SampleKernels::statistics(std::span<const float> values)
+{
+    SampleStatistics result;
+
+    if (values.size() < width)
+        return scalar::statistics(values);
+
+    std::size_t n = values.size() - (values.size() % width);
+    double sum = 0.00;
+
+    Vec lowest = load(values.data());
+    Vec highest = lowest;
+
+    // Min and max ride along with the sum, so the data is only read twice.
+    for (std::size_t block = 0; block < n; block += blockSize)
+    {
+        std::size_t end = std::min(n, block + blockSize);
+
+        for (std::size_t i = block; i < end; i += width)
+        {
+            Vec v = load(values.data() + i);
+            lowest = vmin(lowest, v);
+            highest = vmax(highest, v);
+        }
+
+        std::size_t processed = 0;
+        sum += sumAsDouble(values.data() + block, end - block, 0.00, processed, false);
+    }
+
+    alignas(32) float lanesMin[width];
+    alignas(32) float lanesMax[width];
+    store(lanesMin, lowest);
+    store(lanesMax, highest);
+
+    float min = lanesMin[0];
+    float max = lanesMax[0];
+
+    for (std::size_t k = 1; k < width; ++k)
+    {
+        min = std::min(min, lanesMin[k]);
+        max = std::max(max, lanesMax[k]);
+    }
+
+    for (std::size_t i = n; i < values.size(); ++i)
+    {
+        sum += values[i];
+        min = std::min(min, values[i]);
+        max = std::max(max, values[i]);
+    }
+
+    double mean = sum / values.size();
+    double squares = sumAsDouble(values.data(), values.size(), mean, n, true);
+
+    for (std::size_t i = n; i < values.size(); ++i)
+        squares += (values[i] - mean) * (values[i] - mean);
+
+    result.count = values.size();
+    result.mean = mean;
+    result.variance = squares / (values.size() - 1);
+    result.min = min;
+    result.max = max;
+
+    return result;
+}
+
+std::size_t SampleKernels::thresholdMask(
+    std::span<const float> values, 
+    float threshold, 
+    std::span<std::uint8_t> mask
+)
+{
+    if (mask.size() < values.size())
+        throw std::invalid_argument("SampleKernels: mask is too small");
+
+    std::size_t n = values.size() - (values.size() % width);
+    std::size_t above = 0;
+    Vec t = broadcast(threshold);
+
+    for (std::size_t i = 0; i < n; i += width)
+    {
+        auto bits = static_cast<unsigned>(greaterMask(load(values.data() + i), t));
+        std::memcpy(mask.data() + i, &maskBytes[bits], width);
+        above += std::popcount(bits);
+    }
+
+    return above + scalar::thresholdMask(values.subspan(n), threshold, mask.subspan(n));
+}
+
+#else
+
+const char* SampleKernels::implementation()
+{
+    return "scalar";
+}
+
+void SampleKernels::scale(std::span<float> values, float factor)
+{
+    scalar::scale(values, factor);
+}
+
+void SampleKernels::addOffsets(std::span<float> values, std::span<const float> offsets)
+{
+    scalar::addOffsets(values, offsets);
+}
+
+void SampleKernels::subtractOffsets(std::span<float> values, std::span<const float> offsets)
+{
+    scalar::subtractOffsets(values, offsets);
+}
+
+void SampleKernels::subtractOffset(std::span<float> values, float offset)
+{
+    scalar::subtractOffset(values, offset);
+}
+
+SampleStatistics SampleKernels::statistics(std::span<const float> values)
+{
+    return scalar::statistics(values);
+}
+
+std::size_t SampleKernels::thresholdMask(
+    std::span<const float> values, 
+    float threshold, 
+    std::span<std::uint8_t> mask
+)
+{
+    return scalar::thresholdMask(values, threshold, mask);
+}
+
+#endif
@@ -0,0 +1,73 @@
+// SampleKernels.hpp
+
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// A batch of samples stored as a structure of arrays. Every vector has the
+// same length, and entry i of each vector describes sample i. Keeping each
+// quantity contiguous is what lets the kernels below run over whole batches
+// with vector instructions.
+struct SampleBuffer
+{
+    std::vector<int> channel;
+    std::vector<int> tube;
+    std::vector<float> time;
+    std::vector<float> current;
+    std::vector<float> voltage;
+
+    std::size_t size() const;
+    void reserve(std::size_t n);
+    void clear();
+    void push_back(int channel, int tube, float time, float current, float voltage);
+};
+
+struct SampleStatistics
+{
+    std::size_t count { 0 };
+    double mean { 0.00 };
+    double variance { 0.00 };
+    float min { 0.00f };
+    float max { 0.00f };
+};
+
+namespace SampleKernels
+{
+    // Name of the implementation selected at compile time ("avx2", "sse2" or
+    // "scalar").
+    const char* implementation();
+
+    // values[i] *= factor
+    void scale(std::span<float> values, float factor);
+
+    // values[i] += offsets[i] and values[i] -= offsets[i], respectively. The
+    // two spans must have the same length.
+    void addOffsets(std::span<float> values, std::span<const float> offsets);
+    void subtractOffsets(std::span<float> values, std::span<const float> offsets);
+
+    // values[i] -= offset
+    void subtractOffset(std::span<float> values, float offset);
+
+    // Count, mean, sample variance, min and max over the values. The variance
+    // is computed with a second pass around the mean to keep it stable.
+    SampleStatistics statistics(std::span<const float> values);
+
+    // mask[i] = values[i] > threshold. Returns the number of values above the
+    // threshold. The mask must be at least as long as the values.
+    std::size_t thresholdMask(std::span<const float> values, float threshold, std::span<std::uint8_t> mask);
+
+    // Plain loops, always available. The functions above fall back to these
+    // when no vector unit is available, and they serve as a reference.
+    namespace scalar
+    {
+        void scale(std::span<float> values, float factor);
+        void addOffsets(std::span<float> values, std::span<const float> offsets);
+        void subtractOffsets(std::span<float> values, std::span<const float> offsets);
+        void subtractOffset(std::span<float> values, float offset);
+        SampleStatistics statistics(std::span<const float> values);
+        std::size_t thresholdMask(std::span<const float> values, float threshold, std::span<std::uint8_t> mask);
+    }
+}
@@ -0,0 +1,620 @@
+// RunArchive.cpp
+
+#include "RunArchive.hpp"
+
+#include <bit>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef _WIN32
+    #define NOMINMAX
+    #include <Windows.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+static constexpr char headerMagic[8] = { 'D', 'C', 'C', 'S', 'R', 'U', 'N', '\0' };
+static constexpr char footerMagic[8] = { 'D', 'C', 'C', 'S', 'E', 'N', 'D', '\0' };
+static constexpr char blockMagic[4] = { 'T', 'U', 'B', 'E' };
+static constexpr std::uint16_t version = 2;
+
+static constexpr std::size_t blockHeaderSize = 4 + 4 * 4 + 4 + 4;
+static constexpr std::size_t footerTrailerSize = 4 + 8 + 8;
+
+/*
+ * Encoding helpers.
+ */
+
+static void putVarint(std::vector<std::uint8_t>& out, std::uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<std::uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+
+    out.push_back(static_cast<std::uint8_t>(value));
+}
+
+static std::uint64_t getVarint(const std::uint8_t*& p, const std::uint8_t* end)
+{
+    std::uint64_t value = 0;
+
+    for (int shift = 0; shift < 64 && p < end; shift += 7)
+    {
+        std::uint8_t byte = *p++;
+        value |= std::uint64_t(byte & 0x7F) << shift;
+
+        if (!(byte & 0x80))
+            return value;
+    }
+
+    throw std::runtime_error("RunArchive: truncated varint");
+}
+
+static std::uint32_t zigzag(std::int32_t v)
+{
+    return (static_cast<std::uint32_t>(v) << 1) ^ static_cast<std::uint32_t>(v >> 31);
+}
+
+static std::int32_t unzigzag(std::uint32_t v)
+{
+    return static_cast<std::int32_t>((v >> 1) ^ (~(v & 1) + 1));
+}
+
+template <typename T>
+static void put(std::vector<std::uint8_t>& out, T value)
+{
+    static_assert(std::endian::native == std::endian::little, "RunArchive assumes a little-endian host");
+    auto raw = reinterpret_cast<const std::uint8_t*>(&value);
+    out.insert(out.end(), raw, raw + sizeof(T));
+}
+
+template <typename T>
+static T get(std::span<const std::uint8_t> bytes, std::size_t offset)
+{
+    if (offset + sizeof(T) > bytes.size())
+        throw std::runtime_error("RunArchive: read past the end of the file");
+
+    T value;
+    std::memcpy(&value, bytes.data() + offset, sizeof(T));
+    return value;
+}
+
+// Delta coder for one stream of a block.
+struct FloatStream
+{
+    std::uint32_t previous { 0 };
+    std::vector<std::uint8_t> bytes;
+
+    void add(float value)
+    {
+        auto bits = std::bit_cast<std::uint32_t>(value);
+        putVarint(bytes, zigzag(static_cast<std::int32_t>(bits - previous)));
+        previous = bits;
+    }
+};
+
+/*
+ * Writer.
+ */
+
+struct RunArchiveWriter::OpenTube
+{
+    int channel;
+    int index;
+    int physicalTube;
+    float intrinsicCurrent;
+    std::uint32_t samples { 0 };
+    std::uint32_t previousTime { 0 };
+
+    std::vector<std::uint8_t> times;
+    FloatStream currents;
+    FloatStream voltages;
+};
+
+RunArchiveWriter::RunArchiveWriter(const std::string& path, const ArchiveHeader& header):
+    file { std::fopen(path.c_str(), "wb") },
+    position { 0 }
+{
+    if (!file)
+        throw std::runtime_error("RunArchive: cannot create " + path);
+
+    std::vector<std::uint8_t> payload;
+
+    put<std::int32_t>(payload, header.mode);
+    put<std::int32_t>(payload, header.parameters.secondsPerTube);
+    put<std::int32_t>(payload, header.parameters.tubesPerChannel);
+    put<std::int32_t>(payload, header.parameters.timeForTestingVoltage);
+
+    if (header.configurations.size() != header.channels.size())
+        throw std::invalid_argument("RunArchive: one configuration per channel is needed");
+
+    put<std::uint32_t>(payload, static_cast<std::uint32_t>(header.channels.size()));
+
+    for (std::size_t k = 0; k < header.channels.size(); ++k)
+    {
+        const auto& configuration = header.configurations[k];
+
+        put<std::int32_t>(payload, header.channels[k]);
+        put<std::int32_t>(payload, configuration.testVoltage);
+        put<std::int32_t>(payload, configuration.currentLimit);
+        put<std::int32_t>(payload, configuration.maxVoltage);
+        put<std::int32_t>(payload, configuration.rampUpRate);
+        put<std::int32_t>(payload, configuration.rampDownRate);
+        put<std::int32_t>(payload, configuration.overCurrentLimit);
+        put<std::int32_t>(payload, configuration.powerDownMethod);
+    }
+
+    put<std::int64_t>(payload, header.startTime);
+    put<std::uint32_t>(payload, static_cast<std::uint32_t>(header.runId.size()));
+    payload.insert(payload.end(), header.runId.begin(), header.runId.end());
+
+    std::vector<std::uint8_t> out;
+    out.insert(out.end(), headerMagic, headerMagic + sizeof(headerMagic));
+    put<std::uint16_t>(out, version);
+    put<std::uint16_t>(out, 0);
+    put<std::uint32_t>(out, static_cast<std::uint32_t>(payload.size()));
+    out.insert(out.end(), payload.begin(), payload.end());
+
+    write(out.data(), out.size());
+    std::fflush(file);
+}
+
+RunArchiveWriter::~RunArchiveWriter()
+{
+    try
+    {
+        close();
+    }
+    catch (...)
+    {
+        return;
+    }
+}
+
+void RunArchiveWriter::write(const void* data, std::size_t size)
+{
+    if (std::fwrite(data, 1, size, file) != size)
+        throw std::runtime_error("RunArchive: write failed");
+
+    position += size;
+}
+
+RunArchiveWriter::OpenTube* RunArchiveWriter::find(int channel)
+{
+    for (auto& tube : open)
+        if (tube->channel == channel)
+            return tube.get();
+
+    return nullptr;
+}
+
+void RunArchiveWriter::beginTube(int channel, int index, int physicalTube, float intrinsicCurrent)
+{
+    if (find(channel))
+        endTube(channel);
+
+    auto tube = std::make_unique<OpenTube>();
+    tube->channel = channel;
+    tube->index = index;
+    tube->physicalTube = physicalTube;
+    tube->intrinsicCurrent = intrinsicCurrent;
+
+    open.push_back(std::move(tube));
+}
+
+void RunArchiveWriter::addSample(int channel, float time, float current, float voltage)
+{
+    auto tube = find(channel);
+
+    if (!tube)
+        return;
+
+    auto milliseconds = static_cast<std::uint32_t>(time * 1000.0f + 0.5f);
+    putVarint(tube->times, milliseconds - tube->previousTime);
+    tube->previousTime = milliseconds;
+
+    tube->currents.add(current);
+    tube->voltages.add(voltage);
+    ++tube->samples;
+}
+
+void RunArchiveWriter::endTube(int channel)
+{
+    if (!file)
+        return;
+
+    auto it = open.begin();
+    for (; it != open.end(); ++it)
+        if ((*it)->channel == channel)
+            break;
+
+    if (it == open.end())
+        return;
+
+    auto& tube = **it;
+
+    std::vector<std::uint8_t> payload;
+    put<std::uint32_t>(payload, static_cast<std::uint32_t>(tube.times.size()));
+    put<std::uint32_t>(payload, static_cast<std::uint32_t>(tube.currents.bytes.size()));
+    payload.insert(payload.end(), tube.times.begin(), tube.times.end());
+    payload.insert(payload.end(), tube.currents.bytes.begin(), tube.currents.bytes.end());
+    payload.insert(payload.end(), tube.voltages.bytes.begin(), tube.voltages.bytes.end());
+
+    std::vector<std::uint8_t> out;
+    out.insert(out.end(), blockMagic, blockMagic + sizeof(blockMagic));
+    put<std::int32_t>(out, tube.channel);
+    put<std::int32_t>(out, tube.index);
+    put<std::int32_t>(out, tube.physicalTube);
+    put<std::uint32_t>(out, tube.samples);
+    put<float>(out, tube.intrinsicCurrent);
+    put<std::uint32_t>(out, static_cast<std::uint32_t>(payload.size()));
+    out.insert(out.end(), payload.begin(), payload.end());
+
+    blockOffsets.push_back(position);
+    write(out.data(), out.size());
+
+    // Each finished tube goes to the OS straight away, so a crash only loses
+    // the tubes still being sampled.
+    std::fflush(file);
+
+    open.erase(it);
+}
+
+void RunArchiveWriter::close()
+{
+    if (!file)
+        return;
+
+    while (!open.empty())
+        endTube(open.front()->channel);
+
+    std::vector<std::uint8_t> out;
+    std::uint64_t footerOffset = position;
+
+    for (auto offset : blockOffsets)
+        put<std::uint64_t>(out, offset);
+
+    put<std::uint32_t>(out, static_cast<std::uint32_t>(blockOffsets.size()));
+    put<std::uint64_t>(out, footerOffset);
+    out.insert(out.end(), footerMagic, footerMagic + sizeof(footerMagic));
+
+    write(out.data(), out.size());
+
+    std::fclose(file);
+    file = nullptr;
+}
+
+/*
+ * Reader.
+ */
+
+struct RunArchive::Mapping
+{
+    const std::uint8_t* data { nullptr };
+    std::size_t size { 0 };
+
+#ifdef _WIN32
+    HANDLE file { INVALID_HANDLE_VALUE };
+    HANDLE map { nullptr };
+#endif
+
+    explicit Mapping(const std::string& path)
+    {
+#ifdef _WIN32
+        file = CreateFileA(
+            path.c_str(), 
+            GENERIC_READ, 
+            FILE_SHARE_READ, 
+            nullptr, 
+            OPEN_EXISTING, 
+            FILE_ATTRIBUTE_NORMAL, 
+            nullptr
+        );
+
+        if (file == INVALID_HANDLE_VALUE)
+            throw std::runtime_error("RunArchive: cannot open " + path);
+
+        LARGE_INTEGER length;
+        GetFileSizeEx(file, &length);
+        size = static_cast<std::size_t>(length.QuadPart);
+
+        if (size == 0)
+            return;
+
+        map = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        if (!map)
+        {
+            CloseHandle(file);
+            throw std::runtime_error("RunArchive: cannot map " + path);
+        }
+
+        data = static_cast<const std::uint8_t*>(MapViewOfFile(map, FILE_MAP_READ, 0, 0, 0));
+
+        if (!data)
+        {
+            CloseHandle(map);
+            CloseHandle(file);
+            throw std::runtime_error("RunArchive: cannot map " + path);
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+
+        if (fd < 0)
+            throw std::runtime_error("RunArchive: cannot open " + path);
+
+        struct stat status;
+        fstat(fd, &status);
+        size = static_cast<std::size_t>(status.st_size);
+
+        if (size == 0)
+        {
+            ::close(fd);
+            return;
+        }
+
+        void* p = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+
+        if (p == MAP_FAILED)
+            throw std::runtime_error("RunArchive: cannot map " + path);
+
+        data = static_cast<const std::uint8_t*>(p);
+#endif
+    }
+
+    ~Mapping()
+    {
+#ifdef _WIN32
+        if (data)
+            UnmapViewOfFile(data);
+        if (map)
+            CloseHandle(map);
+        if (file != INVALID_HANDLE_VALUE)
+            CloseHandle(file);
+#else
+        if (data)
+            munmap(const_cast<std::uint8_t*>(data), size);
+#endif
+    }
+};
+
+RunArchive::RunArchive(const std::string& path):
+    mapping { std::make_unique<Mapping>(path) },
+    firstBlock { 0 },
+    hasFooter { false }
+{
+    bytes = std::span<const std::uint8_t>(mapping->data, mapping->size);
+
+    parseHeader();
+
+    hasFooter = readFooter();
+
+    if (!hasFooter)
+        scanBlocks();
+}
+
+RunArchive::~RunArchive()
+{}
+
+const ArchiveHeader& RunArchive::header() const
+{
+    return archiveHeader;
+}
+
+std::span<const ArchiveBlock> RunArchive::blocks() const
+{
+    return archiveBlocks;
+}
+
+bool RunArchive::complete() const
+{
+    return hasFooter;
+}
+
+void RunArchive::parseHeader()
+{
+    if (bytes.size() < 16 || std::memcmp(bytes.data(), headerMagic, sizeof(headerMagic)) != 0)
+        throw std::runtime_error("RunArchive: not a run archive");
+
+    auto fileVersion = get<std::uint16_t>(bytes, 8);
+
+    if (fileVersion != 1 && fileVersion != version)
+        throw std::runtime_error("RunArchive: unsupported version");
+
+    auto size = get<std::uint32_t>(bytes, 12);
+    std::size_t p = 16;
+
+    // Every field must lie inside the payload, and the payload inside the file.
+    std::size_t end = 16 + std::size_t(size);
+
+    if (end > bytes.size())
+        throw std::runtime_error("RunArchive: truncated header");
+
+    auto need = [&](std::size_t n) {
+        if (n > end - p)
+            throw std::runtime_error("RunArchive: truncated header");
+    };
+
+    auto next = [&]() { need(4); auto v = get<std::int32_t>(bytes, p); p += 4; return v; };
+
+    auto& h = archiveHeader;
+    h.mode = next();
+    h.parameters.secondsPerTube = next();
+    h.parameters.tubesPerChannel = next();
+    h.parameters.timeForTestingVoltage = next();
+
+    auto nextConfiguration = [&]() {
+        TestConfiguration c;
+        c.testVoltage = next();
+        c.currentLimit = next();
+        c.maxVoltage = next();
+        c.rampUpRate = next();
+        c.rampDownRate = next();
+        c.overCurrentLimit = next();
+        c.powerDownMethod = next();
+        return c;
+    };
+
+    TestConfiguration shared;
+
+    if (fileVersion == 1)
+        shared = nextConfiguration();
+
+    need(4);
+    auto channels = get<std::uint32_t>(bytes, p);
+    p += 4;
+
+    need(std::size_t(channels) * ((fileVersion == 1) ? 4 : 32));
+
+    for (std::uint32_t i = 0; i < channels; ++i)
+    {
+        h.channels.push_back(next());
+        h.configurations.push_back((fileVersion == 1) ? shared : nextConfiguration());
+    }
+
+    need(8);
+    h.startTime = get<std::int64_t>(bytes, p);
+    p += 8;
+
+    need(4);
+    auto length = get<std::uint32_t>(bytes, p);
+    p += 4;
+
+    need(length);
+
+    h.runId.assign(reinterpret_cast<const char*>(bytes.data() + p), length);
+
+    firstBlock = 16 + size;
+}
+
+static bool readBlock(std::span<const std::uint8_t> bytes, std::size_t offset, ArchiveBlock& block, std::size_t& end)
+{
+    if (offset + blockHeaderSize > bytes.size())
+        return false;
+
+    if (std::memcmp(bytes.data() + offset, blockMagic, sizeof(blockMagic)) != 0)
+        return false;
+
+    block.channel = get<std::int32_t>(bytes, offset + 4);
+    block.index = get<std::int32_t>(bytes, offset + 8);
+    block.physicalTube = get<std::int32_t>(bytes, offset + 12);
+    block.samples = get<std::uint32_t>(bytes, offset + 16);
+    block.intrinsicCurrent = get<float>(bytes, offset + 20);
+
+    auto size = get<std::uint32_t>(bytes, offset + 24);
+    auto start = offset + blockHeaderSize;
+
+    if (start + size > bytes.size())
+        return false;
+
+    block.payload = bytes.subspan(start, size);
+    end = start + size;
+
+    return true;
+}
+
+bool RunArchive::readFooter()
+{
+    if (bytes.size() < firstBlock + footerTrailerSize)
+        return false;
+
+    auto trailer = bytes.size() - footerTrailerSize;
+
+    if (std::memcmp(bytes.data() + trailer + 12, footerMagic, sizeof(footerMagic)) != 0)
+        return false;
+
+    auto count = get<std::uint32_t>(bytes, trailer);
+    auto footer = get<std::uint64_t>(bytes, trailer + 4);
+
+    if (footer + std::uint64_t(count) * 8 != trailer)
+        return false;
+
+    archiveBlocks.resize(count);
+
+    for (std::uint32_t i = 0; i < count; ++i)
+    {
+        std::size_t end = 0;
+
+        if (!readBlock(bytes, get<std::uint64_t>(bytes, footer + i * 8), archiveBlocks[i], end))
+        {
+            archiveBlocks.clear();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void RunArchive::scanBlocks()
+{
+    std::size_t offset = firstBlock;
+    ArchiveBlock block;
+
+    // Stops at the first incomplete block, which is where the writer died.
+    while (readBlock(bytes, offset, block, offset))
+        archiveBlocks.push_back(block);
+}
+
+std::size_t RunArchive::sampleCount() const
+{
+    std::size_t count = 0;
+
+    for (const auto& block : archiveBlocks)
+        count += block.samples;
+
+    return count;
+}
+
+void RunArchive::decodeAll(SampleBuffer& buffer) const
+{
+    buffer.reserve(buffer.size() + sampleCount());
+
+    for (const auto& block : archiveBlocks)
+        decode(block, buffer);
+}
+
+void RunArchive::decode(const ArchiveBlock& block, SampleBuffer& buffer)
+{
+    auto payload = block.payload;
+
+    if (payload.size() < 8)
+        throw std::runtime_error("RunArchive: truncated block");
+
+    auto timeBytes = get<std::uint32_t>(payload, 0);
+    auto currentBytes = get<std::uint32_t>(payload, 4);
+
+    if (8 + std::size_t(timeBytes) + currentBytes > payload.size())
+        throw std::runtime_error("RunArchive: corrupt block");
+
+    const std::uint8_t* t = payload.data() + 8;
+    const std::uint8_t* tEnd = t + timeBytes;
+    const std::uint8_t* c = tEnd;
+    const std::uint8_t* cEnd = c + currentBytes;
+    const std::uint8_t* v = cEnd;
+    const std::uint8_t* vEnd = payload.data() + payload.size();
+
+    std::uint32_t time = 0;
+    std::uint32_t current = 0;
+    std::uint32_t voltage = 0;
+
+    for (std::uint32_t i = 0; i < block.samples; ++i)
+    {
+        time += static_cast<std::uint32_t>(getVarint(t, tEnd));
+        current += static_cast<std::uint32_t>(unzigzag(static_cast<std::uint32_t>(getVarint(c, cEnd))));
+        voltage += static_cast<std::uint32_t>(unzigzag(static_cast<std::uint32_t>(getVarint(v, vEnd))));
+
+        buffer.push_back(
+            block.channel,
+            block.index,
+            time / 1000.0f,
+            std::bit_cast<float>(current),
+            std::bit_cast<float>(voltage)
+        );
+    }
+}
@@ -0,0 +1,142 @@
+// RunArchive.hpp
+
+#pragma once
+
+#include <span>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <cstddef>
+
+#include <common/TestTypes.hpp>
+#include <analysis/SampleKernels.hpp>
+
+// A versioned binary file holding every sample of a run.
+//
+// Layout (all integers little-endian):
+//
+//  header  "DCCSRUN\0", u16 version, u16 reserved, u32 payload size, payload
+//          (test parameters, each channel with its configuration, start time,
+//          run id)
+//  blocks  one per tube: "TUBE", i32 channel, i32 index, i32 physical tube,
+//          u32 samples, f32 intrinsic current, u32 payload size, payload
+//  footer  u64 offset of each block, u32 block count, u64 footer offset,
+//          "DCCSEND\0"
+//
+// A block payload holds three streams: the time since the tube was connected
+// in milliseconds, the current and the voltage. Times are delta coded; the
+// floats are coded as the difference of their bit patterns from the previous
+// sample. Each difference is zigzag mapped and written as a varint, so slowly
+// changing values take one or two bytes instead of four.
+//
+// Blocks are written as soon as a tube is finished, so a crashed run keeps all
+// completed tubes. The footer is only written on close; without it the reader
+// falls back to walking the blocks.
+//
+// Version 1 files hold a single configuration for the whole run, before the
+// channels. They are still read, with that configuration given to every
+// channel.
+
+// configurations[k] is the configuration channels[k] was tested with; when
+// both polarities run together they differ from channel to channel.
+struct ArchiveHeader
+{
+    int mode { 0 };
+    TestParameters parameters;
+    std::vector<int> channels;
+    std::vector<TestConfiguration> configurations;
+    std::int64_t startTime { 0 };
+    std::string runId { "" };
+};
+
+struct ArchiveBlock
+{
+    int channel { -1 };
+    int index { -1 };
+    int physicalTube { -1 };
+    std::uint32_t samples { 0 };
+    float intrinsicCurrent { 0.00f };
+
+    // Points into the mapped file. Valid while the RunArchive is alive.
+    std::span<const std::uint8_t> payload;
+};
+
+class RunArchiveWriter
+{
+public:
+    RunArchiveWriter(const std::string& path, const ArchiveHeader& header);
+    ~RunArchiveWriter();
+
+    RunArchiveWriter(const RunArchiveWriter&) = delete;
+    RunArchiveWriter(RunArchiveWriter&&) = delete;
+
+    RunArchiveWriter& operator=(const RunArchiveWriter&) = delete;
+    RunArchiveWriter& operator=(RunArchiveWriter&&) = delete;
+
+    void beginTube(int channel, int index, int physicalTube, float intrinsicCurrent);
+    void addSample(int channel, float time, float current, float voltage);
+    void endTube(int channel);
+
+    // Writes any open tubes and the footer. Called by the destructor.
+    void close();
+
+private:
+    struct OpenTube;
+
+    OpenTube* find(int channel);
+    void write(const void* data, std::size_t size);
+
+private:
+    std::FILE* file;
+    std::uint64_t position;
+    std::vector<std::uint64_t> blockOffsets;
+    std::vector<std::unique_ptr<OpenTube>> open;
+};
+
+class RunArchive
+{
+public:
+    explicit RunArchive(const std::string& path);
+    ~RunArchive();
+
+    RunArchive(const RunArchive&) = delete;
+    RunArchive(RunArchive&&) = delete;
+
+    RunArchive& operator=(const RunArchive&) = delete;
+    RunArchive& operator=(RunArchive&&) = delete;
+
+    const ArchiveHeader& header() const;
+    std::span<const ArchiveBlock> blocks() const;
+
+    // False if the run did not finish and the blocks were found by walking.
+    bool complete() const;
+
+    // Samples over every block.
+    std::size_t sampleCount() const;
+
+    // Appends the samples of a block to a structure-of-arrays buffer. It does
+    // not reserve, so decoding block after block into one buffer grows it
+    // geometrically; reserve sampleCount() up front to grow it only once.
+    static void decode(const ArchiveBlock& block, SampleBuffer& buffer);
+
+    // Appends the samples of every block, reserving for them all first.
+    void decodeAll(SampleBuffer& buffer) const;
+
+private:
+    struct Mapping;
+
+    void parseHeader();
+    bool readFooter();
+    void scanBlocks();
+
+private:
+    std::unique_ptr<Mapping> mapping;
+    std::span<const std::uint8_t> bytes;
+
+    ArchiveHeader archiveHeader;
+    std::vector<ArchiveBlock> archiveBlocks;
+    std::size_t firstBlock;
+    bool hasFooter;
+};
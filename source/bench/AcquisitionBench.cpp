@@ -0,0 +1,268 @@
+// AcquisitionBench.cpp
+//
+// Cost of each layer of the acquisition stack against FakeHV and a virtual
+// DCCH board, from single supply calls up to a whole 32 tube run. The run
+// goes on a virtual clock, with FakeHV ramping on the same clock, so it takes
+// as long as the code does rather than the half hour it would on the bench.
+// The output is JSON whose keys and order do not change, so that two commits
+// can be compared with a diff or a script. Usage: dccs_bench [repetitions]
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <functional>
+
+#include <QMutex>
+
+#include <fmt/core.h>
+
+#include <spdlog/spdlog.h>
+
+#include <psu/HVInterface.hpp>
+#include <psu/PSUController.hpp>
+
+#include <gui/TestInfo.hpp>
+#include <gui/RunReport.hpp>
+#include <gui/CollectionModel.hpp>
+#include <gui/DCCHController.hpp>
+#include <gui/TestController.hpp>
+
+#include <results/ResultsWriter.hpp>
+
+#include <instrumentation/Clock.hpp>
+
+#include <psu/FakeHV/FakeHVLibrary.h>
+
+using Clock = std::chrono::steady_clock;
+
+namespace fs = std::filesystem;
+
+static instrumentation::VirtualClock virtualClock;
+
+struct Result
+{
+    std::string name;
+    int iterations;
+    double nanoseconds;
+};
+
+static Result measure(std::string name, int iterations, const std::function<void(int)>& operation)
+{
+    // One untimed pass to warm the caches and set up the loggers.
+    operation(0);
+
+    auto start = Clock::now();
+
+    for (int i = 0; i < iterations; ++i)
+        operation(i);
+
+    std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+    return { std::move(name), iterations, elapsed.count() / iterations };
+}
+
+static msu_smdt::Port virtualSupply()
+{
+    msu_smdt::Port port;
+    port.port = "VIRTUAL";
+    port.baud_rate = "9600";
+    port.data_bit = "8";
+    port.stop_bit = "0";
+    port.parity = "0";
+    port.lbusaddress = "0";
+    return port;
+}
+
+int main(int argc, char** argv)
+{
+    int repetitions = (argc > 1) ? std::stoi(argv[1]) : 10000;
+
+    // The output is the JSON alone.
+    spdlog::set_level(spdlog::level::off);
+
+    std::vector<Result> results;
+    ChannelSet channels { 0, 1, 2, 3 };
+    std::array<float, 4> values;
+
+    {
+        HVInterface hv;
+        hv.connectToPSU(virtualSupply());
+
+        results.push_back(measure("hv_get_vmon_4ch", repetitions, [&](int) {
+            hv.get<hv::VMon>(channels, std::span(values), false);
+        }));
+
+        results.push_back(measure("hv_get_vset_4ch_cached", repetitions, [&](int) {
+            hv.get<hv::VSet>(channels, std::span(values));
+        }));
+
+        results.push_back(measure("hv_set_vset_4ch", repetitions, [&](int i) {
+            hv.set<hv::VSet>(static_cast<float>(1000 + i % 2), channels);
+        }));
+
+        hv.disconnectFromPSU();
+    }
+
+    {
+        PSUController controller;
+        controller.connectToPSU(virtualSupply());
+
+        // Alternating values, so that every call reaches the supply.
+        results.push_back(measure("psu_apply_configuration_4ch", repetitions / 10, [&](int i) {
+            float step = static_cast<float>(i % 2);
+
+            controller.setTestVoltages(channels, 3000 + step);
+            controller.setMaxVoltages(channels, 3500 + step);
+            controller.setRampUpRate(channels, 100 + step);
+            controller.setRampDownRate(channels, 100 + step);
+            controller.setOverCurrentLimits(channels, 10 + step);
+            controller.killChannelsAfterTest(channels, i % 2);
+        }));
+
+        std::array<float, 4> voltages;
+        std::array<float, 4> currents;
+        std::array<unsigned long, 4> statuses;
+
+        results.push_back(measure("psu_poll_4ch", repetitions, [&](int) {
+            controller.readCurrents(channels, std::span(currents));
+            controller.readVoltages(channels, std::span(voltages));
+            controller.readStatuses(channels, std::span(statuses));
+        }));
+
+        controller.disconnectFromPSU();
+    }
+
+    {
+        std::size_t length = 0;
+
+        results.push_back(measure("interpret_status", repetitions, [&](int i) {
+            length += interpretStatus(static_cast<unsigned long>(i) & 0xFFF).size();
+        }));
+    }
+
+    {
+        TestParameters parameters;
+        parameters.tubesPerChannel = 24;
+
+        CollectionModel model(nullptr, parameters);
+        model.setChannels({ 0, 1, 2, 3 });
+
+        TubeData data;
+        data.isActive = true;
+
+        results.push_back(measure("collection_model_update", repetitions, [&](int i) {
+            data.channel = i % 4;
+            data.index = (i / 4) % parameters.tubesPerChannel;
+            data.current = 1E-3f * (i % 7);
+            data.statistics.update(data.current, i);
+            model.storeTubeDataPacket(data);
+        }));
+    }
+
+    {
+        auto directory = fs::temp_directory_path() / "dccs_bench_results";
+        fs::remove_all(directory);
+        fs::create_directories(directory);
+
+        ResultsWriter writer(directory.string());
+
+        results.push_back(measure("results_write_32_tubes", 20, [&](int i) {
+            std::vector<ResultRecord> records(32);
+
+            for (int k = 0; k < 32; ++k)
+            {
+                records[k].barcode = fmt::format("MSU{:05}", k);
+                records[k].date = "01_01_2024_00_00_00";
+                records[k].runId = fmt::format("{}", i);
+                records[k].data.channel = k / 8;
+                records[k].data.index = k % 8;
+            }
+
+            writer.submit(std::move(records));
+            writer.flush();
+        }));
+
+        fs::remove_all(directory);
+    }
+
+    // Four channels of eight tubes, sampled for thirty simulated seconds each.
+    RunReport report;
+    double runSeconds = 0.00;
+
+    {
+        FakeHV_SetTimeSource([] { return virtualClock.seconds(); });
+
+        PSUController controller;
+        controller.connectToPSU(virtualSupply());
+
+        TestParameters parameters;
+        parameters.secondsPerTube = 30;
+        parameters.tubesPerChannel = 8;
+        parameters.timeForTestingVoltage = 0;
+
+        TestConfiguration configuration;
+        configuration.testVoltage = 100;
+        configuration.maxVoltage = 200;
+        configuration.rampUpRate = 500;
+        configuration.rampDownRate = 500;
+
+        msu_smdt::Port board = virtualSupply();
+        board.port = virtualPort;
+
+        QMutex mutex;
+        Test test;
+        test.setClock(&virtualClock);
+
+        QObject::connect(&test, &Test::distributeRunReport, [&report](RunReport r) { report = r; });
+
+        auto start = Clock::now();
+        test.test(false, &mutex, board, &controller, { 0, 1, 2, 3 }, parameters, std::vector<TestConfiguration>(4, configuration));
+        std::chrono::duration<double> elapsed = Clock::now() - start;
+        runSeconds = elapsed.count();
+
+        controller.disconnectFromPSU();
+        FakeHV_SetTimeSource(nullptr);
+    }
+
+    fmt::print("{{\n");
+    fmt::print("  \"repetitions\": {},\n", repetitions);
+    fmt::print("  \"results\": [\n");
+
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        fmt::print(
+            "    {{ \"benchmark\": \"{}\", \"iterations\": {}, \"ns_per_op\": {:.1f}, \"ops_per_s\": {:.1f} }},\n",
+            results[i].name,
+            results[i].iterations,
+            results[i].nanoseconds,
+            1E9 / results[i].nanoseconds
+        );
+    }
+
+    fmt::print(
+        "    {{ \"benchmark\": \"full_run_32_tubes\", \"iterations\": 1, \"ns_per_op\": {:.1f}, \"ops_per_s\": {:.6f} }}\n",
+        runSeconds * 1E9,
+        1.00 / runSeconds
+    );
+
+    fmt::print("  ],\n");
+    fmt::print("  \"full_run\": {{\n");
+    fmt::print("    \"seconds\": {:.3f},\n", runSeconds);
+    fmt::print("    \"simulated_seconds\": {:.3f},\n", report.totalSeconds);
+    fmt::print("    \"tubes\": {},\n", report.tubesTested);
+    fmt::print("    \"tubes_per_hour\": {:.1f},\n", report.tubesPerHour());
+
+    fmt::print("    \"ramping_seconds\": {:.3f},\n", report.seconds(RunReport::Phase::Ramping));
+    fmt::print("    \"switching_seconds\": {:.3f},\n", report.seconds(RunReport::Phase::Switching));
+    fmt::print("    \"waiting_seconds\": {:.3f},\n", report.seconds(RunReport::Phase::Waiting));
+    fmt::print("    \"sampling_seconds\": {:.3f},\n", report.seconds(RunReport::Phase::Sampling));
+    fmt::print("    \"idle_seconds\": {:.3f},\n", report.seconds(RunReport::Phase::Idle));
+
+    fmt::print("    \"collect_mean_ms\": {:.4f},\n", report.collectMean);
+    fmt::print("    \"collect_p99_ms\": {:.4f},\n", report.collectP99);
+    fmt::print("    \"fewest_samples\": {}\n", report.fewestSamples());
+    fmt::print("  }}\n}}\n");
+
+    return 0;
+}
@@ -0,0 +1,237 @@
+// GuiStress.cpp
+//
+// Feeds the channel and status widgets synthetic tube data from a worker
+// thread, the way a test does, but at rates and channel counts far above a
+// real station, and measures how the GUI keeps up: how long a packet waits
+// in the event loop before it is handled, how long a frame of the whole
+// window takes to paint, and how much the process grows while it runs. Runs
+// offscreen unless QT_QPA_PLATFORM says otherwise, so it needs no display.
+// Prints JSON like dccs_bench. Usage: gui_stress [channels] [hz per channel] [seconds]
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstddef>
+#include <algorithm>
+
+#include <QTimer>
+#include <QWidget>
+#include <QVBoxLayout>
+#include <QApplication>
+
+#include <fmt/core.h>
+
+#include <spdlog/spdlog.h>
+
+#include <gui/TestInfo.hpp>
+#include <gui/ChannelWidget.hpp>
+#include <gui/TestStatusWidget.hpp>
+
+#include <instrumentation/LatencyHistogram.hpp>
+
+#if defined(__linux__)
+    #include <unistd.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+// Resident set size in KiB, or -1 where it cannot be read.
+static long residentKiB()
+{
+#if defined(__linux__)
+    long pages = 0;
+    long resident = 0;
+
+    std::FILE* file = std::fopen("/proc/self/statm", "r");
+
+    if (!file)
+        return -1;
+
+    int read = std::fscanf(file, "%ld %ld", &pages, &resident);
+    std::fclose(file);
+
+    return (read == 2) ? resident * (sysconf(_SC_PAGESIZE) / 1024) : -1;
+#else
+    return -1;
+#endif
+}
+
+static void printSummary(const char* name, const LatencySummary& s, bool last = false)
+{
+    fmt::print(
+        "    \"{}\": {{ \"count\": {}, \"mean_us\": {:.1f}, \"p50_us\": {:.1f}, \"p90_us\": {:.1f}, \"p99_us\": {:.1f}, \"max_us\": {:.1f} }}{}\n",
+        name,
+        s.count,
+        s.mean / 1E3,
+        s.p50 / 1E3,
+        s.p90 / 1E3,
+        s.p99 / 1E3,
+        s.max / 1E3,
+        last ? "" : ","
+    );
+}
+
+int main(int argc, char** argv)
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication application(argc, argv);
+
+    int channelCount = (argc > 1) ? std::stoi(argv[1]) : 16;
+    int rate = (argc > 2) ? std::max(std::stoi(argv[2]), 1) : 1000;
+    int seconds = (argc > 3) ? std::stoi(argv[3]) : 10;
+
+    // The output is the JSON alone.
+    spdlog::set_level(spdlog::level::off);
+
+    TestParameters parameters;
+    parameters.tubesPerChannel = 24;
+
+    std::vector<int> channels(channelCount);
+
+    for (int k = 0; k < channelCount; ++k)
+        channels[k] = k;
+
+    QWidget window;
+    auto channelWidget = new ChannelWidget(nullptr, parameters);
+    auto statusWidget = new TestStatusWidget;
+
+    channelWidget->setTestParameters(parameters);
+    channelWidget->setChannels(channels);
+    channelWidget->setAvailableChannels(channels);
+
+    QVBoxLayout* layout = new QVBoxLayout;
+    layout->addWidget(channelWidget, 4);
+    layout->addWidget(statusWidget, 1);
+    window.setLayout(layout);
+    window.resize(1280, 960);
+    window.show();
+
+    statusWidget->updateConnectionStatus(true);
+    statusWidget->startTime();
+
+    LatencyHistogram eventLoop;
+    LatencyHistogram frames;
+
+    std::atomic<long> sent { 0 };
+    std::atomic<long> handled { 0 };
+    std::atomic<bool> stop { false };
+
+    // Painting the window into a pixmap at 60 Hz stands in for the frames a
+    // screen would show, and costs what they would.
+    QTimer frameTimer;
+    QObject::connect(&frameTimer, &QTimer::timeout, [&window, &frames] {
+        auto start = Clock::now();
+        window.grab();
+        frames.record(Clock::now() - start);
+    });
+    frameTimer.start(16);
+
+    // Packets go out in one millisecond batches, each channel moving to its
+    // next tube every second, and every packet is queued to the GUI thread as
+    // a signal from the test thread would be.
+    std::thread producer([&] {
+        double perTick = rate / 1000.00;
+        double owed = 0.00;
+        long sample = 0;
+        auto next = Clock::now();
+
+        std::vector<TubeData> data(channelCount);
+
+        while (!stop.load(std::memory_order_relaxed))
+        {
+            next += std::chrono::milliseconds(1);
+            owed += perTick;
+
+            for (; owed >= 1.00; owed -= 1.00, ++sample)
+            {
+                for (int k = 0; k < channelCount; ++k)
+                {
+                    auto& d = data[k];
+                    d.channel = channels[k];
+                    d.index = static_cast<int>((sample / rate) % parameters.tubesPerChannel);
+                    d.isActive = true;
+                    d.voltage = 3015.00f;
+                    d.current = 0.10f + 0.01f * static_cast<float>(sample % 7);
+                    d.intrinsicCurrent = 0.05f;
+                    d.statistics.update(d.current, static_cast<double>(sample) / rate);
+
+                    auto posted = Clock::now();
+                    sent.fetch_add(1, std::memory_order_relaxed);
+
+                    QMetaObject::invokeMethod(channelWidget, [=, &eventLoop, &handled] {
+                        channelWidget->receiveTubeDataPacket(d);
+                        channelWidget->receiveChannelStatus(d.channel, "ON");
+                        statusWidget->receiveTimeRemaining(fmt::format("{} s", d.index));
+                        eventLoop.record(Clock::now() - posted);
+                        handled.fetch_add(1, std::memory_order_relaxed);
+                    }, Qt::QueuedConnection);
+                }
+            }
+
+            std::this_thread::sleep_until(next);
+        }
+    });
+
+    // Memory is measured from after the first second, once the models and
+    // the paint caches have settled.
+    long residentStart = -1;
+    long residentPeak = -1;
+    long backlog = 0;
+
+    QTimer memoryTimer;
+    QObject::connect(&memoryTimer, &QTimer::timeout, [&] {
+        long resident = residentKiB();
+
+        if (residentStart < 0)
+            residentStart = resident;
+
+        residentPeak = std::max(residentPeak, resident);
+    });
+
+    QTimer::singleShot(1000, [&] { memoryTimer.start(250); });
+
+    QTimer::singleShot(seconds * 1000, [&] {
+        stop = true;
+        producer.join();
+
+        frameTimer.stop();
+        memoryTimer.stop();
+        backlog = sent - handled;
+
+        application.quit();
+    });
+
+    auto start = Clock::now();
+    application.exec();
+    std::chrono::duration<double> elapsed = Clock::now() - start;
+
+    // Whatever was still queued is handled before the totals are taken.
+    QCoreApplication::processEvents();
+    long residentEnd = residentKiB();
+
+    fmt::print("{{\n");
+    fmt::print("  \"channels\": {},\n", channelCount);
+    fmt::print("  \"hz_per_channel\": {},\n", rate);
+    fmt::print("  \"seconds\": {:.3f},\n", elapsed.count());
+    fmt::print("  \"packets_sent\": {},\n", sent.load());
+    fmt::print("  \"packets_handled\": {},\n", handled.load());
+    fmt::print("  \"packets_per_s\": {:.1f},\n", handled.load() / elapsed.count());
+    fmt::print("  \"backlog_at_stop\": {},\n", backlog);
+    fmt::print("  \"latency\": {{\n");
+    printSummary("event_loop", eventLoop.summary());
+    printSummary("frame", frames.summary(), true);
+    fmt::print("  }},\n");
+    fmt::print("  \"memory_kib\": {{\n");
+    fmt::print("    \"start\": {},\n", residentStart);
+    fmt::print("    \"peak\": {},\n", residentPeak);
+    fmt::print("    \"end\": {},\n", residentEnd);
+    fmt::print("    \"growth\": {}\n", (residentStart < 0 || residentEnd < 0) ? 0 : residentEnd - residentStart);
+    fmt::print("  }}\n}}\n");
+
+    return 0;
+}
@@ -0,0 +1,113 @@
+// KernelBench.cpp
+//
+// Throughput of the sample post-processing kernels, vectorised against the
+// scalar reference. Usage: kernel_bench [samples] [repetitions]
+
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <functional>
+
+#include <fmt/core.h>
+
+#include <analysis/SampleKernels.hpp>
+
+using Clock = std::chrono::steady_clock;
+
+static double measure(int repetitions, const std::function<void()>& kernel)
+{
+    // One untimed pass to fault in the pages.
+    kernel();
+
+    auto start = Clock::now();
+
+    for (int r = 0; r < repetitions; ++r)
+        kernel();
+
+    std::chrono::duration<double, std::nano> elapsed = Clock::now() - start;
+    return elapsed.count() / repetitions;
+}
+
+int main(int argc, char** argv)
+{
+    std::size_t samples = (argc > 1) ? std::stoul(argv[1]) : 4'000'000;
+    int repetitions = (argc > 2) ? std::stoi(argv[2]) : 20;
+
+    std::mt19937 generator(42);
+    std::normal_distribution<float> noise(1.50f, 0.25f);
+
+    std::vector<float> source(samples);
+    std::vector<float> offsets(samples);
+    std::vector<std::uint8_t> mask(samples);
+
+    for (auto& v : source)
+        v = noise(generator) * 1E-3f;
+
+    for (auto& v : offsets)
+        v = noise(generator) * 0.1f;
+
+    std::vector<float> work = source;
+
+    struct Kernel
+    {
+        std::string name;
+        std::function<void()> vectorised;
+        std::function<void()> scalar;
+    };
+
+    std::vector<Kernel> kernels = {
+        {
+            "scale",
+            [&]() { SampleKernels::scale(work, 1E3f); },
+            [&]() { SampleKernels::scalar::scale(work, 1E3f); }
+        },
+        {
+            "subtract_offsets",
+            [&]() { SampleKernels::subtractOffsets(work, offsets); },
+            [&]() { SampleKernels::scalar::subtractOffsets(work, offsets); }
+        },
+        {
+            "statistics",
+            [&]() { SampleKernels::statistics(source); },
+            [&]() { SampleKernels::scalar::statistics(source); }
+        },
+        {
+            "threshold_mask",
+            [&]() { SampleKernels::thresholdMask(source, 1.5E-3f, mask); },
+            [&]() { SampleKernels::scalar::thresholdMask(source, 1.5E-3f, mask); }
+        }
+    };
+
+    auto a = SampleKernels::statistics(source);
+    auto b = SampleKernels::scalar::statistics(source);
+
+    fmt::print("{{\n");
+    fmt::print("  \"implementation\": \"{}\",\n", SampleKernels::implementation());
+    fmt::print("  \"samples\": {},\n", samples);
+    fmt::print("  \"repetitions\": {},\n", repetitions);
+    fmt::print("  \"statistics_mean_difference\": {:.3e},\n", a.mean - b.mean);
+    fmt::print("  \"results\": [\n");
+
+    for (std::size_t i = 0; i < kernels.size(); ++i)
+    {
+        double vectorised = measure(repetitions, kernels[i].vectorised);
+        double scalar = measure(repetitions, kernels[i].scalar);
+
+        fmt::print(
+            "    {{ \"kernel\": \"{}\", \"ns_per_sample\": {:.4f}, \"scalar_ns_per_sample\": {:.4f}, "
+            "\"msamples_per_s\": {:.1f}, \"speedup\": {:.2f} }}{}\n",
+            kernels[i].name,
+            vectorised / samples,
+            scalar / samples,
+            samples / vectorised * 1E3,
+            scalar / vectorised,
+            (i + 1 < kernels.size()) ? "," : ""
+        );
+    }
+
+    fmt::print("  ]\n}}\n");
+
+    return 0;
+}
@@ -0,0 +1,314 @@
+/***********************************************************************************************************************
+ *  File:           cli/main.cpp
+ * 
+ *  Purpose:        Headless test runner. Loads a configuration file, connects to the PSU and the DCCH board, runs a
+ *                  single normal or reverse test and writes the results, all without loading any widgets. Given a
+ *                  stations file instead, it runs every station listed there side by side from this one process.
+ * 
+ *  Usage:          dccs-cli --config <file> [--barcodes <file>|-] [--mode normal|reverse|all] [--user <name>]
+ *                           [--duration <seconds>]
+ *                  dccs-cli --stations <file> [--mode normal|reverse|all] [--user <name>] [--duration <seconds>]
+ * 
+ *                  Barcodes are read one per line. A line holding only a barcode fills the next tube; a line of the
+ *                  form "<tube> <barcode>" names the physical tube explicitly. Blank lines and lines starting with '#'
+ *                  are skipped. A reverse test runs until --duration elapses or the process is interrupted. The
+ *                  "all" mode tests the normal and reverse channels together, numbering the reverse channels' tubes
+ *                  after the normal ones. In a stations file every station may set its own barcodes file and mode;
+ *                  --mode is the default for those that do not.
+ **********************************************************************************************************************/
+
+#include <map>
+#include <atomic>
+#include <charconv>
+#include <optional>
+#include <csignal>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+#include <QTimer>
+#include <QCoreApplication>
+
+#include <fmt/core.h>
+
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#include <gui/TestInfo.hpp>
+#include <gui/Configuration.hpp>
+#include <gui/Orchestrator.hpp>
+
+static std::atomic<bool> interrupted { false };
+
+static void onInterrupt(int)
+{
+    interrupted = true;
+}
+
+static void usage()
+{
+    fmt::print(stderr,
+        "usage: dccs-cli --config <file> [--barcodes <file>|-] [--mode normal|reverse|all]\n"
+        "                [--user <name>] [--duration <seconds>]\n"
+        "       dccs-cli --stations <file> [--mode normal|reverse|all]\n"
+        "                [--user <name>] [--duration <seconds>]\n"
+    );
+}
+
+// The whole of `text` as a non-negative integer, or nothing.
+static std::optional<int> parseCount(const std::string& text)
+{
+    int value = 0;
+    auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+
+    if (error != std::errc() || end != text.data() + text.size() || value < 0)
+        return std::nullopt;
+
+    return value;
+}
+
+// Maps physical tube numbers to barcodes. A line that is neither a barcode
+// nor a tube number and a barcode is logged, and nothing is returned.
+static std::optional<std::map<int, std::string>> readBarcodes(
+    std::istream& in,
+    const std::string& file,
+    std::shared_ptr<spdlog::logger> logger
+)
+{
+    std::map<int, std::string> barcodes;
+    std::string line;
+    int next = 0;
+    int number = 0;
+
+    while (std::getline(in, line))
+    {
+        ++number;
+
+        std::istringstream tokens(line);
+        std::string first;
+        std::string second;
+        std::string rest;
+
+        if (!(tokens >> first) || first[0] == '#')
+            continue;
+
+        if (tokens >> second)
+        {
+            auto tube = parseCount(first);
+
+            if (!tube || tokens >> rest)
+            {
+                logger->error("{}:{}: expected \"<barcode>\" or \"<tube> <barcode>\", got \"{}\"", file, number, line);
+                return std::nullopt;
+            }
+
+            next = *tube;
+            first = second;
+        }
+
+        barcodes[next++] = first;
+    }
+
+    return barcodes;
+}
+
+static std::optional<StationMode> parseMode(const std::string& value)
+{
+    if (value == "normal")
+        return StationMode::Normal;
+    if (value == "reverse")
+        return StationMode::Reverse;
+    if (value == "all")
+        return StationMode::All;
+
+    return std::nullopt;
+}
+
+static std::optional<std::map<int, std::string>> loadBarcodes(const std::string& file, std::shared_ptr<spdlog::logger> logger)
+{
+    if (file.empty())
+        return std::map<int, std::string>();
+
+    if (file == "-")
+        return readBarcodes(std::cin, "<stdin>", logger);
+
+    std::ifstream in(file);
+
+    if (!in)
+    {
+        logger->error("Cannot open {}", file);
+        return std::nullopt;
+    }
+
+    return readBarcodes(in, file, logger);
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+
+    spdlog::set_level(spdlog::level::info);
+    spdlog::set_pattern("[%Y-%m-%d %H:%M:%S] [%=16n] %^[%=8l]%$ %v");
+
+    auto logger = spdlog::stdout_color_mt("CLI");
+
+    std::string configFile;
+    std::string stationsFile;
+    std::string barcodeFile;
+    std::string user;
+    StationMode mode = StationMode::Normal;
+    int duration = 0;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if (arg == "--config" && hasValue)
+            configFile = argv[++i];
+        else if (arg == "--stations" && hasValue)
+            stationsFile = argv[++i];
+        else if (arg == "--barcodes" && hasValue)
+            barcodeFile = argv[++i];
+        else if (arg == "--user" && hasValue)
+            user = argv[++i];
+        else if (arg == "--mode" && hasValue && parseMode(argv[i + 1]))
+            mode = *parseMode(argv[++i]);
+        else if (arg == "--duration" && hasValue)
+        {
+            auto seconds = parseCount(argv[++i]);
+
+            if (!seconds)
+            {
+                fmt::print(stderr, "--duration takes a whole number of seconds, not '{}'\n", argv[i]);
+                usage();
+                return 2;
+            }
+
+            duration = *seconds;
+        }
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+
+    if (configFile.empty() == stationsFile.empty())
+    {
+        usage();
+        return 2;
+    }
+
+    std::vector<StationEntry> entries;
+
+    if (!stationsFile.empty())
+    {
+        auto stations = readStations(stationsFile);
+
+        if (!stations || stations->empty())
+            return 1;
+
+        entries = *stations;
+    }
+    else
+    {
+        entries.push_back({ "station", configFile, barcodeFile, "" });
+    }
+
+    Orchestrator orchestrator;
+    orchestrator.setUser(user);
+
+    QObject::connect(
+        &orchestrator,
+        &Orchestrator::alert,
+        &app,
+        [logger](std::string station, std::string message) {
+            logger->error("{}: {}", station, message);
+        }
+    );
+
+    std::vector<std::pair<std::string, StationMode>> runs;
+
+    for (const auto& entry : entries)
+    {
+        auto configuration = readConfiguration(entry.configFile);
+
+        if (!configuration)
+            return 1;
+
+        auto barcodes = loadBarcodes(entry.barcodesFile, logger);
+
+        if (!barcodes)
+            return 1;
+
+        auto stationMode = entry.mode.empty() ? std::optional(mode) : parseMode(entry.mode);
+
+        if (!stationMode)
+        {
+            logger->error("{}: unknown mode {}", entry.name, entry.mode);
+            return 1;
+        }
+
+        if (!orchestrator.addStation(entry.name, *configuration))
+            return 1;
+
+        orchestrator.setBarcodes(entry.name, std::move(*barcodes));
+        runs.push_back({ entry.name, *stationMode });
+    }
+
+    QObject::connect(
+        &orchestrator,
+        &Orchestrator::stationFinished,
+        &app,
+        [logger](std::string station, std::size_t results) {
+            logger->info("{}: wrote results for {} tubes", station, results);
+        }
+    );
+
+    QObject::connect(
+        &orchestrator,
+        &Orchestrator::runReport,
+        &app,
+        [logger](std::string station, RunReport report) {
+            logger->info("{}: {:.1f} tubes per hour, collectData p99 {:.2f} ms", station, report.tubesPerHour(), report.collectP99);
+        }
+    );
+
+    QObject::connect(&orchestrator, &Orchestrator::allFinished, &app, &QCoreApplication::quit);
+
+    std::signal(SIGINT, onInterrupt);
+    std::signal(SIGTERM, onInterrupt);
+
+    QTimer poll;
+    QObject::connect(
+        &poll,
+        &QTimer::timeout,
+        &app,
+        [&orchestrator]() {
+            if (interrupted.exchange(false))
+                orchestrator.stopAll();
+        }
+    );
+    poll.start(200);
+
+    // Reverse tests run until they are stopped.
+    if (duration > 0)
+    {
+        QTimer::singleShot(duration * 1000, &app, [&orchestrator, &runs]() {
+            for (const auto& [name, stationMode] : runs)
+            {
+                if (stationMode == StationMode::Reverse)
+                    orchestrator.stop(name);
+            }
+        });
+    }
+
+    for (const auto& [name, stationMode] : runs)
+    {
+        if (!orchestrator.start(name, stationMode))
+            return 1;
+    }
+
+    return app.exec();
+}
@@ -0,0 +1,111 @@
+// TestTypes.hpp
+
+#pragma once
+
+#include <cmath>
+#include <limits>
+
+// What a test is run with and what it measures, shared by the station, the
+// results and the archive. Plain structs with no dependency on Qt.
+
+// Streaming statistics of the samples taken for a single tube. Everything is
+// accumulated with Welford's method, so only a handful of values are kept no
+// matter how long the tube is sampled. The slope is the least-squares slope of
+// the current against the time (in seconds) since the tube was connected.
+struct TubeStatistics
+{
+    int count { 0 };
+    double mean { 0.00 };
+    double m2 { 0.00 };
+    double min { std::numeric_limits<double>::quiet_NaN() };
+    double max { std::numeric_limits<double>::quiet_NaN() };
+
+    double meanTime { 0.00 };
+    double m2Time { 0.00 };
+    double coMoment { 0.00 };
+
+    void reset()
+    {
+        *this = TubeStatistics();
+    }
+
+    void update(double value, double time)
+    {
+        ++count;
+
+        double deltaValue = value - mean;
+        double deltaTime = time - meanTime;
+
+        mean += deltaValue / count;
+        meanTime += deltaTime / count;
+
+        m2 += deltaValue * (value - mean);
+        m2Time += deltaTime * (time - meanTime);
+        coMoment += deltaTime * (value - mean);
+
+        if (count == 1 || value < min)
+            min = value;
+
+        if (count == 1 || value > max)
+            max = value;
+    }
+
+    double variance() const
+    {
+        return (count > 1) ? m2 / (count - 1) : 0.00;
+    }
+
+    double standardDeviation() const
+    {
+        return std::sqrt(variance());
+    }
+
+    double slope() const
+    {
+        return (m2Time > 0.00) ? coMoment / m2Time : 0.00;
+    }
+};
+
+struct TubeData
+{
+    int index { -1 };
+    int channel { -1 };
+    bool isActive { false };
+    float current { -1.00 };
+    float voltage { -1.00 };
+    float intrinsicCurrent { -1.00 };
+    TubeStatistics statistics;
+};
+
+struct TestParameters
+{
+    int secondsPerTube { 1 };
+    int tubesPerChannel { 32 };
+    int timeForTestingVoltage { 1 };
+
+    // With every tube disconnected, measure the offsets again before every
+    // rebaselineEveryTubes-th tube, after waiting rebaselineSeconds for the
+    // channels to settle, as the mean of rebaselineReads reads a second
+    // apart. Zero turns it off.
+    int rebaselineEveryTubes { 0 };
+    int rebaselineSeconds { 5 };
+    int rebaselineReads { 5 };
+
+    // Cached offsets younger than calibrationMaxAgeHours are checked against
+    // a sample taken calibrationVerifySeconds after the ramp, and used if
+    // every channel is within calibrationTolerance of its cached offset.
+    int calibrationVerifySeconds { 5 };
+    int calibrationMaxAgeHours { 24 };
+    float calibrationTolerance { 2.00f };
+};
+
+struct TestConfiguration
+{
+    int testVoltage { 0 };
+    int currentLimit { 0 };
+    int maxVoltage { 1 };
+    int rampUpRate { 1 };
+    int rampDownRate { 1 };
+    int overCurrentLimit { 0 };
+    int powerDownMethod { 0 };
+};
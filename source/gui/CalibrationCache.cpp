@@ -0,0 +1,114 @@
+// CalibrationCache.cpp
+
+#include "CalibrationCache.hpp"
+
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+#include <filesystem>
+
+#include <nlohmann/json.hpp>
+
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+using json = nlohmann::json;
+
+namespace fs = std::filesystem;
+
+CalibrationCache::CalibrationCache(std::string directory):
+    path { (fs::path(directory) / "offsets.json").string() }
+{
+    try
+    {
+        logger = spdlog::stdout_color_mt("CalibrationCache");
+    }
+    catch (const spdlog::spdlog_ex& ex)
+    {
+        logger = spdlog::get("CalibrationCache");
+    }
+
+    std::ifstream in(path);
+
+    if (!in)
+        return;
+
+    try
+    {
+        json cache;
+        in >> cache;
+
+        for (const auto& entry : cache.at("offsets"))
+        {
+            offsets.push_back({
+                entry.at("channel").get<int>(),
+                entry.at("voltage").get<int>(),
+                entry.at("offset").get<float>(),
+                entry.at("measured").get<std::int64_t>()
+            });
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        logger->error("Cannot read the offset calibrations in {}, measuring them again: {}", path, ex.what());
+        offsets.clear();
+    }
+}
+
+std::optional<CalibratedOffset> CalibrationCache::find(int channel, int voltage) const
+{
+    auto it = std::find_if(
+        offsets.begin(),
+        offsets.end(),
+        [&](const auto& o) { return o.channel == channel && o.voltage == voltage; }
+    );
+
+    if (it == offsets.end())
+        return std::nullopt;
+
+    return *it;
+}
+
+void CalibrationCache::store(CalibratedOffset offset)
+{
+    auto it = std::find_if(
+        offsets.begin(),
+        offsets.end(),
+        [&](const auto& o) { return o.channel == offset.channel && o.voltage == offset.voltage; }
+    );
+
+    if (it == offsets.end())
+        offsets.push_back(offset);
+    else
+        *it = offset;
+}
+
+void CalibrationCache::save() const
+{
+    json entries = json::array();
+
+    for (const auto& o : offsets)
+    {
+        entries.push_back({
+            { "channel", o.channel },
+            { "voltage", o.voltage },
+            { "offset", o.offset },
+            { "measured", o.measured }
+        });
+    }
+
+    auto temporary = path + ".tmp";
+
+    {
+        std::ofstream out(temporary);
+
+        if (!out)
+            throw std::runtime_error("Cannot open " + temporary);
+
+        out << json { { "offsets", entries } }.dump(4);
+
+        if (!out)
+            throw std::runtime_error("Cannot write " + temporary);
+    }
+
+    fs::rename(temporary, path);
+}
@@ -0,0 +1,51 @@
+// CalibrationCache.hpp
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <optional>
+
+#include <spdlog/spdlog.h>
+
+// An offset measured with the full settling wait, for one channel at one
+// test voltage, and when it was measured in seconds since the epoch.
+struct CalibratedOffset
+{
+    int channel { -1 };
+    int voltage { 0 };
+    float offset { 0.00f };
+    std::int64_t measured { 0 };
+};
+
+// The intrinsic currents of a station from earlier runs, kept in
+// `<directory>/offsets.json`. A run whose channels all have a recent enough
+// entry checks them against a short sample instead of waiting the whole
+// settling time to measure them again. A missing or unreadable file is an
+// empty cache.
+class CalibrationCache
+{
+public:
+    explicit CalibrationCache(std::string directory);
+
+    CalibrationCache(const CalibrationCache&) = delete;
+    CalibrationCache(CalibrationCache&&) = delete;
+
+    CalibrationCache& operator=(const CalibrationCache&) = delete;
+    CalibrationCache& operator=(CalibrationCache&&) = delete;
+
+    std::optional<CalibratedOffset> find(int channel, int voltage) const;
+
+    // Replaces the entry for the channel and voltage, if there is one.
+    void store(CalibratedOffset offset);
+
+    // Rewrites the file through a temporary one. Throws if it cannot.
+    void save() const;
+
+private:
+    std::string path;
+    std::vector<CalibratedOffset> offsets;
+    std::shared_ptr<spdlog::logger> logger;
+};
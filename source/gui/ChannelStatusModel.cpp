@@ -0,0 +1,154 @@
+// ChannelStatusModel.cpp
+
+#include <utility>
+
+#include "ChannelStatusModel.hpp"
+
+ChannelStatusModel::ChannelStatusModel(QObject* parent):
+    QAbstractTableModel(parent)
+{}
+
+ChannelStatusModel::~ChannelStatusModel()
+{}
+
+int ChannelStatusModel::columnCount(const QModelIndex& parent) const
+{
+    Q_UNUSED(parent);
+    return ColumnCount;
+}
+
+QVariant ChannelStatusModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+
+    if (role == Qt::TextAlignmentRole)
+        return Qt::AlignCenter;
+
+    const auto& row = rows[index.row()];
+
+    if (role == Qt::DisplayRole)
+    {
+        switch (index.column())
+        {
+        case ChannelColumn:
+            return row.channel;
+        case PolarityColumn:
+            return QString::fromStdString(row.polarity);
+        case StatusColumn:
+            return QString::fromStdString(row.status);
+        case IntrinsicColumn:
+            return row.hasIntrinsicCurrent ? QVariant(row.intrinsicCurrent) : QVariant();
+        }
+    }
+
+    return QVariant();
+}
+
+QVariant ChannelStatusModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation == Qt::Horizontal && role == Qt::DisplayRole)
+    {
+        switch (section)
+        {
+        case ChannelColumn:
+            return "Channel";
+        case PolarityColumn:
+            return "Polarity";
+        case StatusColumn:
+            return "Status";
+        case IntrinsicColumn:
+            return "Intrinsic [nA]";
+        }
+    }
+
+    return QVariant();
+}
+
+int ChannelStatusModel::rowCount(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+        return 0;
+
+    return static_cast<int>(rows.size());
+}
+
+void ChannelStatusModel::setChannels(std::vector<int> channels)
+{
+    beginResetModel();
+
+    std::vector<Row> updated;
+    updated.reserve(channels.size());
+
+    // Keep what we already know about channels that are still present.
+    for (int channel : channels)
+    {
+        int row = rowFor(channel);
+
+        if (row >= 0)
+            updated.push_back(rows[row]);
+        else
+            updated.push_back(Row { channel });
+    }
+
+    rows = std::move(updated);
+    channelPositions.clear();
+
+    for (int k = 0; k < static_cast<int>(rows.size()); ++k)
+        channelPositions[rows[k].channel] = k;
+
+    endResetModel();
+}
+
+void ChannelStatusModel::setPolarity(int channel, int polarity)
+{
+    int row = rowFor(channel);
+
+    if (row < 0 || rows[row].polarity != "~")
+        return;
+
+    if (polarity > 0)
+        rows[row].polarity = "-";
+    else if (polarity == 0)
+        rows[row].polarity = "+";
+    else
+        return;
+
+    rowChanged(row, PolarityColumn);
+}
+
+void ChannelStatusModel::setStatus(int channel, const std::string& status)
+{
+    int row = rowFor(channel);
+
+    // The status arrives with every sample but rarely changes.
+    if (row < 0 || rows[row].status == status)
+        return;
+
+    rows[row].status = status;
+    rowChanged(row, StatusColumn);
+}
+
+void ChannelStatusModel::setIntrinsicCurrent(int channel, float current)
+{
+    int row = rowFor(channel);
+
+    if (row < 0)
+        return;
+
+    rows[row].intrinsicCurrent = current;
+    rows[row].hasIntrinsicCurrent = true;
+    rowChanged(row, IntrinsicColumn);
+}
+
+int ChannelStatusModel::rowFor(int channel) const
+{
+    auto it = channelPositions.find(channel);
+    return (it == channelPositions.end()) ? -1 : it->second;
+}
+
+void ChannelStatusModel::rowChanged(int row, int column)
+{
+    auto cell = index(row, column);
+    emit dataChanged(cell, cell);
+}
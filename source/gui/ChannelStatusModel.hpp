@@ -0,0 +1,57 @@
+// ChannelStatusModel.hpp
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <QAbstractTableModel>
+
+// One row per channel the power supply reports, so the status panel grows
+// with the crate map instead of with the number of widgets.
+class ChannelStatusModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column
+    {
+        ChannelColumn,
+        PolarityColumn,
+        StatusColumn,
+        IntrinsicColumn,
+        ColumnCount
+    };
+
+    explicit ChannelStatusModel(QObject* parent = nullptr);
+    ~ChannelStatusModel();
+
+    int columnCount(const QModelIndex& parent = QModelIndex()) const;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+    int rowCount(const QModelIndex& parent = QModelIndex()) const;
+
+    void setChannels(std::vector<int> channels);
+
+    void setPolarity(int channel, int polarity);
+    void setStatus(int channel, const std::string& status);
+    void setIntrinsicCurrent(int channel, float current);
+
+private:
+    struct Row
+    {
+        int channel;
+        std::string polarity { "~" };
+        std::string status;
+        float intrinsicCurrent { 0.0f };
+        bool hasIntrinsicCurrent { false };
+    };
+
+    int rowFor(int channel) const;
+    void rowChanged(int row, int column);
+
+private:
+    std::vector<Row> rows;
+    std::map<int, int> channelPositions;
+};
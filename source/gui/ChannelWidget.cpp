@@ -1,5 +1,8 @@
 #include <spdlog/sinks/stdout_color_sinks.h>
 
+#include <fmt/core.h>
+#include <fmt/ranges.h>
+
 #include <QHeaderView>
 #include <QGridLayout>
 #include <QVBoxLayout>
@@ -8,60 +11,82 @@
 
 ChannelWidget::ChannelWidget(QWidget* parent, TestParameters parameters):
     QWidget(parent),
-    polarity { "~" },
-    channelStatus { new QLabel },
     channelDataBox { new QGroupBox },
     channelStatusBox { new QGroupBox },
     dataView { new QTableView },
+    statusView { new QTableView },
     parameters { parameters }
 {
-    const char* msg = "ON | RUP | RDWN | OVC | OVV | UNV | MAXV | TRIP | OVP | OVT | DIS | KILL | ILK | NOCAL";
-    channelStatus->setText(msg);
-    channelStatus->setAlignment(Qt::AlignCenter);
-
-    name = "CH_ (" + polarity + ")";
+    try
+    {
+        logger = spdlog::stdout_color_mt("ChannelWidget");
+    }
+    catch (const spdlog::spdlog_ex& ex)
+    {
+        logger = spdlog::get("ChannelWidget");
+    }
 
-    channelDataBox->setTitle(QString::fromStdString(name + " - Data"));
-    channelStatusBox->setTitle(QString::fromStdString(name + " - Status"));
+    channelDataBox->setTitle("Data");
+    channelStatusBox->setTitle("Status");
 
     dataModel = new CollectionModel(this, parameters);
+    statusModel = new ChannelStatusModel(this);
 
+    // Fixed row heights let the view skip measuring every row, so only the
+    // visible rows cost anything no matter how many channels are loaded.
     dataView->setModel(dataModel);
-    dataView->horizontalHeader()->setSectionResizeMode(1, QHeaderView::Stretch);
+    dataView->horizontalHeader()->setSectionResizeMode(CollectionModel::BarcodeColumn, QHeaderView::Stretch);
+    dataView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    dataView->verticalHeader()->hide();
     dataView->setGridStyle(Qt::NoPen);
     dataView->setAlternatingRowColors(true);
 
+    statusView->setModel(statusModel);
+    statusView->horizontalHeader()->setSectionResizeMode(ChannelStatusModel::StatusColumn, QHeaderView::Stretch);
+    statusView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    statusView->verticalHeader()->hide();
+    statusView->setGridStyle(Qt::NoPen);
+    statusView->setAlternatingRowColors(true);
+    statusView->setSelectionMode(QAbstractItemView::NoSelection);
+
     QGridLayout* dataBoxLayout = new QGridLayout;
     dataBoxLayout->addWidget(dataView);
     channelDataBox->setLayout(dataBoxLayout);
 
     QGridLayout* statusBoxLayout = new QGridLayout;
-    statusBoxLayout->addWidget(channelStatus);
+    statusBoxLayout->addWidget(statusView);
     channelStatusBox->setLayout(statusBoxLayout);
 
     QVBoxLayout* layout = new QVBoxLayout;
 
-    layout->addWidget(channelDataBox);
-    layout->addWidget(channelStatusBox);
+    layout->addWidget(channelDataBox, 3);
+    layout->addWidget(channelStatusBox, 1);
     setLayout(layout);
 }
 
 ChannelWidget::~ChannelWidget()
 {}
 
-void ChannelWidget::setChannel(int channel)
+void ChannelWidget::setChannels(std::vector<int> channels)
 {
-    if (channel < 0 || channel > 3)
+    for (auto channel : channels)
     {
-        emit issueAlert("Invalid Channel");
-        return;
+        if (channel < 0)
+        {
+            emit issueAlert("Invalid Channel");
+            return;
+        }
     }
 
-    this->channel = channel;
-    this->dataModel->setChannel(channel);
-    name = "CH" + std::to_string(channel) + " (" + polarity + ")";
-    channelDataBox->setTitle(QString::fromStdString(name + " - Data"));
-    channelStatusBox->setTitle(QString::fromStdString(name + " - Status"));
+    this->channels = channels;
+    dataModel->setChannels(channels);
+
+    channelDataBox->setTitle(QString::fromStdString(fmt::format("CH{} - Data", fmt::join(channels, ", CH"))));
+}
+
+void ChannelWidget::setAvailableChannels(std::vector<int> channels)
+{
+    statusModel->setChannels(channels);
 }
 
 void ChannelWidget::setTestParameters(TestParameters params)
@@ -77,36 +102,12 @@ std::map<std::string, TubeData> ChannelWidget::getDataForCSV()
 
 void ChannelWidget::receiveChannelPolarity(int channel, int polarity)
 {
-    if (channel != this->channel)
-        return;
-
-    if (this->polarity == "~")
-    {
-        if (polarity > 0)
-        {
-            this->polarity = "-";
-        }
-        else if (polarity == 0)
-        {
-            this->polarity = "+";
-        }
-        else
-        {
-            this->polarity = "~";
-        }
-
-        name = "CH" + std::to_string(channel) + " (" + this->polarity + ")";
-        channelDataBox->setTitle(QString::fromStdString(name + " - Data"));
-        channelStatusBox->setTitle(QString::fromStdString(name + " - Status"));
-    }
+    statusModel->setPolarity(channel, polarity);
 }
 
 void ChannelWidget::receiveChannelStatus(int channel, std::string status)
 {
-    if (channel != this->channel)
-        return;
-
-    channelStatus->setText(QString::fromStdString(status));
+    statusModel->setStatus(channel, status);
 }
 
 void ChannelWidget::receiveTubeDataPacket(TubeData data)
@@ -116,9 +117,5 @@ void ChannelWidget::receiveTubeDataPacket(TubeData data)
 
 void ChannelWidget::receiveIntrinsicCurrent(int channel, float current)
 {
-    if (channel != this->channel)
-        return;
-
-    name = "CH" + std::to_string(channel) + " (" + this->polarity + ")";
-    channelDataBox->setTitle(QString::fromStdString(name + " " + std::to_string(current) + "nA"));
-}
\ No newline at end of file
+    statusModel->setIntrinsicCurrent(channel, current);
+}
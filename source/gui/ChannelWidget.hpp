@@ -2,6 +2,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 #include <memory>
 #include <utility>
 
@@ -17,6 +18,7 @@
 #include <spdlog/spdlog.h>
 
 #include "CollectionModel.hpp"
+#include "ChannelStatusModel.hpp"
 // #include "TestController.hpp"
 #include "TestInfo.hpp"
 
@@ -34,7 +36,11 @@ public:
     ChannelWidget& operator=(const ChannelWidget&) = delete;
     ChannelWidget& operator=(ChannelWidget&&) = delete;
 
-    void setChannel(int channel);
+    // The channels under test. Their tubes share one table.
+    void setChannels(std::vector<int> channels);
+
+    // Every channel the power supply reports, for the status table.
+    void setAvailableChannels(std::vector<int> channels);
 
     void setTestParameters(TestParameters params);
 
@@ -50,11 +56,7 @@ signals:
     void issueAlert(std::string msg);
 
 private:
-    int channel;
-    std::string name;
-    std::string polarity;
-
-    QLabel* channelStatus;
+    std::vector<int> channels;
 
     QGroupBox* channelDataBox;
     QGroupBox* channelStatusBox;
@@ -62,6 +64,9 @@ private:
     QTableView* dataView;
     CollectionModel* dataModel;
 
+    QTableView* statusView;
+    ChannelStatusModel* statusModel;
+
     TestParameters parameters;
 
     std::shared_ptr<spdlog::logger> logger;
@@ -4,6 +4,8 @@
     #define DEBUG
 #endif
 
+#include <algorithm>
+
 #include <fmt/core.h>
 
 #include <QColor>
@@ -12,10 +14,7 @@
 
 CollectionModel::CollectionModel(QObject* parent, TestParameters parameters):
     QAbstractTableModel(parent),
-    channel { -1 },
-    parameters { parameters },
-    internalData(parameters.tubesPerChannel),
-    barcodes(parameters.tubesPerChannel, "")
+    parameters { parameters }
 {}
 
 CollectionModel::~CollectionModel()
@@ -24,8 +23,7 @@ CollectionModel::~CollectionModel()
 int CollectionModel::columnCount(const QModelIndex& parent) const
 {
     Q_UNUSED(parent);
-    // return 5;
-    return 4;
+    return ColumnCount;
 }
 
 QVariant CollectionModel::data(const QModelIndex& index, int role) const
@@ -38,20 +36,21 @@ QVariant CollectionModel::data(const QModelIndex& index, int role) const
 
     int col = index.column();
     int row = index.row();
+    int tubesPerChannel = parameters.tubesPerChannel;
 
-    // We need to check if the row exists. To be implemented later.
     bool dataExists = barcodes[row] != "";
     bool addTestingIcon = internalData[row].isActive;
 
-    if (col == 0 && role == Qt::DisplayRole)
-    {
-        return row;
-    }
+    if (col == IndexColumn && role == Qt::DisplayRole)
+        return row % tubesPerChannel;
+
+    if (col == ChannelColumn && role == Qt::DisplayRole)
+        return channels[row / tubesPerChannel];
 
     // We want to try coloring things
     if (dataExists && role == Qt::DecorationRole)
     {
-        if (col == 1 && addTestingIcon)
+        if (col == BarcodeColumn && addTestingIcon)
         {
             return QColor("orange");
         }
@@ -59,7 +58,12 @@ QVariant CollectionModel::data(const QModelIndex& index, int role) const
 
     if (dataExists && role == Qt::BackgroundRole)
     {
-        if (col == 2 && internalData[row].current > 2.00)
+        // Judge the tube on the running mean once we have samples, so that a
+        // single noisy reading does not flag the tube.
+        const auto& statistics = internalData[row].statistics;
+        double current = (statistics.count > 0) ? statistics.mean : internalData[row].current;
+
+        if (col == CurrentColumn && current > 2.00)
             return QColor("red");
     }
 
@@ -67,25 +71,12 @@ QVariant CollectionModel::data(const QModelIndex& index, int role) const
     {
         switch (col)
         {
-        case 2:
+        case BarcodeColumn:
+            return QString::fromStdString(barcodes[row]);
+        case CurrentColumn:
             return internalData[row].current;
-        case 3:
+        case VoltageColumn:
             return internalData[row].voltage;
-        case 4:
-            return QVariant();
-        }
-
-    #ifdef COMMENT
-        if (col == 1 && addTestingIcon)
-        {
-            auto str = "[ACTIVE] " + barcodes[row];
-            return QString::fromStdString(str); 
-        }
-    #endif // COMMENT
-
-        if (col == 1)
-        {
-            return QString::fromStdString(barcodes[row]); 
         }
     }
 
@@ -94,7 +85,7 @@ QVariant CollectionModel::data(const QModelIndex& index, int role) const
 
 Qt::ItemFlags CollectionModel::flags(const QModelIndex& index) const
 {
-    if (index.column() == 1)
+    if (index.column() == BarcodeColumn)
         return Qt::ItemIsEditable | Qt::ItemIsSelectable | Qt::ItemIsEnabled;
     else
         return Qt::ItemIsSelectable | Qt::ItemIsEnabled;
@@ -106,16 +97,16 @@ QVariant CollectionModel::headerData(int section, Qt::Orientation orientation, i
     {
         switch (section)
         {
-        case 0:
+        case IndexColumn:
             return "Index";
-        case 1:
+        case ChannelColumn:
+            return "Channel";
+        case BarcodeColumn:
             return "Barcode";
-        case 2:
+        case CurrentColumn:
             return "Current [nA]";
-        case 3:
+        case VoltageColumn:
             return "Voltage [V]";
-        case 4:
-            return QVariant();
         }
     }
 
@@ -124,8 +115,10 @@ QVariant CollectionModel::headerData(int section, Qt::Orientation orientation, i
 
 int CollectionModel::rowCount(const QModelIndex& parent) const
 {
-    Q_UNUSED(parent);
-    return parameters.tubesPerChannel;
+    if (parent.isValid())
+        return 0;
+
+    return static_cast<int>(internalData.size());
 }
 
 bool CollectionModel::setData(const QModelIndex& index, const QVariant& value, int role)
@@ -136,7 +129,7 @@ bool CollectionModel::setData(const QModelIndex& index, const QVariant& value, i
     int col = index.column();
     int row = index.row();
 
-    if (col == 1)
+    if (col == BarcodeColumn)
     {
         auto str = value.toString().toStdString();
 
@@ -145,42 +138,77 @@ bool CollectionModel::setData(const QModelIndex& index, const QVariant& value, i
         else
             if (str != "")
                 barcodes[row] = str;
+
+        emit dataChanged(this->index(row, 0), this->index(row, ColumnCount - 1));
         return true;
     }
 
     return false;
 }
 
-void CollectionModel::setChannel(int channel)
+void CollectionModel::setChannels(std::vector<int> channels)
 {
-    this->channel = channel;
+    if (channels == this->channels)
+        return;
+
+    beginResetModel();
+
+    this->channels = channels;
+    channelPositions.clear();
+
+    for (int k = 0; k < static_cast<int>(channels.size()); ++k)
+        channelPositions[channels[k]] = k;
+
+    resize();
+    endResetModel();
 }
 
 void CollectionModel::setTestParameters(TestParameters parameters)
 {
-    emit layoutAboutToBeChanged();
+    beginResetModel();
     this->parameters = parameters;
-    emit layoutChanged();
+    resize();
+    endResetModel();
+}
+
+void CollectionModel::resize()
+{
+    std::size_t rows = channels.size() * static_cast<std::size_t>(std::max(parameters.tubesPerChannel, 0));
+
+    internalData.resize(rows);
+    barcodes.resize(rows, "");
+}
+
+int CollectionModel::rowFor(int channel, int index) const
+{
+    auto it = channelPositions.find(channel);
+
+    if (it == channelPositions.end() || index < 0 || index >= parameters.tubesPerChannel)
+        return -1;
+
+    return it->second * parameters.tubesPerChannel + index;
 }
 
 void CollectionModel::storeTubeDataPacket(TubeData data)
 {
-    emit layoutAboutToBeChanged();
+    int row = rowFor(data.channel, data.index);
 
-    if (data.channel == channel)
-        internalData[data.index] = data;
+    if (row < 0)
+        return;
 
-    emit layoutChanged();
+    internalData[row] = data;
+
+    // Only the row that changed is repainted.
+    emit dataChanged(index(row, 0), index(row, ColumnCount - 1));
 }
 
 void CollectionModel::createFakeBarcodes()
 {
-    emit layoutAboutToBeChanged();
-
     for (int i = 0; i < barcodes.size(); ++i)
         barcodes[i] = fmt::format("MSU0012{}", i);
 
-    emit layoutChanged();
+    if (!barcodes.empty())
+        emit dataChanged(index(0, 0), index(static_cast<int>(barcodes.size()) - 1, ColumnCount - 1));
 }
 
 std::map<std::string, TubeData> CollectionModel::getDataForCSV()
@@ -194,4 +222,4 @@ std::map<std::string, TubeData> CollectionModel::getDataForCSV()
     }
 
     return data;
-}
\ No newline at end of file
+}
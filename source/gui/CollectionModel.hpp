@@ -11,11 +11,26 @@
 #include "TestController.hpp"
 #include "TestInfo.hpp"
 
+// One table for every tube of every channel under test. Rows are grouped by
+// channel, tubesPerChannel rows at a time, in the order the channels were
+// given. A single model behind a single view means the cost of an update does
+// not depend on how many channels the station has: a packet touches one row
+// and only that row is repainted.
 class CollectionModel : public QAbstractTableModel
 {
     Q_OBJECT
 
 public:
+    enum Column
+    {
+        IndexColumn,
+        ChannelColumn,
+        BarcodeColumn,
+        CurrentColumn,
+        VoltageColumn,
+        ColumnCount
+    };
+
     explicit CollectionModel(QObject* parent, TestParameters parameters);
     ~CollectionModel();
 
@@ -26,7 +41,7 @@ public:
     int rowCount(const QModelIndex& parent = QModelIndex()) const;
     bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::DisplayRole);
 
-    void setChannel(int channel);
+    void setChannels(std::vector<int> channels);
 
     void setTestParameters(TestParameters parameters);
 
@@ -36,8 +51,13 @@ public:
     std::map<std::string, TubeData> getDataForCSV();
 
 private:
-    int channel;
+    int rowFor(int channel, int index) const;
+    void resize();
+
+private:
+    std::vector<int> channels;
+    std::map<int, int> channelPositions;
     TestParameters parameters;
     std::vector<TubeData> internalData;
     std::vector<std::string> barcodes;
-};
\ No newline at end of file
+};
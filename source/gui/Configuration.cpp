@@ -0,0 +1,300 @@
+// Configuration.cpp
+
+#include "Configuration.hpp"
+
+#include <fstream>
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+
+#include <nlohmann/json.hpp>
+
+#include <spdlog/spdlog.h>
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+using json = nlohmann::json;
+
+std::optional<StationConfiguration> readConfiguration(const std::string& file)
+{
+    std::shared_ptr<spdlog::logger> logger;
+
+    try
+    {
+        logger = spdlog::stdout_color_mt("Configuration");
+    }
+    catch (const spdlog::spdlog_ex& ex)
+    {
+        logger = spdlog::get("Configuration");
+    }
+
+    StationConfiguration configuration;
+
+    json config;
+    try
+    {
+        std::ifstream in_file(file);
+        in_file >> config;
+    }
+    catch(const std::exception& e)
+    {
+        logger->error("Unable to parse file. Returning");
+        return std::nullopt;
+    }
+
+    msu_smdt::Port HWPort;
+    msu_smdt::Port PSUPort;
+
+    try
+    {
+        auto port = config["port"]["psu"]["port"].get<std::string>();
+        auto baud_rate = config["port"]["psu"]["baud_rate"].get<std::string>();
+        auto data_bit = config["port"]["psu"]["data_bit"].get<std::string>();
+        auto stop_bit = config["port"]["psu"]["stop_bit"].get<std::string>();
+        auto parity = config["port"]["psu"]["parity"].get<std::string>();
+        auto lbusaddress = config["port"]["psu"]["lbusaddress"].get<std::string>();
+
+        PSUPort = {
+            port,
+            baud_rate,
+            data_bit,
+            stop_bit,
+            parity,
+            lbusaddress
+        };
+    }
+    catch (std::exception & ex)
+    {
+        logger->error("Cannot obtain PSU port information");
+        return std::nullopt;
+    }
+
+    try
+    {
+        auto port = config["port"]["hw"]["port"].get<std::string>();
+        auto baud_rate = config["port"]["hw"]["baud_rate"].get<std::string>();
+        auto data_bit = config["port"]["hw"]["data_bit"].get<std::string>();
+        auto stop_bit = config["port"]["hw"]["stop_bit"].get<std::string>();
+        auto parity = config["port"]["hw"]["parity"].get<std::string>();
+        auto lbusaddress = config["port"]["hw"]["lbusaddress"].get<std::string>();
+
+        HWPort = {
+            port,
+            baud_rate,
+            data_bit,
+            stop_bit,
+            parity,
+            lbusaddress
+        };
+    }
+    catch (std::exception& ex)
+    {
+        logger->error("Cannot obtain HW port information");
+        return std::nullopt;
+    }
+
+    TestParameters parameters;
+    try
+    {
+        auto seconds_per_tube = config["test"]["seconds_per_tube"].get<int>();
+        auto tubes_per_channel = config["test"]["tubes_per_channel"].get<int>();
+        auto time_for_testing_voltage = config["test"]["time_for_testing_voltage"].get<int>();
+
+        parameters = {
+            seconds_per_tube,
+            tubes_per_channel,
+            time_for_testing_voltage
+        };
+    }
+    catch (std::exception& ex)
+    {
+        logger->error("Cannot obtain test parameters from file");
+        return std::nullopt;
+    }
+
+    try
+    {
+        parameters.rebaselineEveryTubes = config["test"].value("rebaseline_every_tubes", 0);
+        parameters.rebaselineSeconds = config["test"].value("rebaseline_seconds", 5);
+        parameters.rebaselineReads = std::max(config["test"].value("rebaseline_reads", 5), 1);
+    }
+    catch (std::exception& ex)
+    {
+        logger->error("Cannot obtain re-baselining settings");
+    }
+
+    try
+    {
+        if (config["test"].contains("calibration"))
+        {
+            const auto& calibration = config["test"]["calibration"];
+
+            parameters.calibrationVerifySeconds = calibration.value("verify_seconds", 5);
+            parameters.calibrationMaxAgeHours = calibration.value("max_age_hours", 24);
+            parameters.calibrationTolerance = calibration.value("tolerance", 2.00f);
+        }
+    }
+    catch (std::exception& ex)
+    {
+        logger->error("Cannot obtain offset calibration settings");
+    }
+
+    TestConfiguration normalConfig;
+    TestConfiguration reverseConfig;
+    try
+    {
+        auto test_voltage = config["test"]["normal"]["test_voltage"].get<int>();
+        auto current_limit = config["test"]["normal"]["current_limit"].get<int>();
+        auto max_voltage = config["test"]["normal"]["max_voltage"].get<int>();
+        auto ramp_up_rate = config["test"]["normal"]["ramp_up_rate"].get<int>();
+        auto ramp_down_rate = config["test"]["normal"]["ramp_down_rate"].get<int>();
+        auto over_current_limit = config["test"]["normal"]["over_current_limit"].get<int>();
+        auto power_down_method = config["test"]["normal"]["power_down_method"].get<int>();
+
+        normalConfig = {
+            test_voltage,
+            current_limit,
+            max_voltage,
+            ramp_up_rate,
+            ramp_down_rate,
+            over_current_limit,
+            power_down_method,
+        };
+
+        test_voltage = config["test"]["reverse"]["test_voltage"].get<int>();
+        current_limit = config["test"]["reverse"]["current_limit"].get<int>();
+        max_voltage = config["test"]["reverse"]["max_voltage"].get<int>();
+        ramp_up_rate = config["test"]["reverse"]["ramp_up_rate"].get<int>();
+        ramp_down_rate = config["test"]["reverse"]["ramp_down_rate"].get<int>();
+        over_current_limit = config["test"]["reverse"]["over_current_limit"].get<int>();
+        power_down_method = config["test"]["reverse"]["power_down_method"].get<int>();
+
+        reverseConfig = {
+            test_voltage,
+            current_limit,
+            max_voltage,
+            ramp_up_rate,
+            ramp_down_rate,
+            over_current_limit,
+            power_down_method,
+        };
+    }
+    catch (std::exception& ex)
+    {
+        logger->error("Cannot obtain test initial conditions from file");
+        return std::nullopt;
+    }
+
+    try
+    {
+        std::vector<int> normalChannels = config["channels"]["normal"].get<std::vector<int>>();
+        std::vector<int> reverseChannels = config["channels"]["reverse"].get<std::vector<int>>();
+
+        configuration.normalChannels = normalChannels;
+        configuration.reverseChannels = reverseChannels;
+    }
+    catch (std::exception& ex)
+    {
+        logger->error("Cannot obtain Normal and Reverse channels");
+        return std::nullopt;
+    }
+
+    try
+    {
+        configuration.csvPath = config["path"]["csv"].get<std::string>();
+        logger->debug("CSV PATH: {}", configuration.csvPath);
+    }
+    catch (std::exception& ex)
+    {
+        logger->error("Cannot obtain CSV Path");
+    }
+
+    try
+    {
+        configuration.storePath = config["path"].value("store", "");
+        configuration.archivePath = config["path"].value("archive", "");
+        configuration.tracePath = config["path"].value("trace", "");
+        configuration.calibrationPath = config["path"].value("calibration", "");
+    }
+    catch (std::exception& ex)
+    {
+        logger->error("Cannot obtain the store, archive, trace and calibration paths");
+    }
+
+    if (configuration.storePath.empty())
+        configuration.storePath = configuration.csvPath;
+
+    try
+    {
+        configuration.testWithAllChannels = config["experimental"].value("test_with_all_channels", false);
+    }
+    catch (std::exception& ex)
+    {
+        logger->error("Cannot obtain experimental settings");
+    }
+
+    configuration.PSUPort = PSUPort;
+    configuration.HWPort = HWPort;
+    configuration.parameters = parameters;
+    configuration.normalConfig = normalConfig;
+    configuration.reverseConfig = reverseConfig;
+
+    return configuration;
+}
+
+std::optional<std::vector<StationEntry>> readStations(const std::string& file)
+{
+    std::shared_ptr<spdlog::logger> logger;
+
+    try
+    {
+        logger = spdlog::stdout_color_mt("Configuration");
+    }
+    catch (const spdlog::spdlog_ex& ex)
+    {
+        logger = spdlog::get("Configuration");
+    }
+
+    json config;
+    try
+    {
+        std::ifstream in_file(file);
+        in_file >> config;
+    }
+    catch(const std::exception& e)
+    {
+        logger->error("Unable to parse stations file. Returning");
+        return std::nullopt;
+    }
+
+    auto base = std::filesystem::path(file).parent_path();
+    auto resolve = [&base](const std::string& path) -> std::string {
+        if (path.empty() || std::filesystem::path(path).is_absolute())
+            return path;
+
+        return (base / path).string();
+    };
+
+    std::vector<StationEntry> entries;
+
+    try
+    {
+        for (const auto& station : config.at("stations"))
+        {
+            StationEntry entry;
+
+            entry.name = station.at("name").get<std::string>();
+            entry.configFile = resolve(station.at("config").get<std::string>());
+            entry.barcodesFile = resolve(station.value("barcodes", ""));
+            entry.mode = station.value("mode", "");
+
+            entries.push_back(entry);
+        }
+    }
+    catch (std::exception& ex)
+    {
+        logger->error("Cannot obtain the stations: {}", ex.what());
+        return std::nullopt;
+    }
+
+    return entries;
+}
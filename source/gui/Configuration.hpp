@@ -0,0 +1,53 @@
+// Configuration.hpp
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+
+#include <psu/Port.hpp>
+
+#include "TestInfo.hpp"
+
+// Everything a station reads from its configuration.json.
+struct StationConfiguration
+{
+    msu_smdt::Port PSUPort;
+    msu_smdt::Port HWPort;
+
+    TestParameters parameters;
+    TestConfiguration normalConfig;
+    TestConfiguration reverseConfig;
+
+    std::vector<int> normalChannels;
+    std::vector<int> reverseChannels;
+
+    std::string csvPath { "" };
+    std::string storePath { "" };
+    std::string archivePath { "" };
+    std::string tracePath { "" };
+    std::string calibrationPath { "" };
+
+    bool testWithAllChannels { false };
+};
+
+// Parses a configuration file. Problems are logged, and an empty optional is
+// returned if a required section is missing or malformed.
+std::optional<StationConfiguration> readConfiguration(const std::string& file);
+
+// One entry of a stations file. Paths are relative to the stations file.
+struct StationEntry
+{
+    std::string name;
+    std::string configFile;
+    std::string barcodesFile { "" };
+    std::string mode { "" };
+};
+
+// Parses a stations file of the form
+//
+//     { "stations": [ { "name": "A", "config": "a.json", "barcodes": "a.txt", "mode": "normal" } ] }
+//
+// where "barcodes" and "mode" are optional.
+std::optional<std::vector<StationEntry>> readStations(const std::string& file);
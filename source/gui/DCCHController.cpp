@@ -1,5 +1,7 @@
 #include <spdlog/sinks/stdout_color_sinks.h>
 
+#include <instrumentation/Metrics.hpp>
+
 #include "DCCHController.hpp"
 
 #ifndef Q_OS_WIN
@@ -7,6 +9,7 @@
 DCCHController::DCCHController(QObject* parent):
     QObject(parent),
     port { new QSerialPort },
+    isVirtual { false },
     buf(4, '*')
 {
     try
@@ -22,6 +25,7 @@ DCCHController::DCCHController(QObject* parent):
 DCCHController::DCCHController(QObject* parent, msu_smdt::Port DCCHPort):
     QObject(parent),
     port { new QSerialPort },
+    isVirtual { false },
     buf(4, '*')
 {
     // port->setPortName(QString::fromStdString(DCCHPort.port));
@@ -47,13 +51,21 @@ DCCHController::~DCCHController()
 
 void DCCHController::setPort(msu_smdt::Port DCCHPort)
 {
+    buf[0] = '{';
+    buf[3] = '}';
+
+    isVirtual = (DCCHPort.port == virtualPort);
+
+    if (isVirtual)
+    {
+        logger->debug("Using a virtual DCCH Board");
+        return;
+    }
+
     port->setPortName(QString::fromStdString(DCCHPort.port));
     port->setBaudRate(std::stoi(DCCHPort.baud_rate));
     port->setDataBits(QSerialPort::Data8);
 
-    buf[0] = '{';
-    buf[3] = '}';
-
     if (!port->open(QIODeviceBase::ReadWrite))
     {
         logger->error("Cannot connect to DCCH Board [FATAL]: {}", port->errorString().toStdString());
@@ -65,9 +77,21 @@ void DCCHController::connectTube(int tube)
     buf[1] = (char) tube;
     buf[2] = (char) 1;
 
-    int r = port->write(buf.data(), buf.size());
+    instrumentation::ScopedTimer timer(instrumentation::Operation::DCCHWrite);
 
-    while (port->waitForBytesWritten());
+    int r = static_cast<int>(buf.size());
+
+    if (!isVirtual)
+    {
+        r = port->write(buf.data(), buf.size());
+
+        while (port->waitForBytesWritten());
+    }
+
+    timer.failed(r != (int) buf.size());
+
+    if (r > 0)
+        instrumentation::Metrics::global().addBytesWritten(r);
 
     if (!r)
         logger->error("Cannot enable tube through Serial. Error: {}", port->errorString().toStdString());
@@ -80,9 +104,21 @@ void DCCHController::disconnectTube(int tube)
     buf[1] = (char) tube;
     buf[2] = (char) 0;
 
-    int r = port->write(buf.data(), buf.size());
+    instrumentation::ScopedTimer timer(instrumentation::Operation::DCCHWrite);
+
+    int r = static_cast<int>(buf.size());
 
-    while (port->waitForBytesWritten());
+    if (!isVirtual)
+    {
+        r = port->write(buf.data(), buf.size());
+
+        while (port->waitForBytesWritten());
+    }
+
+    timer.failed(r != (int) buf.size());
+
+    if (r > 0)
+        instrumentation::Metrics::global().addBytesWritten(r);
 
     if (!r)
     {
@@ -91,8 +127,9 @@ void DCCHController::disconnectTube(int tube)
 }
 
 #else
-DCCHController::DCCHController(msu_smdt::Port DCCHPort):
+DCCHController::DCCHController(msu_smdt::Port DCCHPort, instrumentation::Clock& clock):
     connected { false },
+    isVirtual { DCCHPort.port == virtualPort },
     buf(4, '*')
 {
     try
@@ -104,6 +141,15 @@ DCCHController::DCCHController(msu_smdt::Port DCCHPort):
         logger = spdlog::get("Serial");
     }
 
+    buf[0] = '{';
+    buf[3] = '}';
+
+    if (isVirtual)
+    {
+        logger->debug("Using a virtual DCCH Board");
+        return;
+    }
+
     handle = CreateFileA(
         static_cast<LPCSTR>(DCCHPort.port.c_str()),
         GENERIC_READ | GENERIC_WRITE,
@@ -144,12 +190,9 @@ DCCHController::DCCHController(msu_smdt::Port DCCHPort):
         {
             this->connected = true;
             PurgeComm(handle, PURGE_RXCLEAR | PURGE_TXCLEAR);
-            Sleep(2000);
+            clock.sleep(std::chrono::seconds(2));
         }
     }
-
-    buf[0] = '{';
-    buf[3] = '}';
 }
 
 DCCHController::~DCCHController()
@@ -165,8 +208,15 @@ void DCCHController::connectTube(int tube)
 
     DWORD bytesSent = 0;
 
-    if (!WriteFile(handle, (void*) buf.data(), buf.size(), &bytesSent, 0))
+    instrumentation::ScopedTimer timer(instrumentation::Operation::DCCHWrite);
+
+    if (isVirtual)
+        bytesSent = static_cast<DWORD>(buf.size());
+    else if (!WriteFile(handle, (void*) buf.data(), buf.size(), &bytesSent, 0))
         ClearCommError(handle, &error, &status);
+
+    timer.failed(bytesSent != buf.size());
+    instrumentation::Metrics::global().addBytesWritten(bytesSent);
 }
 
 void DCCHController::disconnectTube(int tube)
@@ -176,8 +226,15 @@ void DCCHController::disconnectTube(int tube)
 
     DWORD bytesSent = 0;
 
-    if (!WriteFile(handle, (void*) buf.data(), buf.size(), &bytesSent, 0))
+    instrumentation::ScopedTimer timer(instrumentation::Operation::DCCHWrite);
+
+    if (isVirtual)
+        bytesSent = static_cast<DWORD>(buf.size());
+    else if (!WriteFile(handle, (void*) buf.data(), buf.size(), &bytesSent, 0))
         ClearCommError(handle, &error, &status);
+
+    timer.failed(bytesSent != buf.size());
+    instrumentation::Metrics::global().addBytesWritten(bytesSent);
 }
 
 #endif
\ No newline at end of file
@@ -9,8 +9,17 @@
 #include <spdlog/spdlog.h>
 
 #include <psu/Port.hpp>
+#include <instrumentation/Clock.hpp>
 #include "TestInfo.hpp"
 
+// A port of this name is a DCCH board that is not there: tubes are switched
+// instantly and nothing is sent, for running tests against FakeHV.
+inline constexpr const char* virtualPort = "VIRTUAL";
+
+// Tube positions on the board, Test::TUBES in the firmware (DCCH.ino). It
+// ignores commands for any other position.
+inline constexpr int dcchPositions = 32;
+
 #ifndef Q_OS_WIN
 
 class DCCHController : public QObject
@@ -30,6 +39,7 @@ public slots:
 
 private:
     QSerialPort* port;
+    bool isVirtual;
     std::vector<char> buf;
     std::shared_ptr<spdlog::logger> logger;
 };
@@ -41,7 +51,7 @@ private:
 class DCCHController : public QObject
 {
 public:
-    DCCHController(msu_smdt::Port DCCHPort);
+    DCCHController(msu_smdt::Port DCCHPort, instrumentation::Clock& clock = instrumentation::Clock::system());
     ~DCCHController();
 
     void connectTube(int tube);
@@ -49,6 +59,7 @@ public:
 
 private:
     bool connected;
+    bool isVirtual;
 
     HANDLE handle;
     COMSTAT status;
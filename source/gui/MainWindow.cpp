@@ -5,7 +5,6 @@
 #include <exception>
 
 #include <spdlog/sinks/stdout_color_sinks.h>
-#include <nlohmann/json.hpp>
 
 #include <QDateTime>
 
@@ -19,7 +18,7 @@
 
 #include <QInputDialog>
 
-using json = nlohmann::json;
+#include "Configuration.hpp"
 
 static bool testIsRunning = false;
 static bool connectedToPSU = false;
@@ -28,12 +27,12 @@ MainWindow::MainWindow(QWidget* parent):
     QMainWindow(parent),
     testType { 0 },
     hasStarted { false },
+    testWithAllChannels { false },
     controller { new TestController(this) },
     channelWidgetContainer { new QWidget },
     controlPanelWidget { new ControlPanelWidget },
     userEntry { new QLineEdit },
-    channelWidgetLeft { new ChannelWidget },
-    channelWidgetRight { new ChannelWidget },
+    channelWidget { new ChannelWidget },
     testStatusWidget { new TestStatusWidget },
     csv_path { "" }
 {
@@ -57,8 +56,7 @@ MainWindow::MainWindow(QWidget* parent):
     userEntry->setPlaceholderText("User");
     nameWidget->setLayout(nameLayout);
 
-    channelWidgetLayout->addWidget(channelWidgetLeft);
-    channelWidgetLayout->addWidget(channelWidgetRight);
+    channelWidgetLayout->addWidget(channelWidget);
     channelWidgetContainer->setLayout(channelWidgetLayout);
 
     layout->addWidget(controlPanelWidget);
@@ -103,6 +101,18 @@ MainWindow::MainWindow(QWidget* parent):
 
     */
 
+    // Connected ahead of the controller, so the run id is set before the test
+    // is created.
+    auto testStarted = [this]() {
+        runId = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss").toStdString();
+        controller->setRunId(runId);
+        testStatusWidget->startTime();
+        testStatusWidget->update();
+    };
+
+    QObject::connect(this, &MainWindow::start, testStarted);
+    QObject::connect(this, &MainWindow::startAll, testStarted);
+
     QObject::connect(
         this,
         &MainWindow::start,
@@ -112,51 +122,37 @@ MainWindow::MainWindow(QWidget* parent):
 
     QObject::connect(
         this,
-        &MainWindow::stop,
+        &MainWindow::startAll,
         controller,
-        &TestController::stop
+        &TestController::startAllChannels
     );
 
-    // Now we need to connect the data.
     QObject::connect(
+        this,
+        &MainWindow::stop,
         controller,
-        &TestController::distributeTubeDataPacket,
-        channelWidgetLeft,
-        &ChannelWidget::receiveTubeDataPacket
+        &TestController::stop
     );
 
+    // Now we need to connect the data.
     QObject::connect(
         controller,
         &TestController::distributeTubeDataPacket,
-        channelWidgetRight,
+        channelWidget,
         &ChannelWidget::receiveTubeDataPacket
     );
 
     QObject::connect(
         controller,
         &TestController::distributeChannelPolarity,
-        channelWidgetLeft,
+        channelWidget,
         &ChannelWidget::receiveChannelPolarity
     );
 
-    QObject::connect(
-        controller,
-        &TestController::distributeChannelPolarity,
-        channelWidgetRight,
-        &ChannelWidget::receiveChannelPolarity
-    );
-
-    QObject::connect(
-        controller,
-        &TestController::distributeChannelStatus,
-        channelWidgetLeft,
-        &ChannelWidget::receiveChannelStatus
-    );
-
     QObject::connect(
         controller,
         &TestController::distributeChannelStatus,
-        channelWidgetRight,
+        channelWidget,
         &ChannelWidget::receiveChannelStatus
     );
 
@@ -169,15 +165,6 @@ MainWindow::MainWindow(QWidget* parent):
         }
     );
 
-    QObject::connect(
-        this,
-        &MainWindow::start,
-        [this]() {
-            testStatusWidget->startTime();
-            testStatusWidget->update();
-        }
-    );
-
     /*
     QObject::connect(
         this,
@@ -193,6 +180,18 @@ MainWindow::MainWindow(QWidget* parent):
     );
     */
 
+    // Comes before finished, so the run id is still the one of this run.
+    QObject::connect(
+        controller,
+        &TestController::distributeRunReport,
+        [this](RunReport report) {
+            testStatusWidget->showRunReport(report);
+
+            if (resultsWriter)
+                resultsWriter->submitReport(fmt::format("run_{}.report.txt", runId), report.format());
+        }
+    );
+
     QObject::connect(
         controller,
         &TestController::finished,
@@ -236,8 +235,8 @@ MainWindow::MainWindow(QWidget* parent):
 
                 controller->connect(PSUPort, HWPort);
                 controller->setTestParameters(this->parameters);
-                channelWidgetLeft->setTestParameters(this->parameters);
-                channelWidgetRight->setTestParameters(this->parameters);
+                channelWidget->setTestParameters(this->parameters);
+                channelWidget->setAvailableChannels(controller->availableChannels());
 
                 controller->initializeTestConfiguration(this->normalConfig, this->reverseConfig);
                 testStatusWidget->updateConnectionStatus(true);
@@ -276,6 +275,9 @@ MainWindow::MainWindow(QWidget* parent):
             bool ok = false;
             QStringList testTypesAvailable;
             testTypesAvailable << "Normal" << "Reverse";
+
+            if (testWithAllChannels)
+                testTypesAvailable << "All";
             QString item = QInputDialog::getItem(
                 this, 
                 "Get Test Type", 
@@ -291,6 +293,18 @@ MainWindow::MainWindow(QWidget* parent):
 
             if (ok && !item.isEmpty())
             {
+                if (item == "All")
+                {
+                    testType = 1;
+                    auto all = normalChannels;
+                    all.insert(all.end(), reverseChannels.begin(), reverseChannels.end());
+                    channelWidget->setChannels(all);
+
+                    controlPanelWidget->setExecutionState(true);
+                    emit startAll(normalChannels, reverseChannels);
+                    return;
+                }
+
                 if (item == "Normal")
                 {
                     testType = 1;
@@ -304,8 +318,7 @@ MainWindow::MainWindow(QWidget* parent):
                     v = reverseChannels;
                 }
 
-                channelWidgetLeft->setChannel(v[0]);
-                channelWidgetRight->setChannel(v[1]);
+                channelWidget->setChannels(v);
 
                 controlPanelWidget->setExecutionState(true);
                 emit start(v, mode);
@@ -346,168 +359,42 @@ bool MainWindow::readInTestSettings()
     if (no_config)
         return false;
 
-    json config;
-    try
-    {
-        std::ifstream in_file(file);
-        in_file >> config;
-    }
-    catch(const std::exception& e)
-    {
-        logger->error("Unable to parse file. Returning");
-        return false;
-    }
-
-    msu_smdt::Port HWPort;
-    msu_smdt::Port PSUPort;
+    auto configuration = readConfiguration(file);
 
-    try
-    {
-        auto port = config["port"]["psu"]["port"].get<std::string>();
-        auto baud_rate = config["port"]["psu"]["baud_rate"].get<std::string>();
-        auto data_bit = config["port"]["psu"]["data_bit"].get<std::string>();
-        auto stop_bit = config["port"]["psu"]["stop_bit"].get<std::string>();
-        auto parity = config["port"]["psu"]["parity"].get<std::string>();
-        auto lbusaddress = config["port"]["psu"]["lbusaddress"].get<std::string>();
-
-        PSUPort = {
-            port,
-            baud_rate,
-            data_bit,
-            stop_bit,
-            parity,
-            lbusaddress
-        };
-    }
-    catch (std::exception & ex)
-    {
-        logger->error("Cannot obtain PSU port information");
+    if (!configuration)
         return false;
-    }
 
-    try
-    {
-        auto port = config["port"]["hw"]["port"].get<std::string>();
-        auto baud_rate = config["port"]["hw"]["baud_rate"].get<std::string>();
-        auto data_bit = config["port"]["hw"]["data_bit"].get<std::string>();
-        auto stop_bit = config["port"]["hw"]["stop_bit"].get<std::string>();
-        auto parity = config["port"]["hw"]["parity"].get<std::string>();
-        auto lbusaddress = config["port"]["hw"]["lbusaddress"].get<std::string>();
-
-        HWPort = {
-            port,
-            baud_rate,
-            data_bit,
-            stop_bit,
-            parity,
-            lbusaddress
-        };
-    }
-    catch (std::exception& ex)
-    {
-        logger->error("Cannot obtain HW port information");
-        return false;
-    }
+    this->normalChannels = configuration->normalChannels;
+    this->reverseChannels = configuration->reverseChannels;
+    this->csv_path = configuration->csvPath;
 
-    TestParameters parameters;
-    try
-    {
-        auto seconds_per_tube = config["test"]["seconds_per_tube"].get<int>();
-        auto tubes_per_channel = config["test"]["tubes_per_channel"].get<int>();
-        auto time_for_testing_voltage = config["test"]["time_for_testing_voltage"].get<int>();
-
-        parameters = {
-            seconds_per_tube,
-            tubes_per_channel,
-            time_for_testing_voltage
-        };
-    }
-    catch (std::exception& ex)
-    {
-        logger->error("Cannot obtain test parameters from file");
-        return false;
-    }
+    std::shared_ptr<ResultsStore> store;
 
-    TestConfiguration normalConfig;
-    TestConfiguration reverseConfig;
     try
     {
-        auto test_voltage = config["test"]["normal"]["test_voltage"].get<int>();
-        auto current_limit = config["test"]["normal"]["current_limit"].get<int>();
-        auto max_voltage = config["test"]["normal"]["max_voltage"].get<int>();
-        auto ramp_up_rate = config["test"]["normal"]["ramp_up_rate"].get<int>();
-        auto ramp_down_rate = config["test"]["normal"]["ramp_down_rate"].get<int>();
-        auto over_current_limit = config["test"]["normal"]["over_current_limit"].get<int>();
-        auto power_down_method = config["test"]["normal"]["power_down_method"].get<int>();
-
-        normalConfig = {
-            test_voltage,
-            current_limit,
-            max_voltage,
-            ramp_up_rate,
-            ramp_down_rate,
-            over_current_limit,
-            power_down_method,
-        };
-
-        test_voltage = config["test"]["reverse"]["test_voltage"].get<int>();
-        current_limit = config["test"]["reverse"]["current_limit"].get<int>();
-        max_voltage = config["test"]["reverse"]["max_voltage"].get<int>();
-        ramp_up_rate = config["test"]["reverse"]["ramp_up_rate"].get<int>();
-        ramp_down_rate = config["test"]["reverse"]["ramp_down_rate"].get<int>();
-        over_current_limit = config["test"]["reverse"]["over_current_limit"].get<int>();
-        power_down_method = config["test"]["reverse"]["power_down_method"].get<int>();
-
-        reverseConfig = {
-            test_voltage,
-            current_limit,
-            max_voltage,
-            ramp_up_rate,
-            ramp_down_rate,
-            over_current_limit,
-            power_down_method,
-        };
+        store = std::make_shared<ResultsStore>(configuration->storePath);
     }
     catch (std::exception& ex)
     {
-        logger->error("Cannot obtain test initial conditions from file");
-        return false;
+        logger->error("Cannot open the results store: {}", ex.what());
     }
 
-    try
-    {
-        std::vector<int> normalChannels = config["channels"]["normal"].get<std::vector<int>>();
-        std::vector<int> reverseChannels = config["channels"]["reverse"].get<std::vector<int>>();
+    controller->setArchiveDirectory(configuration->archivePath);
+    controller->setTraceDirectory(configuration->tracePath);
+    controller->setCalibrationDirectory(configuration->calibrationPath);
 
-        this->normalChannels = normalChannels;
-        this->reverseChannels = reverseChannels;
-    }
-    catch (std::exception& ex)
-    {
-        logger->error("Cannot obtain Normal and Reverse channels");
-        return false;
-    }
-
-    try
-    {
-        this->csv_path = config["path"]["csv"].get<std::string>();
-        logger->debug("CSV PATH: {}", csv_path);
-    }
-    catch (std::exception& ex)
-    {
-        logger->error("Cannot obtain CSV Path");
-    }
+    resultsWriter.reset();
+    resultsWriter = std::make_unique<ResultsWriter>(csv_path, store);
 
-    this->PSUPort = PSUPort;
-    this->HWPort = HWPort;
-    this->parameters = parameters;
-    this->normalConfig = normalConfig;
-    this->reverseConfig = reverseConfig;
+    this->PSUPort = configuration->PSUPort;
+    this->HWPort = configuration->HWPort;
+    this->parameters = configuration->parameters;
+    this->normalConfig = configuration->normalConfig;
+    this->reverseConfig = configuration->reverseConfig;
 
-    channelWidgetLeft->setTestParameters(parameters);
-    channelWidgetRight->setTestParameters(parameters);
+    channelWidget->setTestParameters(parameters);
 
-    // bool TestWithAllChannels = config["experimental"]["test_with_all_channels"].get<bool>();
+    this->testWithAllChannels = configuration->testWithAllChannels;
 
     return true;
 }
@@ -546,8 +433,8 @@ void MainWindow::receiveRequestToConnect()
 
         controller->connect(PSUPort, HWPort);
         controller->setTestParameters(this->parameters);
-        channelWidgetLeft->setTestParameters(this->parameters);
-        channelWidgetRight->setTestParameters(this->parameters);
+        channelWidget->setTestParameters(this->parameters);
+        channelWidget->setAvailableChannels(controller->availableChannels());
 
         controller->initializeTestConfiguration(this->normalConfig, this->reverseConfig);
         emit connectionStatusChanged(true);
@@ -628,6 +515,9 @@ void MainWindow::receiveRequestToStart()
         bool ok = false;
         QStringList testTypesAvailable;
         testTypesAvailable << "Normal" << "Reverse";
+
+        if (testWithAllChannels)
+            testTypesAvailable << "All";
         QString item = QInputDialog::getItem(
             this, 
             "Get Test Type", 
@@ -643,6 +533,33 @@ void MainWindow::receiveRequestToStart()
 
         if (ok && !item.isEmpty())
         {
+            if (item == "All")
+            {
+                auto all = normalChannels;
+                all.insert(all.end(), reverseChannels.begin(), reverseChannels.end());
+
+                // Every tube of the combined list needs its own position on
+                // the DCCH board.
+                if (parameters.tubesPerChannel * static_cast<int>(all.size()) > dcchPositions)
+                {
+                    alertUser(fmt::format(
+                        "Testing all {} channels needs {} tube positions, but the DCCH board has {}. Test the polarities separately.",
+                        all.size(),
+                        parameters.tubesPerChannel * all.size(),
+                        dcchPositions
+                    ));
+
+                    hasStarted = false;
+                    return;
+                }
+
+                testType = 1;
+                channelWidget->setChannels(all);
+
+                emit startAll(normalChannels, reverseChannels);
+                return;
+            }
+
             if (item == "Normal")
             {
                 testType = 1;
@@ -656,8 +573,7 @@ void MainWindow::receiveRequestToStart()
                 v = reverseChannels;
             }
 
-            channelWidgetLeft->setChannel(v[0]);
-            channelWidgetRight->setChannel(v[1]);
+            channelWidget->setChannels(v);
 
             // controlPanelWidget->executionChanged(true);
             emit start(v, mode);
@@ -738,31 +654,24 @@ void MainWindow::writeCSV()
     csv.close();
 #endif // COMMENT
 
-    auto leftData = channelWidgetLeft->getDataForCSV();
-    auto rightData = channelWidgetRight->getDataForCSV();
-
-    leftData.merge(rightData);
+    if (!resultsWriter)
+    {
+        logger->error("No results writer available. Results are not saved");
+        return;
+    }
 
-    std::fstream csv;
+    auto data = channelWidget->getDataForCSV();
 
-    for (auto& [key, val]: leftData)
-    {
-        auto filename = key + ".csv";
-        auto f = csv_path + "/" + filename;
+    auto now = QDateTime::currentDateTime();
+    auto date = now.toString("dd_MM_yyyy_hh_mm_ss").toStdString();
+    auto user = userEntry->text().toStdString();
 
-        csv.open(f, std::ios::out);
+    std::vector<ResultRecord> records;
+    records.reserve(data.size());
 
-        auto str = fmt::format(
-            "{},{},{},{},{}",
-            val.current,
-            QDateTime::currentDateTime().toString("dd_MM_yyyy_hh_mm_ss").toStdString(),
-            val.voltage,
-            userEntry->text().toStdString(),
-            val.channel,
-            val.intrinsicCurrent
-        );
+    for (auto& [key, val]: data)
+        records.push_back({ key, date, user, val, runId, now.toSecsSinceEpoch() });
 
-        csv << str << std::endl;
-        csv.close();
-    }
+    // The writer does the file work on its own thread.
+    resultsWriter->submit(std::move(records));
 }
\ No newline at end of file
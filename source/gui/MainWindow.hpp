@@ -12,6 +12,7 @@
 #include <QMainWindow>
 
 #include <psu/Port.hpp>
+#include <results/ResultsWriter.hpp>
 
 #include "TestInfo.hpp"
 #include "ChannelWidget.hpp"
@@ -44,11 +45,13 @@ signals:
     void executionStatusChanged(bool status);
 
     void start(std::vector<int> channels, bool mode);
+    void startAll(std::vector<int> normalChannels, std::vector<int> reverseChannels);
     void stop();
 
 private:
     int testType;
     bool hasStarted;
+    bool testWithAllChannels;
 
     std::vector<int> normalChannels;
     std::vector<int> reverseChannels;
@@ -62,13 +65,14 @@ private:
 
     QLineEdit* userEntry;
 
-    ChannelWidget* channelWidgetLeft;
-    ChannelWidget* channelWidgetRight;
+    ChannelWidget* channelWidget;
     TestStatusWidget* testStatusWidget;
 
     std::shared_ptr<spdlog::logger> logger;
 
     std::string csv_path;
+    std::string runId;
+    std::unique_ptr<ResultsWriter> resultsWriter;
 
     // PSU-based members;
     msu_smdt::Port PSUPort;
@@ -0,0 +1,421 @@
+// Orchestrator.cpp
+
+#include "Orchestrator.hpp"
+
+#include <algorithm>
+#include <exception>
+#include <filesystem>
+
+#include <QDateTime>
+
+#include <fmt/core.h>
+
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+namespace fs = std::filesystem;
+
+Orchestrator::Orchestrator(QObject* parent):
+    QObject(parent)
+{
+    try
+    {
+        logger = spdlog::stdout_color_mt("Orchestrator");
+    }
+    catch (const spdlog::spdlog_ex& ex)
+    {
+        logger = spdlog::get("Orchestrator");
+    }
+}
+
+Orchestrator::~Orchestrator()
+{
+    stopAll();
+
+    for (auto& station : stationList)
+    {
+        if (station->controller->checkConnection())
+            station->controller->disconnect();
+    }
+
+    // Controllers wait for their test threads as they are destroyed, then the
+    // writers drain whatever is still queued.
+    stationList.clear();
+}
+
+bool Orchestrator::addStation(std::string name, StationConfiguration configuration)
+{
+    if (find(name))
+    {
+        logger->error("Station {} already exists", name);
+        return false;
+    }
+
+    // One writer serves each results directory, and it writes to one store.
+    for (const auto& other : stationList)
+    {
+        const auto& theirs = other->configuration;
+
+        if (theirs.csvPath == configuration.csvPath && theirs.storePath != configuration.storePath)
+        {
+            logger->error(
+                "Station {} writes results to {} like station {}, but to the store {} instead of {}",
+                name,
+                configuration.csvPath,
+                other->name,
+                configuration.storePath,
+                theirs.storePath
+            );
+
+            return false;
+        }
+    }
+
+    auto station = std::make_unique<Station>();
+    station->name = name;
+    station->configuration = configuration;
+    station->controller = std::make_unique<TestController>(nullptr);
+
+    auto* controller = station->controller.get();
+    auto* s = station.get();
+
+    if (!controller->connect(configuration.PSUPort, configuration.HWPort))
+    {
+        logger->error("Cannot connect to station {}", name);
+        return false;
+    }
+
+    // Each station gets its own archive directory, so that runs started in the
+    // same second on different stations do not collide.
+    if (!configuration.archivePath.empty())
+    {
+        auto directory = fs::path(configuration.archivePath) / name;
+
+        try
+        {
+            fs::create_directories(directory);
+            controller->setArchiveDirectory(directory.string());
+        }
+        catch (const std::exception& ex)
+        {
+            logger->error("Cannot create the archive directory for {}: {}", name, ex.what());
+        }
+    }
+
+    // The same goes for the traces.
+    if (!configuration.tracePath.empty())
+    {
+        auto directory = fs::path(configuration.tracePath) / name;
+
+        try
+        {
+            fs::create_directories(directory);
+            controller->setTraceDirectory(directory.string());
+        }
+        catch (const std::exception& ex)
+        {
+            logger->error("Cannot create the trace directory for {}: {}", name, ex.what());
+        }
+    }
+
+    // Offsets belong to the supply of one station, so each keeps its own.
+    if (!configuration.calibrationPath.empty())
+    {
+        auto directory = fs::path(configuration.calibrationPath) / name;
+
+        try
+        {
+            fs::create_directories(directory);
+            controller->setCalibrationDirectory(directory.string());
+        }
+        catch (const std::exception& ex)
+        {
+            logger->error("Cannot create the calibration directory for {}: {}", name, ex.what());
+        }
+    }
+
+    controller->setTestParameters(configuration.parameters);
+
+    QObject::connect(
+        controller,
+        &TestController::alert,
+        this,
+        [this, s](std::string message) {
+            emit alert(s->name, message);
+        }
+    );
+
+    QObject::connect(
+        controller,
+        &TestController::distributeTubeDataPacket,
+        this,
+        [this, s](TubeData data) {
+            s->latest[{ data.channel, data.index }] = data;
+            emit tubeData(s->name, data);
+        }
+    );
+
+    QObject::connect(
+        controller,
+        &TestController::distributeChannelStatus,
+        this,
+        [this, s](int channel, std::string status) {
+            emit channelStatus(s->name, channel, status);
+        }
+    );
+
+    QObject::connect(
+        controller,
+        &TestController::distributeTimeInfo,
+        this,
+        [this, s](std::string remaining) {
+            emit timeInfo(s->name, remaining);
+        }
+    );
+
+    // The report comes before finished, while the run is still current. The
+    // run id already starts with the station name.
+    QObject::connect(
+        controller,
+        &TestController::distributeRunReport,
+        this,
+        [this, s](RunReport report) {
+            if (s->writer)
+                s->writer->submitReport(fmt::format("run_{}.report.txt", s->runId), report.format());
+
+            emit runReport(s->name, report);
+        }
+    );
+
+    QObject::connect(
+        controller,
+        &TestController::finished,
+        this,
+        [this, s]() {
+            finish(*s);
+        }
+    );
+
+    controller->initializeTestConfiguration(configuration.normalConfig, configuration.reverseConfig);
+
+    station->writer = writerFor(configuration);
+    stationList.push_back(std::move(station));
+
+    logger->info("Station {} ready", name);
+    return true;
+}
+
+void Orchestrator::setBarcodes(const std::string& name, std::map<int, std::string> barcodes)
+{
+    if (auto* station = find(name))
+        station->barcodes = std::move(barcodes);
+}
+
+void Orchestrator::setUser(std::string user)
+{
+    this->user = user;
+}
+
+std::vector<std::string> Orchestrator::stations() const
+{
+    std::vector<std::string> names;
+
+    for (const auto& station : stationList)
+        names.push_back(station->name);
+
+    return names;
+}
+
+bool Orchestrator::isRunning() const
+{
+    return std::any_of(
+        stationList.begin(), 
+        stationList.end(), 
+        [](const auto& station) { return station->running; }
+    );
+}
+
+bool Orchestrator::start(std::string name, StationMode mode)
+{
+    auto* station = find(name);
+
+    if (!station)
+    {
+        logger->error("No station named {}", name);
+        return false;
+    }
+
+    if (station->running)
+    {
+        logger->warn("Station {} is already running", name);
+        return false;
+    }
+
+    const auto& configuration = station->configuration;
+
+    station->mode = mode;
+    station->latest.clear();
+    station->runId = fmt::format(
+        "{}_{}", 
+        name, 
+        QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss").toStdString()
+    );
+
+    switch (mode)
+    {
+    case StationMode::Normal:
+        station->channels = configuration.normalChannels;
+        break;
+    case StationMode::Reverse:
+        station->channels = configuration.reverseChannels;
+        break;
+    case StationMode::All:
+        station->channels = configuration.normalChannels;
+        station->channels.insert(
+            station->channels.end(), 
+            configuration.reverseChannels.begin(), 
+            configuration.reverseChannels.end()
+        );
+        break;
+    }
+
+    station->running = true;
+    station->controller->setRunId(station->runId);
+
+    if (mode == StationMode::All)
+    {
+        if (!station->controller->startAllChannels(configuration.normalChannels, configuration.reverseChannels))
+        {
+            station->running = false;
+            logger->error("Station {} cannot test all channels at once", name);
+            return false;
+        }
+    }
+    else
+    {
+        station->controller->start(station->channels, mode == StationMode::Reverse);
+    }
+
+    logger->info("Station {} started run {}", name, station->runId);
+    return true;
+}
+
+void Orchestrator::stop(std::string name)
+{
+    auto* station = find(name);
+
+    if (station && station->running)
+        station->controller->stop();
+}
+
+void Orchestrator::stopAll()
+{
+    for (auto& station : stationList)
+    {
+        if (station->running)
+            station->controller->stop();
+    }
+}
+
+Orchestrator::Station* Orchestrator::find(const std::string& name) const
+{
+    for (const auto& station : stationList)
+    {
+        if (station->name == name)
+            return station.get();
+    }
+
+    return nullptr;
+}
+
+ResultsWriter* Orchestrator::writerFor(const StationConfiguration& configuration)
+{
+    auto writer = writers.find(configuration.csvPath);
+
+    if (writer != writers.end())
+        return writer->second.get();
+
+    std::shared_ptr<ResultsStore> store;
+    auto existing = stores.find(configuration.storePath);
+
+    if (existing != stores.end())
+    {
+        store = existing->second;
+    }
+    else
+    {
+        try
+        {
+            store = std::make_shared<ResultsStore>(configuration.storePath);
+            stores[configuration.storePath] = store;
+        }
+        catch (const std::exception& ex)
+        {
+            logger->error("Cannot open the results store: {}", ex.what());
+        }
+    }
+
+    auto& created = writers[configuration.csvPath];
+    created = std::make_unique<ResultsWriter>(configuration.csvPath, store);
+
+    return created.get();
+}
+
+void Orchestrator::finish(Station& station)
+{
+    // The controller also reports finished when a new test replaces one that
+    // is still running, so only the first report of a run counts.
+    if (!station.running)
+        return;
+
+    station.running = false;
+
+    std::size_t written = 0;
+
+    // Only normal tests produce results, as in the GUI.
+    if (station.mode != StationMode::Reverse && station.writer)
+    {
+        auto now = QDateTime::currentDateTime();
+        auto date = now.toString("dd_MM_yyyy_hh_mm_ss").toStdString();
+        int tubesPerChannel = station.configuration.parameters.tubesPerChannel;
+
+        std::vector<ResultRecord> records;
+
+        for (const auto& [tube, barcode] : station.barcodes)
+        {
+            int k = tube / tubesPerChannel;
+
+            if (k >= static_cast<int>(station.channels.size()))
+            {
+                logger->warn("{}: tube {} ({}) is not on a tested channel", station.name, tube, barcode);
+                continue;
+            }
+
+            auto it = station.latest.find({ station.channels[k], tube % tubesPerChannel });
+
+            if (it == station.latest.end())
+            {
+                logger->warn("{}: no data for tube {} ({})", station.name, tube, barcode);
+                continue;
+            }
+
+            records.push_back({ barcode, date, user, it->second, station.runId, now.toSecsSinceEpoch() });
+        }
+
+        written = records.size();
+
+        if (!records.empty())
+            station.writer->submit(std::move(records));
+    }
+
+    logger->info("Station {} finished run {} with {} results", station.name, station.runId, written);
+    emit stationFinished(station.name, written);
+
+    if (!isRunning())
+    {
+        // Make sure everything is on disk before anyone is told we are done.
+        for (auto& [path, writer] : writers)
+            writer->flush();
+
+        emit allFinished();
+    }
+}
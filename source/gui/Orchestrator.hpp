@@ -0,0 +1,112 @@
+// Orchestrator.hpp
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include <memory>
+#include <utility>
+
+#include <QObject>
+
+#include <spdlog/spdlog.h>
+
+#include <results/ResultsStore.hpp>
+#include <results/ResultsWriter.hpp>
+
+#include "TestInfo.hpp"
+#include "RunReport.hpp"
+#include "Configuration.hpp"
+#include "TestController.hpp"
+
+enum class StationMode
+{
+    Normal,
+    Reverse,
+    All
+};
+
+// Runs several stations from one process. Each station is a PSU, a DCCH board
+// and the configuration that goes with them, driven by its own TestController,
+// and is started, stopped and reported on independently of the others.
+//
+// A test blocks its thread for the whole run, so every station keeps the test
+// thread its controller owns; all the rest (packets, results, scheduling) is
+// handled on the thread the orchestrator lives on. Stations that write to the
+// same results directory share one writer, and stations that share a results
+// store share one store, so their appends never interleave. Stations with the
+// same results directory must therefore have the same store; a station that
+// does not is refused.
+class Orchestrator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Orchestrator(QObject* parent = nullptr);
+    ~Orchestrator();
+
+    Orchestrator(const Orchestrator&) = delete;
+    Orchestrator(Orchestrator&&) = delete;
+
+    Orchestrator& operator=(const Orchestrator&) = delete;
+    Orchestrator& operator=(Orchestrator&&) = delete;
+
+    // Connects to the station and applies its configuration.
+    bool addStation(std::string name, StationConfiguration configuration);
+
+    // Physical tube numbers to barcodes. Tubes are numbered across the tested
+    // channels in order, tubesPerChannel at a time.
+    void setBarcodes(const std::string& name, std::map<int, std::string> barcodes);
+    void setUser(std::string user);
+
+    std::vector<std::string> stations() const;
+    bool isRunning() const;
+
+public slots:
+    bool start(std::string name, StationMode mode);
+    void stop(std::string name);
+    void stopAll();
+
+signals:
+    void tubeData(std::string station, TubeData data);
+    void channelStatus(std::string station, int channel, std::string status);
+    void timeInfo(std::string station, std::string remaining);
+    void alert(std::string station, std::string message);
+    void runReport(std::string station, RunReport report);
+
+    void stationFinished(std::string station, std::size_t results);
+    void allFinished();
+
+private:
+    struct Station
+    {
+        std::string name;
+        StationConfiguration configuration;
+        std::unique_ptr<TestController> controller;
+        ResultsWriter* writer { nullptr };
+
+        StationMode mode { StationMode::Normal };
+        std::vector<int> channels;
+        std::string runId;
+        bool running { false };
+
+        std::map<int, std::string> barcodes;
+        std::map<std::pair<int, int>, TubeData> latest;
+    };
+
+    Station* find(const std::string& name) const;
+    ResultsWriter* writerFor(const StationConfiguration& configuration);
+    void finish(Station& station);
+
+private:
+    std::string user;
+
+    // Declared before the stations so they outlive every controller.
+    std::map<std::string, std::shared_ptr<ResultsStore>> stores;
+    std::map<std::string, std::unique_ptr<ResultsWriter>> writers;
+
+    std::vector<std::unique_ptr<Station>> stationList;
+
+    std::shared_ptr<spdlog::logger> logger;
+};
@@ -0,0 +1,100 @@
+// RunReport.cpp
+
+#include "RunReport.hpp"
+
+#include <numeric>
+#include <algorithm>
+
+#include <fmt/core.h>
+
+const char* name(RunReport::Phase phase)
+{
+    switch (phase)
+    {
+        case RunReport::Phase::Ramping:     return "Ramping";
+        case RunReport::Phase::Switching:   return "Switching";
+        case RunReport::Phase::Waiting:     return "Waiting";
+        case RunReport::Phase::Sampling:    return "Sampling";
+        case RunReport::Phase::Idle:        return "Idle";
+    }
+
+    return "Unknown";
+}
+
+RunReport::Timer::Timer(RunReport& report, Phase phase, const instrumentation::Clock& clock):
+    report { report },
+    phase { phase },
+    clock { clock },
+    start { clock.now() }
+{}
+
+RunReport::Timer::~Timer()
+{
+    std::chrono::duration<double> elapsed = clock.now() - start;
+    report.phaseSeconds[static_cast<std::size_t>(phase)] += elapsed.count();
+}
+
+double RunReport::seconds(Phase phase) const
+{
+    return phaseSeconds[static_cast<std::size_t>(phase)];
+}
+
+double RunReport::otherSeconds() const
+{
+    double accounted = std::accumulate(phaseSeconds.begin(), phaseSeconds.end(), 0.00);
+    return std::max(totalSeconds - accounted, 0.00);
+}
+
+double RunReport::tubesPerHour() const
+{
+    return (totalSeconds > 0.00) ? tubesTested * 3600.00 / totalSeconds : 0.00;
+}
+
+int RunReport::fewestSamples() const
+{
+    if (samples.empty())
+        return 0;
+
+    return std::min_element(
+        samples.begin(),
+        samples.end(),
+        [](const auto& a, const auto& b) { return a.samples < b.samples; }
+    )->samples;
+}
+
+int RunReport::mostSamples() const
+{
+    if (samples.empty())
+        return 0;
+
+    return std::max_element(
+        samples.begin(),
+        samples.end(),
+        [](const auto& a, const auto& b) { return a.samples < b.samples; }
+    )->samples;
+}
+
+std::string RunReport::format() const
+{
+    auto text = fmt::format(
+        "Run took {:.1f} min: {} tubes, {:.1f} tubes per hour\n",
+        totalSeconds / 60.00,
+        tubesTested,
+        tubesPerHour()
+    );
+
+    for (std::size_t i = 0; i < phaseCount; ++i)
+    {
+        auto phase = static_cast<Phase>(i);
+        text += fmt::format("  {:<10} {:>8.1f} s\n", name(phase), seconds(phase));
+    }
+
+    text += fmt::format("  {:<10} {:>8.1f} s\n", "Other", otherSeconds());
+    text += fmt::format("collectData: mean {:.2f} ms, p99 {:.2f} ms\n", collectMean, collectP99);
+    text += fmt::format("Samples per tube: {} to {}\n", fewestSamples(), mostSamples());
+
+    for (const auto& tube : samples)
+        text += fmt::format("  Channel {} tube {} ({}): {}\n", tube.channel, tube.index, tube.tube, tube.samples);
+
+    return text;
+}
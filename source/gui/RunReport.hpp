@@ -0,0 +1,83 @@
+// RunReport.hpp
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include <instrumentation/Clock.hpp>
+
+// Samples taken while one tube was connected.
+struct TubeSampleCount
+{
+    int channel { -1 };
+    int index { -1 };
+    int tube { -1 };
+    int samples { 0 };
+};
+
+// Where the time of a run went, and how well sampling kept up. Put together
+// by the test as it runs and handed out when it finishes, to be shown next
+// to the results and written with them.
+struct RunReport
+{
+    enum class Phase
+    {
+        Ramping,
+        Switching,
+        Waiting,
+        Sampling,
+        Idle
+    };
+
+    static constexpr std::size_t phaseCount = 5;
+
+    // Adds the time it is alive, on `clock`, to one phase.
+    class Timer
+    {
+    public:
+        Timer(RunReport& report, Phase phase, const instrumentation::Clock& clock);
+        ~Timer();
+
+        Timer(const Timer&) = delete;
+        Timer(Timer&&) = delete;
+
+        Timer& operator=(const Timer&) = delete;
+        Timer& operator=(Timer&&) = delete;
+
+    private:
+        RunReport& report;
+        Phase phase;
+        const instrumentation::Clock& clock;
+        std::chrono::nanoseconds start;
+    };
+
+    double totalSeconds { 0.00 };
+    std::array<double, phaseCount> phaseSeconds {};
+
+    int tubesTested { 0 };
+
+    // collectData latency, in milliseconds.
+    double collectMean { 0.00 };
+    double collectP99 { 0.00 };
+
+    std::vector<TubeSampleCount> samples;
+
+    double seconds(Phase phase) const;
+
+    // Time not spent in any phase: signals, archiving and the like.
+    double otherSeconds() const;
+
+    double tubesPerHour() const;
+
+    int fewestSamples() const;
+    int mostSamples() const;
+
+    // A few lines of text, for the log and the report file.
+    std::string format() const;
+};
+
+const char* name(RunReport::Phase phase);
@@ -1,18 +1,27 @@
 // TestController.cpp
 
 #include <map>
+#include <cmath>
+#include <chrono>
+#include <algorithm>
+#include <string_view>
 
 #include <QString>
+#include <QDateTime>
 #include <QByteArray>
 #include <QMutexLocker>
-#include <QElapsedTimer>
 
 #include <fmt/core.h>
 #include <fmt/ranges.h>
 
 #include <spdlog/sinks/stdout_color_sinks.h>
 
+#include <analysis/SampleKernels.hpp>
+#include <archive/RunArchive.hpp>
+#include <instrumentation/Metrics.hpp>
+
 #include "TestController.hpp"
+#include "CalibrationCache.hpp"
 
 constexpr bool USE_HV_WRAPPER_STATUS { true };
 
@@ -31,27 +40,110 @@ constexpr uint32_t UNPLUGGED            { 1 << 11 };
 
 constexpr int timeout = 30000;
 
+// One phase of a run, both as a span of the trace and as time in the run
+// report.
+class Phase
+{
+public:
+    Phase(
+        instrumentation::Trace& trace,
+        RunReport& report,
+        const instrumentation::Clock& clock,
+        RunReport::Phase phase,
+        std::string_view name
+    ):
+        span { trace, name },
+        timer { report, phase, clock }
+    {}
+
+private:
+    instrumentation::Trace::Scope span;
+    RunReport::Timer timer;
+};
+
 TestController::TestController(QObject* parent):
     connection { false },
+    clock { &instrumentation::Clock::system() },
     testThread { new QThread },
     mutex { std::make_shared<QMutex>() },
-    controller { std::make_shared<PSUController>() },
-    logger { spdlog::stdout_color_mt("TestController") }
-{}
+    controller { std::make_shared<PSUController>() }
+{
+    // Several controllers can live in one process, one per station.
+    try
+    {
+        logger = spdlog::stdout_color_mt("TestController");
+    }
+    catch (const spdlog::spdlog_ex& ex)
+    {
+        logger = spdlog::get("TestController");
+    }
+}
 
 TestController::~TestController()
-{}
+{
+    // A running test would outlive its thread otherwise.
+    emit stopTest();
+    testThread->quit();
+    testThread->wait();
+    delete testThread;
+}
 
 bool TestController::checkConnection() const
 {
     return connection;
 }
 
+std::vector<int> TestController::availableChannels()
+{
+    int count = 4;
+
+    try
+    {
+        count = std::stoi(controller->getProperties().ChannelsAvailable);
+    }
+    catch (const std::exception& ex)
+    {
+        logger->debug("Channel count unknown, assuming {}", count);
+    }
+
+    std::vector<int> channels(count);
+
+    for (int i = 0; i < count; ++i)
+        channels[i] = i;
+
+    return channels;
+}
+
 void TestController::setTestParameters(TestParameters parameters)
 {
     this->parameters = parameters;
 }
 
+void TestController::setArchiveDirectory(std::string directory)
+{
+    this->archiveDirectory = directory;
+}
+
+void TestController::setTraceDirectory(std::string directory)
+{
+    this->traceDirectory = directory;
+}
+
+void TestController::setCalibrationDirectory(std::string directory)
+{
+    this->calibrationDirectory = directory;
+}
+
+void TestController::setRunId(std::string id)
+{
+    this->runId = id;
+}
+
+void TestController::setClock(instrumentation::Clock* clock)
+{
+    this->clock = clock;
+}
+
 void TestController::initializeTestConfiguration(TestConfiguration normal, TestConfiguration reverse)
 {
     this->normal = normal;
@@ -61,10 +153,11 @@ void TestController::initializeTestConfiguration(TestConfiguration normal, TestC
     std::vector<int> reverseChannels;
 
     std::vector<unsigned long> polarities;
+    auto channels = availableChannels();
 
     try
     {
-        polarities = controller->readPolarities({ 0, 1, 2, 3 });
+        polarities = controller->readPolarities(channels);
     }
     catch (const std::exception& ex)
     {
@@ -74,12 +167,24 @@ void TestController::initializeTestConfiguration(TestConfiguration normal, TestC
     }
 
 
-    for (int i = 0; i < 4; ++i)
+    for (int i = 0; i < channels.size(); ++i)
     {
         if (polarities[i])
-            reverseChannels.push_back(i);
+            reverseChannels.push_back(channels[i]);
         else
-            normalChannels.push_back(i);
+            normalChannels.push_back(channels[i]);
+    }
+
+    // The controller only writes what differs from what it last wrote, so
+    // make sure nobody changed the supply in the meantime.
+    try
+    {
+        if (!controller->verifyConfiguration(channels))
+            logger->warn("Channel configuration was changed outside of the program");
+    }
+    catch (const std::exception& ex)
+    {
+        logger->error("{}", ex.what());
     }
 
     try
@@ -90,10 +195,7 @@ void TestController::initializeTestConfiguration(TestConfiguration normal, TestC
         controller->setRampDownRate(normalChannels, normal.rampDownRate);
         controller->setOverCurrentLimits(normalChannels, normal.overCurrentLimit);
 
-        if (normal.powerDownMethod)
-            controller->killChannelsAfterTest(normalChannels, true);
-        else
-            controller->killChannelsAfterTest(normalChannels, false);
+        controller->killChannelsAfterTest(normalChannels, normal.powerDownMethod);
 
         controller->setTestVoltages(reverseChannels, reverse.testVoltage);
         controller->setMaxVoltages(reverseChannels, reverse.maxVoltage);
@@ -101,10 +203,7 @@ void TestController::initializeTestConfiguration(TestConfiguration normal, TestC
         controller->setRampDownRate(reverseChannels, reverse.rampDownRate);
         controller->setOverCurrentLimits(reverseChannels, reverse.overCurrentLimit);
 
-        if (reverse.powerDownMethod)
-            controller->killChannelsAfterTest(reverseChannels, true);
-        else
-            controller->killChannelsAfterTest(reverseChannels, true);
+        controller->killChannelsAfterTest(reverseChannels, reverse.powerDownMethod);
     }
     catch (const std::exception& ex)
     {
@@ -165,6 +264,11 @@ void TestController::createNewTest()
 
     // this->testThread = new QThread;
     Test* test = new Test;
+    test->setArchiveDirectory(archiveDirectory);
+    test->setTraceDirectory(traceDirectory);
+    test->setCalibrationDirectory(calibrationDirectory);
+    test->setRunId(runId);
+    test->setClock(clock);
 
     test->moveToThread(testThread);
 
@@ -209,6 +313,22 @@ void TestController::createNewTest()
         }
     );
 
+    QObject::connect(
+        test,
+        &Test::distributeRunReport,
+        [this](RunReport report) {
+            emit distributeRunReport(report);
+        }
+    );
+
+    QObject::connect(
+        test,
+        &Test::alert,
+        [this](std::string message) {
+            emit alert(message);
+        }
+    );
+
     QObject::connect(
         this,
         &TestController::stopTest,
@@ -248,12 +368,7 @@ void TestController::start(std::vector<int> channels, bool mode)
 
     createNewTest();
 
-    TestConfiguration config;
-
-    if (mode)
-        config = this->reverse;
-    else
-        config = this->normal;
+    std::vector<TestConfiguration> configurations(channels.size(), mode ? this->reverse : this->normal);
 
     testThread->start();
 
@@ -264,8 +379,59 @@ void TestController::start(std::vector<int> channels, bool mode)
         controller.get(),
         channels,
         parameters,
-        config
+        configurations
+    );
+}
+
+bool TestController::startAllChannels(std::vector<int> normalChannels, std::vector<int> reverseChannels)
+{
+    logger->debug("Call to startAllChannels");
+
+    // Tubes are numbered across the combined list: the normal channels take
+    // the first blocks of tubes and the reverse channels the blocks after.
+    // Sharing positions between the polarities, as separate passes do, would
+    // put one tube on two channels at once.
+    std::vector<int> channels = normalChannels;
+    channels.insert(channels.end(), reverseChannels.begin(), reverseChannels.end());
+
+    std::size_t positions = static_cast<std::size_t>(std::max(parameters.tubesPerChannel, 0)) * channels.size();
+
+    if (positions > dcchPositions)
+    {
+        auto msg = fmt::format(
+            "Testing {} channels with {} tubes each needs {} tube positions, but the DCCH board has {}. Test the polarities separately or with fewer tubes per channel.",
+            channels.size(),
+            parameters.tubesPerChannel,
+            positions,
+            dcchPositions
+        );
+
+        logger->error(msg);
+        emit alert(msg);
+        return false;
+    }
+
+    if (testThread->isRunning())
+        emit stopTest();
+
+    createNewTest();
+
+    std::vector<TestConfiguration> configurations(normalChannels.size(), this->normal);
+    configurations.insert(configurations.end(), reverseChannels.size(), this->reverse);
+
+    testThread->start();
+
+    emit executeTestInThread(
+        false,
+        mutex.get(),
+        DCCHPort,
+        controller.get(),
+        channels,
+        parameters,
+        configurations
     );
+
+    return true;
 }
 
 void TestController::stop()
@@ -274,7 +440,7 @@ void TestController::stop()
     emit stopTest();
 }
 
-static std::string interpretStatus(unsigned long status)
+std::string interpretStatus(unsigned long status)
 {
     std::string status_str = "";
 
@@ -321,7 +487,9 @@ static std::string interpretStatus(unsigned long status)
 
 Test::Test(QObject* parent):
     QObject(parent),
-    stopFlag { false }
+    clock { &instrumentation::Clock::system() },
+    stopFlag { false },
+    failedPolls { 0 }
 {
     try
     {
@@ -338,6 +506,31 @@ Test::~Test()
     logger->debug("TEST DESTROYED");
 }
 
+void Test::setArchiveDirectory(std::string directory)
+{
+    this->archiveDirectory = directory;
+}
+
+void Test::setClock(instrumentation::Clock* clock)
+{
+    this->clock = clock;
+}
+
+void Test::setTraceDirectory(std::string directory)
+{
+    this->traceDirectory = directory;
+}
+
+void Test::setCalibrationDirectory(std::string directory)
+{
+    this->calibrationDirectory = directory;
+}
+
+void Test::setRunId(std::string id)
+{
+    this->runId = id;
+}
+
 void Test::stop()
 {
     stopFlag = true;
@@ -351,7 +544,7 @@ void Test::test(
     PSUController* controller,
     std::vector<int> channels,
     TestParameters parameters,
-    TestConfiguration config
+    std::vector<TestConfiguration> configurations
 )
 {
     logger->info("Starting Test");
@@ -363,19 +556,19 @@ void Test::test(
 
     QMutexLocker controlLocker(mutex);
 
-    QElapsedTimer timer;
-    timer.start();
+    auto started = clock->now();
 
 #ifndef Q_OS_WIN
     DCCHController serial(this, DCCHPort);
 #else
-    DCCHController serial(DCCHPort);
+    DCCHController serial(DCCHPort, *clock);
 #endif
 
-    int rampTime = config.testVoltage / config.rampUpRate;
+    // The test waits for the slowest ramp of any channel.
+    int rampTime = 1;
 
-    if (rampTime < 1)
-        rampTime = 1;
+    for (const auto& config : configurations)
+        rampTime = std::max(rampTime, config.testVoltage / std::max(config.rampUpRate, 1));
 
     if (mode)
     {
@@ -384,44 +577,119 @@ void Test::test(
         return;
     }
 
+    // Phases go on the first track, and what happens to the tubes of each
+    // channel on a track of its own.
+    trace.reset(!traceDirectory.empty(), *clock);
+    traceStamp = QDateTime::currentDateTime().toString("yyyyMMdd_hhmmss").toStdString();
+    trace.nameTrack(0, "Test");
+
+    for (int channel : channels)
+        trace.nameTrack(channel + 1, fmt::format("Channel {}", channel));
+
+    report = RunReport();
+    collectLatency.reset();
+
     std::vector<int> physicalTubeNumber(channels.size());
+    std::vector<std::size_t> tubeSpans(channels.size(), instrumentation::Trace::none);
 
     // We're going to share data storage, in order to save.
     std::vector<TubeData> data(channels.size());
     std::vector<float> currents(channels.size(), -1.00f);
     std::vector<float> voltages(channels.size(), -1.00f);
+    std::vector<unsigned long> rawStatuses(channels.size(), 0xFFFFFFFF);
     std::vector<std::string> statuses(channels.size(), interpretStatus(0xFFFFFFFF));
+    ChannelSet channelSet(channels);
 
     int numberOfTubesConnected = parameters.tubesPerChannel * channels.size();
 
-    for (int tube = 0; tube < numberOfTubesConnected; ++tube)
     {
-        serial.disconnectTube(tube);
-        QThread::msleep(delay);
+        Phase phase(trace, report, *clock, RunReport::Phase::Switching, "Disconnect all tubes");
+
+        for (int tube = 0; tube < numberOfTubesConnected; ++tube)
+        {
+            serial.disconnectTube(tube);
+            clock->sleep(std::chrono::milliseconds(delay));
+        }
     }
 
     if (stopFlag)
     {
+        finishRun(started);
         emit finished();
         logger->info("Test is complete");
         return;
     }
 
-    auto polarities = controller->readPolarities(channels);
+    {
+        Phase phase(trace, report, *clock, RunReport::Phase::Sampling, "Read polarities");
+
+        auto polarities = controller->readPolarities(channels);
+
+        for (int k = 0; k < channels.size(); ++k)
+            emit distributeChannelPolarity(channels[k], polarities[k]);
+    }
+
+    // Each channel as set on the supply. Nothing is powered yet, so a run
+    // that cannot read them ends here.
+    std::vector<float> setVoltages(channels.size(), 0.00f);
+
+    if (auto read = controller->tryGetTestVoltages(channelSet, setVoltages); !read)
+    {
+        logger->error("Cannot read the test voltages: {}", read.error().message());
+        emit alert("Cannot read the test voltages from the power supply. The test was stopped.");
+
+        finishRun(started);
+        emit finished();
+        return;
+    }
+
+    std::vector<int> testVoltages;
+
+    for (float voltage : setVoltages)
+        testVoltages.push_back(static_cast<int>(std::lround(voltage)));
 
-    for (int k = 0; k < channels.size(); ++k)
-        emit distributeChannelPolarity(channels[k], polarities[k]);
+    auto currentOffset = getIntrinsicCurrent(channels, controller, parameters, testVoltages, rampTime);
 
-    auto currentOffset = getIntrinsicCurrent(channels, controller, parameters, rampTime);
+    auto runSeconds = [this, started] { return std::chrono::duration<double>(clock->now() - started).count(); };
+
+    OffsetBaseline baseline(channels.size());
+    baseline.add(runSeconds(), currentOffset);
 
     if (stopFlag)
     {
+        finishRun(started);
         emit finished();
         controller->powerOffChannels(channels);
         logger->info("Test is complete");
         return;
     }
 
+    std::unique_ptr<RunArchiveWriter> archive;
+
+    if (!archiveDirectory.empty())
+    {
+        auto now = QDateTime::currentDateTime();
+        auto path = fmt::format("{}/run_{}.dccsrun", archiveDirectory, now.toString("yyyyMMdd_hhmmss").toStdString());
+
+        ArchiveHeader header;
+        header.mode = mode;
+        header.parameters = parameters;
+        header.configurations = configurations;
+        header.channels = channels;
+        header.startTime = now.toSecsSinceEpoch();
+        header.runId = runId;
+
+        try
+        {
+            archive = std::make_unique<RunArchiveWriter>(path, header);
+            logger->info("Archiving samples to {}", path);
+        }
+        catch (const std::exception& ex)
+        {
+            logger->error("Cannot create the run archive: {}", ex.what());
+        }
+    }
+
     int s = 0;
     auto elapsedTime = fmt::format("{} s", s);
     auto remainingTime = fmt::format("{} s", s);
@@ -429,21 +697,72 @@ void Test::test(
     // controller->powerOnChannels(channels);
     // QThread::sleep(rampTime);
 
+    // With re-baselining, tubes are archived and handed out for the results
+    // once the measurement after them is known, see settleTubes.
+    bool rebaselining = parameters.rebaselineEveryTubes > 0;
+    std::vector<PendingTube> pending;
+    constexpr std::size_t notPending = static_cast<std::size_t>(-1);
+    std::vector<std::size_t> pendingOf(channels.size(), notPending);
+    std::vector<float> rawCurrents(channels.size(), 0.00f);
+
     for (int i = 0; i < parameters.tubesPerChannel; ++i)
     {
         if (stopFlag)
             break;
 
-        for (int k = 0; k < channels.size(); ++k)
+        // Every tube of the last block was switched off, so the channels
+        // read their intrinsic current alone.
+        if (i > 0 && rebaselining && i % parameters.rebaselineEveryTubes == 0)
         {
+            if (remeasureIntrinsicCurrent(channelSet, controller, parameters, started, baseline))
+                settleTubes(pending, baseline, archive.get());
+
             if (stopFlag)
                 break;
+        }
 
-            physicalTubeNumber[k] = (parameters.tubesPerChannel * k) + i;
-            serial.connectTube(physicalTubeNumber[k]);
-            QThread::msleep(delay);
+        baseline.at(runSeconds(), currentOffset);
+
+        auto tubeSpan = trace.begin(fmt::format("Tube {}", i));
+
+        std::fill(pendingOf.begin(), pendingOf.end(), notPending);
+
+        {
+            Phase phase(trace, report, *clock, RunReport::Phase::Switching, "Switch on");
+
+            for (int k = 0; k < channels.size(); ++k)
+            {
+                if (stopFlag)
+                    break;
+
+                physicalTubeNumber[k] = (parameters.tubesPerChannel * k) + i;
+                tubeSpans[k] = trace.begin(fmt::format("Tube {}", physicalTubeNumber[k]), channels[k] + 1);
+
+                {
+                    instrumentation::Trace::Scope span(trace, "Switch on", channels[k] + 1);
+
+                    serial.connectTube(physicalTubeNumber[k]);
+                    clock->sleep(std::chrono::milliseconds(delay));
+                }
+
+                data[k].statistics.reset();
+
+                if (rebaselining)
+                {
+                    pendingOf[k] = pending.size();
+                    pending.push_back({ .slot = static_cast<std::size_t>(k), .physicalTube = physicalTubeNumber[k], .started = runSeconds() });
+                }
+                else if (archive)
+                {
+                    archive->beginTube(channels[k], i, physicalTubeNumber[k], currentOffset[k]);
+                }
+            }
         }
 
+        auto tubeStarted = clock->now();
+
+        auto dwellSpan = trace.begin("Dwell");
+
         for (int t = 0; t < parameters.secondsPerTube; ++t)
         {
             if (stopFlag)
@@ -453,7 +772,47 @@ void Test::test(
             // elapsedTime = fmt::format("{} s", s);
             remainingTime = fmt::format("{} s", (parameters.tubesPerChannel - i) * parameters.secondsPerTube);
 
-            collectData(channels, controller, voltages, currents, statuses);
+            bool collected = false;
+
+            {
+                Phase phase(trace, report, *clock, RunReport::Phase::Sampling, "collectData");
+
+                auto start = std::chrono::steady_clock::now();
+                collected = collectData(channelSet, controller, voltages, currents, rawStatuses, statuses);
+                collectLatency.record(std::chrono::steady_clock::now() - start);
+            }
+
+            // The link dropped. The tube stays connected and picks up where it
+            // left off once the supply is back, rather than the whole board
+            // being tested again.
+            if (!collected && !controller->isConnected())
+            {
+                Phase phase(trace, report, *clock, RunReport::Phase::Waiting, "Reconnect");
+
+                if (!resume(controller, rampTime))
+                    break;
+
+                --t;
+                continue;
+            }
+
+            // The supply answered but a reading failed. The buffers still
+            // hold the last sample, with its offsets already added, so none of
+            // it is recorded again.
+            if (!collected)
+            {
+                RunReport::Timer idle(report, RunReport::Phase::Idle, *clock);
+                clock->sleep(std::chrono::seconds(1));
+                continue;
+            }
+
+            double sampled = runSeconds();
+
+            if (rebaselining)
+                std::copy(currents.begin(), currents.end(), rawCurrents.begin());
+
+            baseline.at(sampled, currentOffset);
+            SampleKernels::addOffsets(currents, currentOffset);
 
             for (int k = 0; k < channels.size(); ++k)
             {
@@ -465,118 +824,435 @@ void Test::test(
                 data[k].isActive = true;
 
                 data[k].voltage = voltages[k];
-                data[k].current = currents[k] + currentOffset[k];
+                data[k].current = currents[k];
 
                 data[k].intrinsicCurrent = currentOffset[k];
 
+                double time = std::chrono::duration<double>(clock->now() - tubeStarted).count();
+                data[k].statistics.update(data[k].current, time);
+
+                if (rebaselining)
+                {
+                    auto& tube = pending[pendingOf[k]];
+                    tube.runTimes.push_back(sampled);
+                    tube.tubeTimes.push_back(static_cast<float>(time));
+                    tube.currents.push_back(rawCurrents[k]);
+                    tube.voltages.push_back(voltages[k]);
+                }
+                else if (archive)
+                {
+                    archive->addSample(channels[k], time, data[k].current, data[k].voltage);
+                }
+
                 emit distributeTubeDataPacket(data[k]);
                 emit distributeChannelStatus(data[k].channel, statuses[k]);
                 emit distributeTimeInfo(remainingTime);
             }
 
-            QThread::sleep(1);
+            {
+                RunReport::Timer idle(report, RunReport::Phase::Idle, *clock);
+                clock->sleep(std::chrono::seconds(1));
+            }
         }
 
+        trace.end(dwellSpan);
+
+        auto switchSpan = trace.begin("Switch off");
+
         for (int k = 0; k < channels.size(); ++k)
         {
-            serial.disconnectTube(physicalTubeNumber[k]);
-            QThread::msleep(delay);
+            {
+                RunReport::Timer switching(report, RunReport::Phase::Switching, *clock);
+                instrumentation::Trace::Scope span(trace, "Switch off", channels[k] + 1);
+
+                serial.disconnectTube(physicalTubeNumber[k]);
+                clock->sleep(std::chrono::milliseconds(delay));
+            }
+
+            trace.end(tubeSpans[k]);
+
+            report.samples.push_back({ channels[k], i, physicalTubeNumber[k], data[k].statistics.count });
+            ++report.tubesTested;
+
             data[k].isActive = false;
             emit distributeTubeDataPacket(data[k]);
+
+            if (rebaselining && pendingOf[k] != notPending)
+            {
+                auto& tube = pending[pendingOf[k]];
+                tube.data = data[k];
+                tube.data.channel = channels[k];
+                tube.data.index = i;
+            }
+            else if (!rebaselining && archive)
+            {
+                archive->endTube(channels[k]);
+            }
         }
+
+        trace.end(switchSpan);
+        trace.end(tubeSpan);
     }
 
-    for (int tube = 0; tube < numberOfTubesConnected; ++tube)
     {
-        serial.disconnectTube(tube);
-        QThread::msleep(delay);
+        Phase phase(trace, report, *clock, RunReport::Phase::Switching, "Disconnect all tubes");
+
+        for (int tube = 0; tube < numberOfTubesConnected; ++tube)
+        {
+            serial.disconnectTube(tube);
+            clock->sleep(std::chrono::milliseconds(delay));
+        }
     }
 
-    controller->powerOffChannels(channels);
-    QThread::sleep(rampTime);
+    // The last block is closed by a measurement of its own, unless the run
+    // was stopped, in which case it keeps the latest offsets.
+    if (!pending.empty())
+    {
+        if (!stopFlag)
+            remeasureIntrinsicCurrent(channelSet, controller, parameters, started, baseline);
+
+        settleTubes(pending, baseline, archive.get());
+    }
+
+    try
+    {
+        Phase phase(trace, report, *clock, RunReport::Phase::Ramping, "Power down");
+
+        controller->powerOffChannels(channels);
+        clock->sleep(std::chrono::seconds(rampTime));
+    }
+    catch (const std::exception& ex)
+    {
+        logger->error("Cannot power off the channels: {}", ex.what());
+    }
+
+    finishRun(started);
 
     emit finished();
     logger->info("Test is complete");
+
+    // Covers every station in the process, not only this test.
+    logger->info("Hardware call latencies:\n{}", instrumentation::Metrics::global().report());
+}
+
+void Test::finishRun(std::chrono::nanoseconds started)
+{
+    writeTrace();
+
+    auto latency = collectLatency.summary();
+
+    report.totalSeconds = std::chrono::duration<double>(clock->now() - started).count();
+    report.collectMean = latency.mean / 1E6;
+    report.collectP99 = latency.p99 / 1E6;
+
+    logger->info("Run report:\n{}", report.format());
+    emit distributeRunReport(report);
+}
+
+void Test::writeTrace()
+{
+    if (!trace.enabled())
+        return;
+
+    auto path = fmt::format("{}/run_{}.trace.json", traceDirectory, traceStamp);
+
+    try
+    {
+        trace.write(path);
+        logger->info("Wrote the timeline of the test to {}", path);
+    }
+    catch (const std::exception& ex)
+    {
+        logger->error("Cannot write the trace: {}", ex.what());
+    }
+}
+
+bool Test::resume(PSUController* controller, int rampTime)
+{
+    logger->warn("Lost the power supply. Pausing the test");
+    emit alert("Lost the connection to the power supply. The test is paused while reconnecting.");
+
+    if (!controller->reconnect(stopFlag))
+    {
+        stopFlag = true;
+        emit alert("Cannot reconnect to the power supply. The test was stopped.");
+        return false;
+    }
+
+    // Channels that were switched back on have to ramp up again.
+    clock->sleep(std::chrono::seconds(rampTime));
+
+    logger->info("Resuming the test");
+    emit alert("Reconnected to the power supply. The test has resumed.");
+    return true;
 }
 
 std::vector<float> Test::getIntrinsicCurrent(
     std::vector<int>& channels,
     PSUController* controller,
     TestParameters& parameters,
+    const std::vector<int>& testVoltages,
     int rampTime
 )
 {
     logger->info("Performing offset calculation for channels: [ {} ]", fmt::join(channels, ", "));
 
+    instrumentation::Trace::Scope measurement(trace, "Offset measurement");
+
     std::vector<float> currentOffsets(channels.size(), 0.00f);
     // std::vector<float> testVoltages(channels.size(), 0.00f);
 
     // testVoltages = controller->getTestVoltages(channels);
     // controller->setTestVoltages(channels, 0.00f);
-    controller->powerOnChannels(channels);
-    QThread::sleep(rampTime);
-    QThread::sleep(parameters.timeForTestingVoltage);
-    currentOffsets = controller->readCurrents(channels);
+    {
+        Phase phase(trace, report, *clock, RunReport::Phase::Ramping, "Power on");
+        controller->powerOnChannels(channels);
+    }
+    {
+        Phase phase(trace, report, *clock, RunReport::Phase::Ramping, "Ramp");
+        clock->sleep(std::chrono::seconds(rampTime));
+    }
+
+    // Ages are wall-clock time, since they span runs and restarts.
+    std::unique_ptr<CalibrationCache> cache;
+    std::vector<float> cached;
+    auto now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::system_clock::now().time_since_epoch()
+    ).count();
+
+    if (!calibrationDirectory.empty())
+    {
+        cache = std::make_unique<CalibrationCache>(calibrationDirectory);
+
+        for (std::size_t k = 0; k < channels.size(); ++k)
+        {
+            auto entry = cache->find(channels[k], testVoltages[k]);
+
+            if (!entry || now - entry->measured > parameters.calibrationMaxAgeHours * 3600LL)
+                break;
+
+            cached.push_back(entry->offset);
+        }
+
+        if (cached.size() != channels.size())
+            cached.clear();
+    }
+
+    int settle = parameters.timeForTestingVoltage;
+
+    if (!cached.empty())
+    {
+        int verify = std::min(parameters.calibrationVerifySeconds, settle);
+
+        {
+            Phase phase(trace, report, *clock, RunReport::Phase::Waiting, "Verify settle");
+            clock->sleep(std::chrono::seconds(verify));
+        }
+        {
+            Phase phase(trace, report, *clock, RunReport::Phase::Sampling, "Verify offsets");
+            currentOffsets = controller->readCurrents(channels);
+        }
+
+        SampleKernels::scale(currentOffsets, 1E3f);
+
+        bool agrees = true;
+
+        for (std::size_t k = 0; k < channels.size(); ++k)
+            agrees = agrees && std::abs(currentOffsets[k] - cached[k]) <= parameters.calibrationTolerance;
+
+        if (agrees)
+        {
+            logger->info("Cached offsets agree with [ {} ], using them: [ {} ]", fmt::join(currentOffsets, ", "), fmt::join(cached, ", "));
+            return cached;
+        }
+
+        logger->warn("Offsets drifted from the cache ([ {} ] against [ {} ]), measuring them again", fmt::join(currentOffsets, ", "), fmt::join(cached, ", "));
+        settle -= verify;
+    }
+
+    {
+        Phase phase(trace, report, *clock, RunReport::Phase::Waiting, "Settle");
+        clock->sleep(std::chrono::seconds(settle));
+    }
+    {
+        Phase phase(trace, report, *clock, RunReport::Phase::Sampling, "Read offsets");
+        currentOffsets = controller->readCurrents(channels);
+    }
     // controller->powerOffChannels(channels);
 
-    for (auto& i : currentOffsets)
-        i *= 1E3;
+    SampleKernels::scale(currentOffsets, 1E3f);
 
     logger->info("Offset are: [ {} ]", fmt::join(currentOffsets, ", "));
 
+    if (cache && !stopFlag)
+    {
+        for (std::size_t k = 0; k < channels.size(); ++k)
+            cache->store({ channels[k], testVoltages[k], currentOffsets[k], now });
+
+        try
+        {
+            cache->save();
+        }
+        catch (const std::exception& ex)
+        {
+            logger->error("Cannot save the offset calibration: {}", ex.what());
+        }
+    }
+
     // for (int k = 0; k < channels.size(); ++k)
     // controller->setTestVoltages({ k }, testVoltages[k]);
 
     return currentOffsets;
 }
 
-void Test::collectData(
-    std::vector<int> ch,
-    PSUController* con,
-    std::vector<float>& voltages,
-    std::vector<float>& currents,
-    std::vector<std::string>& statuses
+bool Test::remeasureIntrinsicCurrent(
+    const ChannelSet& channels,
+    PSUController* controller,
+    TestParameters& parameters,
+    std::chrono::nanoseconds started,
+    OffsetBaseline& baseline
 )
 {
-    // Current, Voltage, Status
+    instrumentation::Trace::Scope measurement(trace, "Offset remeasurement");
 
-    // std::vector<float> voltages(channels.size(), -1.00f);
-    // std::vector<float> currents(channels.size(), -1.00f);
-    // std::vector<unsigned long> raw_statuses(channels.size(), 0xFFFFFFFF);
-    std::vector<unsigned long> raw_statuses;
-
-    try
     {
-        currents = con->readCurrents(ch);
+        Phase phase(trace, report, *clock, RunReport::Phase::Waiting, "Settle");
+        clock->sleep(std::chrono::seconds(parameters.rebaselineSeconds));
     }
-    catch (std::exception& ex)
+
+    std::vector<float> offsets(channels.size(), 0.00f);
+    std::vector<float> sum(channels.size(), 0.00f);
+    std::expected<void, HVError> read;
+
+    int reads = 0;
+    double first = 0.00;
+    double last = 0.00;
+
+    for (int r = 0; r < std::max(parameters.rebaselineReads, 1) && !stopFlag; ++r)
     {
-        logger->error("Cannot read currents");
+        if (r > 0)
+        {
+            RunReport::Timer idle(report, RunReport::Phase::Idle, *clock);
+            clock->sleep(std::chrono::seconds(1));
+        }
+
+        {
+            Phase phase(trace, report, *clock, RunReport::Phase::Sampling, "Read offsets");
+            read = controller->tryReadCurrents(channels, offsets);
+        }
+
+        if (!read)
+        {
+            logger->warn("An offset read failed: {}", read.error().message());
+            continue;
+        }
+
+        last = std::chrono::duration<double>(clock->now() - started).count();
+
+        if (reads++ == 0)
+            first = last;
+
+        for (std::size_t k = 0; k < channels.size(); ++k)
+            sum[k] += offsets[k];
     }
 
-    try
+    if (reads == 0)
     {
-        voltages = con->readVoltages(ch);
+        logger->warn("Cannot measure the offsets again, keeping the last ones");
+        return false;
     }
-    catch (std::exception& ex)
+
+    // The mean is taken to hold at the middle of the reads.
+    for (std::size_t k = 0; k < channels.size(); ++k)
+        offsets[k] = sum[k] / reads;
+
+    SampleKernels::scale(offsets, 1E3f);
+    baseline.add((first + last) / 2.00, offsets);
+
+    logger->info("Offsets are now: [ {} ] (mean of {} reads)", fmt::join(offsets, ", "), reads);
+    return true;
+}
+
+void Test::settleTubes(std::vector<PendingTube>& pending, const OffsetBaseline& baseline, RunArchiveWriter* archive)
+{
+    for (auto& tube : pending)
     {
-        logger->error("Cannot read voltages");
+        auto& data = tube.data;
+        data.statistics.reset();
+
+        if (archive)
+            archive->beginTube(data.channel, data.index, tube.physicalTube, baseline.at(tube.started, tube.slot));
+
+        for (std::size_t s = 0; s < tube.currents.size(); ++s)
+        {
+            float offset = baseline.at(tube.runTimes[s], tube.slot);
+
+            data.current = tube.currents[s] + offset;
+            data.voltage = tube.voltages[s];
+            data.intrinsicCurrent = offset;
+            data.statistics.update(data.current, tube.tubeTimes[s]);
+
+            if (archive)
+                archive->addSample(data.channel, tube.tubeTimes[s], data.current, data.voltage);
+        }
+
+        if (archive)
+            archive->endTube(data.channel);
+
+        // A tube with no samples was handed out as it is.
+        if (tube.currents.empty())
+            continue;
+
+        data.isActive = false;
+        emit distributeTubeDataPacket(data);
     }
 
-    try
+    pending.clear();
+}
+
+bool Test::collectData(
+    const ChannelSet& ch,
+    PSUController* con,
+    std::span<float> voltages,
+    std::span<float> currents,
+    std::span<unsigned long> rawStatuses,
+    std::vector<std::string>& statuses
+)
+{
+    // Current, Voltage, Status
+    auto readCurrents = con->tryReadCurrents(ch, currents);
+    auto readVoltages = con->tryReadVoltages(ch, voltages);
+    auto readStatuses = con->tryReadStatuses(ch, rawStatuses);
+
+    const HVError* error = nullptr;
+
+    if (!readCurrents)
+        error = &readCurrents.error();
+    else if (!readVoltages)
+        error = &readVoltages.error();
+    else if (!readStatuses)
+        error = &readStatuses.error();
+
+    if (error)
     {
-        raw_statuses = con->readStatuses(ch);
+        if (failedPolls++ == 0)
+            logger->error("Cannot read from the power supply: {}", error->message());
+        else if (logger->should_log(spdlog::level::debug))
+            logger->debug("Still cannot read from the power supply: {}", error->message());
     }
-    catch (std::exception& ex)
+    else if (failedPolls)
     {
-        logger->error("Cannot read raw statuses");
+        logger->info("Power supply readings recovered after {} failed polls", failedPolls);
+        failedPolls = 0;
     }
 
     for (int i = 0; i < ch.size(); ++i)
-        statuses[i] = interpretStatus(raw_statuses[i]);
+        statuses[i] = interpretStatus(rawStatuses[i]);
+
+    if (readCurrents)
+        SampleKernels::scale(currents, 1E3f);
 
-    for (auto& i : currents)
-        i *= 1E3;
+    return !error;
 }
 
 void Test::reverseTest(
@@ -610,7 +1286,7 @@ void Test::reverseTest(
 
             physicalTubeNumber[k] = (parameters.tubesPerChannel * k) + i;
             serial.connectTube(physicalTubeNumber[k]);
-            QThread::msleep(delay);
+            clock->sleep(std::chrono::milliseconds(delay));
         }
     }
 
@@ -630,7 +1306,7 @@ void Test::reverseTest(
 
             physicalTubeNumber[k] = (parameters.tubesPerChannel * k) + i;
             serial.disconnectTube(physicalTubeNumber[k]);
-            QThread::msleep(delay);
+            clock->sleep(std::chrono::milliseconds(delay));
         }
     }
 
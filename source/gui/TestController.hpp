@@ -1,6 +1,8 @@
 #pragma once
 
+#include <span>
 #include <atomic>
+#include <chrono>
 #include <string>
 #include <vector>
 #include <memory>
@@ -16,10 +18,20 @@
 
 #include <psu/Port.hpp>
 #include <psu/PSUController.hpp>
+#include <analysis/OffsetBaseline.hpp>
+#include <instrumentation/Clock.hpp>
+#include <instrumentation/Trace.hpp>
+#include <instrumentation/LatencyHistogram.hpp>
 
 #include "TestInfo.hpp"
+#include "RunReport.hpp"
 #include "DCCHController.hpp"
 
+class RunArchiveWriter;
+
+// The status bits of a channel as text, e.g. "| ON | RAMP_UP |".
+std::string interpretStatus(unsigned long status);
+
 class TestController : public QObject
 {
     Q_OBJECT
@@ -36,14 +48,32 @@ public:
 
     bool checkConnection() const;
 
+    // Channels reported by the power supply. Falls back to the four channels
+    // of a single N1470 board when the crate map is not known.
+    std::vector<int> availableChannels();
+
     void setTestParameters(TestParameters parameters);
+    void setArchiveDirectory(std::string directory);
+    void setTraceDirectory(std::string directory);
+    void setCalibrationDirectory(std::string directory);
+    void setRunId(std::string id);
     void initializeTestConfiguration(TestConfiguration normal, TestConfiguration reverse);
 
+    // The clock that tests started from now on run on. Must outlive them.
+    void setClock(instrumentation::Clock* clock);
+
 public slots:
     bool connect(msu_smdt::Port PSUPort, msu_smdt::Port DCCHPort);
     bool disconnect();
 
     void start(std::vector<int> activeChannels, bool mode);
+
+    // Tests both polarities in one pass. Each channel keeps the configuration
+    // that initializeTestConfiguration applied for its polarity. The tubes
+    // of every channel need a position of their own on the DCCH board, so
+    // nothing is started, and false returned, when there are not enough.
+    bool startAllChannels(std::vector<int> normalChannels, std::vector<int> reverseChannels);
+
     void stop();
 
 signals:
@@ -51,6 +81,7 @@ signals:
     void distributeChannelPolarity(int channel, int polarity);
     void distributeTubeDataPacket(TubeData data);
     void distributeTimeInfo(std::string remaining);
+    void distributeRunReport(RunReport report);
 
     void stopTest();
 
@@ -63,7 +94,7 @@ signals:
         PSUController* controller,
         std::vector<int> channels,
         TestParameters parameters,
-        TestConfiguration config
+        std::vector<TestConfiguration> configurations
     );
 
     void finished();
@@ -77,6 +108,11 @@ private:
     TestConfiguration normal;
     TestConfiguration reverse;
     TestParameters parameters;
+    std::string archiveDirectory;
+    std::string traceDirectory;
+    std::string calibrationDirectory;
+    std::string runId;
+    instrumentation::Clock* clock;
     
     QThread* testThread;
     std::shared_ptr<QMutex> mutex;
@@ -92,7 +128,26 @@ public:
     explicit Test(QObject* parent = nullptr);
     ~Test();
 
+    // Where to put the binary archive of the samples. Empty disables it.
+    void setArchiveDirectory(std::string directory);
+
+    // Where to put a timeline of the phases of each run, as Chrome
+    // trace-event JSON. Empty disables it.
+    void setTraceDirectory(std::string directory);
+
+    // Where to keep the offsets measured by earlier runs, so that a run can
+    // check them instead of measuring them again. Empty disables it.
+    void setCalibrationDirectory(std::string directory);
+
+    // Recorded in the archive header, to tie the samples to the results.
+    void setRunId(std::string id);
+
+    // Every wait and every timestamp of the test goes through this clock,
+    // the system clock unless set. It must outlive the test.
+    void setClock(instrumentation::Clock* clock);
+
 public slots:
+    // configurations[k] is what channels[k] was configured with.
     void test(
         bool mode,
         QMutex* mutex,
@@ -100,7 +155,7 @@ public slots:
         PSUController* controller,
         std::vector<int> channels,
         TestParameters parameters,
-        TestConfiguration config
+        std::vector<TestConfiguration> configurations
     );
 
     void stop();
@@ -110,10 +165,13 @@ signals:
     void distributeChannelPolarity(int channel, int polarity);
     void distributeTubeDataPacket(TubeData data);
     void distributeTimeInfo(std::string remaining);
+    void distributeRunReport(RunReport report);
 
     void connectTube(int tube);
     void disconnectTube(int tube);
 
+    void alert(std::string message);
+
     void finished();
 
 private:
@@ -124,23 +182,87 @@ private:
         DCCHController& serial
     );
 
+    // Uses the cached offsets when a short sample agrees with them, and
+    // otherwise waits out timeForTestingVoltage and caches what it reads.
+    // Offsets are cached under the voltage each channel is set to, one entry
+    // of testVoltages per channel.
     std::vector<float> getIntrinsicCurrent(
         std::vector<int>& channels,
         PSUController* controller,
         TestParameters& parameters,
+        const std::vector<int>& testVoltages,
         int rampTime
     );
 
-    void collectData(
-        std::vector<int> ch,
+    // Measures the offsets again between tubes, while every tube is
+    // disconnected, as the mean of parameters.rebaselineReads reads, and adds
+    // them to the baseline at their time in the run. Returns false, keeping
+    // the baseline as it was, if no read succeeded.
+    bool remeasureIntrinsicCurrent(
+        const ChannelSet& channels,
+        PSUController* controller,
+        TestParameters& parameters,
+        std::chrono::nanoseconds started,
+        OffsetBaseline& baseline
+    );
+
+    // Waits for the power supply to come back after the link dropped, with
+    // its channels restored. Returns false, having stopped the test, if it
+    // does not.
+    bool resume(PSUController* controller, int rampTime);
+
+    // Reads into the caller's buffers, one entry per channel, so the sampling
+    // loop does no allocation on the power supply side. A failed read leaves
+    // the previous values in place and returns false. Only the first failure
+    // of a run of them is logged as an error, so a flaky link does not flood
+    // the log.
+    bool collectData(
+        const ChannelSet& ch,
         PSUController* con,
-        std::vector<float>& voltages,
-        std::vector<float>& currents,
+        std::span<float> voltages,
+        std::span<float> currents,
+        std::span<unsigned long> rawStatuses,
         std::vector<std::string>& statuses
     );
 
+    // The raw samples of a tube tested since the latest offset measurement.
+    // While streaming, the tube is corrected with that measurement; once the
+    // next one exists it is corrected again from them both.
+    struct PendingTube
+    {
+        std::size_t slot;
+        int physicalTube;
+        double started;
+        TubeData data;
+        std::vector<double> runTimes;
+        std::vector<float> tubeTimes;
+        std::vector<float> currents;
+        std::vector<float> voltages;
+    };
+
+    // Corrects every pending tube by interpolating between the measurements
+    // around each of its samples, then archives it and hands it out again,
+    // so the statistics and the results are those of the corrected samples.
+    void settleTubes(std::vector<PendingTube>& pending, const OffsetBaseline& baseline, RunArchiveWriter* archive);
+
+    // Writes the trace and hands out the run report.
+    void finishRun(std::chrono::nanoseconds started);
+
+    // Writes the timeline of the run, when a trace directory is set.
+    void writeTrace();
+
 private:
+    std::string archiveDirectory;
+    std::string traceDirectory;
+    std::string traceStamp;
+    std::string calibrationDirectory;
+    std::string runId;
+    instrumentation::Clock* clock;
+    instrumentation::Trace trace;
+    RunReport report;
+    LatencyHistogram collectLatency;
     QMutex loggerMutex;
     std::atomic<bool> stopFlag;
+    std::size_t failedPolls;
     std::shared_ptr<spdlog::logger> logger;
 };
\ No newline at end of file
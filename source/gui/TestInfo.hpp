@@ -4,15 +4,7 @@
 
 #include <string>
 
-struct TubeData
-{
-    int index { -1 };
-    int channel { -1 };
-    bool isActive { false };
-    float current { -1.00 };
-    float voltage { -1.00 };
-    float intrinsicCurrent { -1.00 };
-};
+#include <common/TestTypes.hpp>
 
 struct ChannelStatus
 {
@@ -25,21 +17,3 @@ enum class TestMode
     Normal,
     Reverse
 };
-
-struct TestParameters
-{
-    int secondsPerTube { 1 };
-    int tubesPerChannel { 32 };
-    int timeForTestingVoltage { 1 };
-};
-
-struct TestConfiguration
-{
-    int testVoltage { 0 };
-    int currentLimit { 0 };
-    int maxVoltage { 1 };
-    int rampUpRate { 1 };
-    int rampDownRate { 1 };
-    int overCurrentLimit { 0 };
-    int powerDownMethod { 0 };
-};
\ No newline at end of file
@@ -4,6 +4,8 @@
 #include <QFormLayout>
 #include <QGridLayout>
 
+#include <fmt/core.h>
+
 #include "TestStatusWidget.hpp"
 
 static int seconds;
@@ -16,7 +18,12 @@ TestStatusWidget::TestStatusWidget(QWidget* parent):
     timeStarted { new QLabel("--:--", this) },
     timeElapsed { new QLabel("0 min", this) },
     timeRemaining { new QLabel("0 min", this) },
-    box { new QGroupBox("Test Status", this) }
+    lastRunRate { new QLabel("--", this) },
+    lastRunPhases { new QLabel("--", this) },
+    lastRunLatency { new QLabel("--", this) },
+    lastRunSamples { new QLabel("--", this) },
+    box { new QGroupBox("Test Status", this) },
+    lastRunBox { new QGroupBox("Last Run", this) }
 {
     connect(timer, &QTimer::timeout, this, &TestStatusWidget::update);
     seconds = 0;
@@ -29,8 +36,16 @@ TestStatusWidget::TestStatusWidget(QWidget* parent):
     boxLayout->addRow("Time Remaining:", timeRemaining);
     box->setLayout(boxLayout);
 
+    QFormLayout* lastRunLayout = new QFormLayout;
+    lastRunLayout->addRow("Throughput:", lastRunRate);
+    lastRunLayout->addRow("Time Spent:", lastRunPhases);
+    lastRunLayout->addRow("Read Latency:", lastRunLatency);
+    lastRunLayout->addRow("Samples per Tube:", lastRunSamples);
+    lastRunBox->setLayout(lastRunLayout);
+
     QGridLayout* layout = new QGridLayout;
     layout->addWidget(box);
+    layout->addWidget(lastRunBox);
     layout->setAlignment(Qt::AlignCenter);
 
     setLayout(layout);
@@ -65,6 +80,35 @@ void TestStatusWidget::receiveTimeRemaining(std::string time)
     timeRemaining->setText(QString::fromStdString(time));
 }
 
+void TestStatusWidget::showRunReport(const RunReport& report)
+{
+    auto minutes = [&report](RunReport::Phase phase) { return report.seconds(phase) / 60.0; };
+
+    lastRunRate->setText(QString::fromStdString(
+        fmt::format("{:.1f} tubes/h ({} tubes in {:.1f} min)", report.tubesPerHour(), report.tubesTested, report.totalSeconds / 60.0)
+    ));
+
+    lastRunPhases->setText(QString::fromStdString(
+        fmt::format(
+            "ramp {:.1f}, switch {:.1f}, wait {:.1f}, sample {:.1f}, idle {:.1f}, other {:.1f} min",
+            minutes(RunReport::Phase::Ramping),
+            minutes(RunReport::Phase::Switching),
+            minutes(RunReport::Phase::Waiting),
+            minutes(RunReport::Phase::Sampling),
+            minutes(RunReport::Phase::Idle),
+            report.otherSeconds() / 60.0
+        )
+    ));
+
+    lastRunLatency->setText(QString::fromStdString(
+        fmt::format("mean {:.2f} ms, p99 {:.2f} ms", report.collectMean, report.collectP99)
+    ));
+
+    lastRunSamples->setText(QString::fromStdString(
+        fmt::format("{} to {}", report.fewestSamples(), report.mostSamples())
+    ));
+}
+
 void TestStatusWidget::update()
 {
     ++seconds;
@@ -5,6 +5,8 @@
 #include <QWidget>
 #include <QGroupBox>
 
+#include "RunReport.hpp"
+
 class TestStatusWidget : public QWidget
 {
     Q_OBJECT
@@ -16,6 +18,9 @@ public:
     void stopTime();
     void receiveTimeRemaining(std::string time);
 
+    // Shows where the time of the last run went.
+    void showRunReport(const RunReport& report);
+
 public slots:
     void update();
 
@@ -27,5 +32,11 @@ private:
     QLabel* timeElapsed;
     QLabel* timeRemaining;
 
+    QLabel* lastRunRate;
+    QLabel* lastRunPhases;
+    QLabel* lastRunLatency;
+    QLabel* lastRunSamples;
+
     QGroupBox* box;
+    QGroupBox* lastRunBox;
 };
\ No newline at end of file
@@ -0,0 +1,45 @@
+#include "Clock.hpp"
+
+#include <thread>
+
+namespace instrumentation
+{
+
+double Clock::seconds() const
+{
+    return std::chrono::duration<double>(now()).count();
+}
+
+Clock& Clock::system()
+{
+    static SystemClock clock;
+    return clock;
+}
+
+std::chrono::nanoseconds SystemClock::now() const
+{
+    return std::chrono::steady_clock::now().time_since_epoch();
+}
+
+void SystemClock::sleep(std::chrono::nanoseconds duration)
+{
+    std::this_thread::sleep_for(duration);
+}
+
+std::chrono::nanoseconds VirtualClock::now() const
+{
+    return std::chrono::nanoseconds(ticks.load(std::memory_order_relaxed));
+}
+
+void VirtualClock::sleep(std::chrono::nanoseconds duration)
+{
+    advance(duration);
+}
+
+void VirtualClock::advance(std::chrono::nanoseconds duration)
+{
+    if (duration.count() > 0)
+        ticks.fetch_add(duration.count(), std::memory_order_relaxed);
+}
+
+} // namespace instrumentation
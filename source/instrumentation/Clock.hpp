@@ -0,0 +1,59 @@
+// Clock.hpp
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace instrumentation
+{
+
+// Where a test takes the time from, and how it waits. The system clock is
+// the real thing. Everything that paces a run goes through one of these, so
+// that the run can be put on a virtual clock instead.
+class Clock
+{
+public:
+    virtual ~Clock() = default;
+
+    // Time since a fixed point of the clock's choosing.
+    virtual std::chrono::nanoseconds now() const = 0;
+    virtual void sleep(std::chrono::nanoseconds duration) = 0;
+
+    double seconds() const;
+
+    static Clock& system();
+};
+
+class SystemClock final : public Clock
+{
+public:
+    std::chrono::nanoseconds now() const override;
+    void sleep(std::chrono::nanoseconds duration) override;
+};
+
+// Time that only passes when somebody sleeps, and then passes at once: a run
+// that takes hours against the hardware takes milliseconds against FakeHV.
+// Meant for one thread doing the sleeping; any thread may read it.
+class VirtualClock final : public Clock
+{
+public:
+    VirtualClock() = default;
+
+    VirtualClock(const VirtualClock&) = delete;
+    VirtualClock(VirtualClock&&) = delete;
+
+    VirtualClock& operator=(const VirtualClock&) = delete;
+    VirtualClock& operator=(VirtualClock&&) = delete;
+
+    std::chrono::nanoseconds now() const override;
+    void sleep(std::chrono::nanoseconds duration) override;
+
+    void advance(std::chrono::nanoseconds duration);
+
+private:
+    std::atomic<std::int64_t> ticks { 0 };
+};
+
+} // namespace instrumentation
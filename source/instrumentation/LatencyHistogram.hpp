@@ -0,0 +1,162 @@
+// LatencyHistogram.hpp
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+
+// Snapshot of a LatencyHistogram, in nanoseconds.
+struct LatencySummary
+{
+    std::uint64_t count { 0 };
+    std::uint64_t errors { 0 };
+    std::uint64_t mean { 0 };
+    std::uint64_t max { 0 };
+    std::uint64_t p50 { 0 };
+    std::uint64_t p90 { 0 };
+    std::uint64_t p99 { 0 };
+};
+
+// A histogram of durations that any number of threads can record into
+// without locks, in the spirit of HdrHistogram: each power of two is split
+// into eight buckets, so a reported percentile is within 12.5% of the real
+// value from a few nanoseconds up to about half an hour. Recording is a
+// handful of relaxed atomic adds.
+class LatencyHistogram
+{
+public:
+    static constexpr int subBucketBits = 3;
+    static constexpr std::uint64_t subBuckets = 1 << subBucketBits;
+    static constexpr int largestExponent = 40;
+    static constexpr std::size_t bucketCount = (largestExponent - subBucketBits + 2) * subBuckets;
+
+    LatencyHistogram() = default;
+
+    LatencyHistogram(const LatencyHistogram&) = delete;
+    LatencyHistogram(LatencyHistogram&&) = delete;
+
+    LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+    LatencyHistogram& operator=(LatencyHistogram&&) = delete;
+
+    void record(std::chrono::nanoseconds duration, bool failed = false)
+    {
+        auto value = static_cast<std::uint64_t>(duration.count() < 0 ? 0 : duration.count());
+
+        buckets[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(value, std::memory_order_relaxed);
+
+        if (failed)
+            errors.fetch_add(1, std::memory_order_relaxed);
+
+        auto seen = max.load(std::memory_order_relaxed);
+
+        while (value > seen && !max.compare_exchange_weak(seen, value, std::memory_order_relaxed));
+    }
+
+    // Not a consistent cut while other threads record, which is fine for a
+    // report: every field is at most a few calls behind.
+    LatencySummary summary() const
+    {
+        LatencySummary s;
+
+        std::array<std::uint64_t, bucketCount> counts;
+
+        for (std::size_t i = 0; i < bucketCount; ++i)
+        {
+            counts[i] = buckets[i].load(std::memory_order_relaxed);
+            s.count += counts[i];
+        }
+
+        s.errors = errors.load(std::memory_order_relaxed);
+        s.max = max.load(std::memory_order_relaxed);
+
+        if (s.count == 0)
+            return s;
+
+        s.mean = sum.load(std::memory_order_relaxed) / s.count;
+        s.p50 = percentile(counts, s.count, 0.50, s.max);
+        s.p90 = percentile(counts, s.count, 0.90, s.max);
+        s.p99 = percentile(counts, s.count, 0.99, s.max);
+
+        return s;
+    }
+
+    void reset()
+    {
+        for (auto& bucket : buckets)
+            bucket.store(0, std::memory_order_relaxed);
+
+        sum.store(0, std::memory_order_relaxed);
+        errors.store(0, std::memory_order_relaxed);
+        max.store(0, std::memory_order_relaxed);
+    }
+
+    static constexpr std::size_t bucketOf(std::uint64_t value)
+    {
+        // Values below the first split are counted exactly.
+        if (value < subBuckets)
+            return static_cast<std::size_t>(value);
+
+        int exponent = std::bit_width(value) - 1;
+
+        if (exponent > largestExponent)
+            return bucketCount - 1;
+
+        auto sub = (value >> (exponent - subBucketBits)) & (subBuckets - 1);
+        return static_cast<std::size_t>((exponent - subBucketBits + 1) * subBuckets + sub);
+    }
+
+    // The largest value that falls into `bucket`.
+    static constexpr std::uint64_t highestIn(std::size_t bucket)
+    {
+        if (bucket < subBuckets)
+            return bucket;
+
+        int exponent = static_cast<int>(bucket / subBuckets) + subBucketBits - 1;
+        auto sub = bucket % subBuckets;
+        auto width = std::uint64_t { 1 } << (exponent - subBucketBits);
+
+        return ((subBuckets + sub) << (exponent - subBucketBits)) + width - 1;
+    }
+
+private:
+    static std::uint64_t percentile(
+        const std::array<std::uint64_t, bucketCount>& counts,
+        std::uint64_t total,
+        double fraction,
+        std::uint64_t max
+    )
+    {
+        auto rank = static_cast<std::uint64_t>(fraction * static_cast<double>(total) + 0.5);
+        std::uint64_t seen = 0;
+
+        if (rank == 0)
+            rank = 1;
+
+        for (std::size_t i = 0; i < bucketCount; ++i)
+        {
+            seen += counts[i];
+
+            if (seen >= rank)
+                return highestIn(i) < max ? highestIn(i) : max;
+        }
+
+        return max;
+    }
+
+private:
+    std::array<std::atomic<std::uint64_t>, bucketCount> buckets {};
+    std::atomic<std::uint64_t> sum { 0 };
+    std::atomic<std::uint64_t> errors { 0 };
+    std::atomic<std::uint64_t> max { 0 };
+};
+
+static_assert(LatencyHistogram::bucketOf(7) == 7);
+static_assert(LatencyHistogram::bucketOf(8) == 8);
+static_assert(LatencyHistogram::bucketOf(16) == 16);
+static_assert(LatencyHistogram::highestIn(LatencyHistogram::bucketOf(1000)) >= 1000);
+static_assert(LatencyHistogram::bucketOf(std::uint64_t { 1 } << 50) == LatencyHistogram::bucketCount - 1);
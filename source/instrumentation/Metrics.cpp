@@ -0,0 +1,185 @@
+#include "Metrics.hpp"
+
+#include <fmt/core.h>
+
+namespace instrumentation
+{
+
+const char* name(Operation operation)
+{
+    switch (operation)
+    {
+        case Operation::Connect:                return "Connect";
+        case Operation::Disconnect:             return "Disconnect";
+        case Operation::CrateMap:               return "CrateMap";
+        case Operation::GetChannelParameter:    return "GetChannelParameter";
+        case Operation::SetChannelParameter:    return "SetChannelParameter";
+        case Operation::BoardParameter:         return "BoardParameter";
+        case Operation::ParameterLimits:        return "ParameterLimits";
+        case Operation::DCCHWrite:              return "DCCHWrite";
+    }
+
+    return "Unknown";
+}
+
+static std::size_t index(Operation operation)
+{
+    return static_cast<std::size_t>(operation);
+}
+
+// Durations in the unit that keeps them readable.
+static std::string humanize(std::uint64_t nanoseconds)
+{
+    if (nanoseconds < 1000)
+        return fmt::format("{} ns", nanoseconds);
+    if (nanoseconds < 1000000)
+        return fmt::format("{:.1f} us", nanoseconds / 1E3);
+    if (nanoseconds < 1000000000)
+        return fmt::format("{:.2f} ms", nanoseconds / 1E6);
+
+    return fmt::format("{:.2f} s", nanoseconds / 1E9);
+}
+
+static std::string row(const char* operation, const char* parameter, const LatencySummary& s)
+{
+    return fmt::format(
+        "{:<20} {:<10} {:>8} {:>6} {:>10} {:>10} {:>10} {:>10} {:>10}\n",
+        operation,
+        parameter,
+        s.count,
+        s.errors,
+        humanize(s.mean),
+        humanize(s.p50),
+        humanize(s.p90),
+        humanize(s.p99),
+        humanize(s.max)
+    );
+}
+
+Metrics& Metrics::global()
+{
+    static Metrics metrics;
+    return metrics;
+}
+
+void Metrics::record(Operation operation, std::chrono::nanoseconds duration, bool failed)
+{
+    operations[index(operation)].record(duration, failed);
+}
+
+void Metrics::record(Operation operation, hv::ParameterId parameter, std::chrono::nanoseconds duration, bool failed)
+{
+    operations[index(operation)].record(duration, failed);
+
+    if (operation == Operation::GetChannelParameter)
+        gets[hv::index(parameter)].record(duration, failed);
+    else if (operation == Operation::SetChannelParameter)
+        sets[hv::index(parameter)].record(duration, failed);
+}
+
+void Metrics::addBytesWritten(std::uint64_t bytes)
+{
+    written.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+LatencySummary Metrics::summary(Operation operation) const
+{
+    return operations[index(operation)].summary();
+}
+
+LatencySummary Metrics::summary(Operation operation, hv::ParameterId parameter) const
+{
+    auto* histogram = byParameter(operation, parameter);
+    return histogram ? histogram->summary() : LatencySummary();
+}
+
+std::uint64_t Metrics::bytesWritten() const
+{
+    return written.load(std::memory_order_relaxed);
+}
+
+std::string Metrics::report() const
+{
+    std::string report = fmt::format(
+        "{:<20} {:<10} {:>8} {:>6} {:>10} {:>10} {:>10} {:>10} {:>10}\n",
+        "Operation", "Parameter", "Calls", "Errors", "Mean", "p50", "p90", "p99", "Max"
+    );
+
+    for (std::size_t i = 0; i < operationCount; ++i)
+    {
+        auto operation = static_cast<Operation>(i);
+        auto s = summary(operation);
+
+        if (s.count == 0)
+            continue;
+
+        report += row(name(operation), "", s);
+
+        for (const auto& parameter : hv::registry)
+        {
+            auto p = summary(operation, parameter.id);
+
+            if (p.count)
+                report += row("", parameter.name, p);
+        }
+    }
+
+    report += fmt::format("DCCH bytes written: {}", bytesWritten());
+
+    return report;
+}
+
+void Metrics::reset()
+{
+    for (auto& histogram : operations)
+        histogram.reset();
+    for (auto& histogram : gets)
+        histogram.reset();
+    for (auto& histogram : sets)
+        histogram.reset();
+
+    written.store(0, std::memory_order_relaxed);
+}
+
+const LatencyHistogram* Metrics::byParameter(Operation operation, hv::ParameterId parameter) const
+{
+    if (operation == Operation::GetChannelParameter)
+        return &gets[hv::index(parameter)];
+    if (operation == Operation::SetChannelParameter)
+        return &sets[hv::index(parameter)];
+
+    return nullptr;
+}
+
+ScopedTimer::ScopedTimer(Operation operation):
+    operation { operation },
+    parameter { hv::ParameterId::VSet },
+    hasParameter { false },
+    hasFailed { false },
+    start { Clock::now() }
+{}
+
+ScopedTimer::ScopedTimer(Operation operation, hv::ParameterId parameter):
+    operation { operation },
+    parameter { parameter },
+    hasParameter { true },
+    hasFailed { false },
+    start { Clock::now() }
+{}
+
+ScopedTimer::~ScopedTimer()
+{
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+
+    if (hasParameter)
+        Metrics::global().record(operation, parameter, elapsed, hasFailed);
+    else
+        Metrics::global().record(operation, elapsed, hasFailed);
+}
+
+void ScopedTimer::failed(bool hasFailed)
+{
+    this->hasFailed = hasFailed;
+}
+
+} // namespace instrumentation
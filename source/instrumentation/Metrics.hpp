@@ -0,0 +1,104 @@
+// Metrics.hpp
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+#include <psu/Parameters.hpp>
+
+#include "LatencyHistogram.hpp"
+
+namespace instrumentation
+{
+
+// Every kind of call to the hardware that is timed.
+enum class Operation
+{
+    Connect,
+    Disconnect,
+    CrateMap,
+    GetChannelParameter,
+    SetChannelParameter,
+    BoardParameter,
+    ParameterLimits,
+    DCCHWrite
+};
+
+inline constexpr std::size_t operationCount = 8;
+
+const char* name(Operation operation);
+
+// Latencies and error counts of every HV and DCCH call made by the process,
+// always on. Channel parameter calls are also kept per parameter. Recording
+// takes no lock, so the acquisition threads of several stations can share
+// the one global instance; a report covers all of them.
+class Metrics
+{
+public:
+    static Metrics& global();
+
+    Metrics() = default;
+
+    Metrics(const Metrics&) = delete;
+    Metrics(Metrics&&) = delete;
+
+    Metrics& operator=(const Metrics&) = delete;
+    Metrics& operator=(Metrics&&) = delete;
+
+    void record(Operation operation, std::chrono::nanoseconds duration, bool failed = false);
+    void record(Operation operation, hv::ParameterId parameter, std::chrono::nanoseconds duration, bool failed = false);
+    void addBytesWritten(std::uint64_t bytes);
+
+    LatencySummary summary(Operation operation) const;
+    LatencySummary summary(Operation operation, hv::ParameterId parameter) const;
+    std::uint64_t bytesWritten() const;
+
+    // One line per operation, and per parameter, that was called at least
+    // once since the last reset.
+    std::string report() const;
+
+    void reset();
+
+private:
+    const LatencyHistogram* byParameter(Operation operation, hv::ParameterId parameter) const;
+
+private:
+    std::array<LatencyHistogram, operationCount> operations;
+    std::array<LatencyHistogram, hv::parameterCount> gets;
+    std::array<LatencyHistogram, hv::parameterCount> sets;
+    std::atomic<std::uint64_t> written { 0 };
+};
+
+// Records the time from construction to destruction into the global metrics.
+class ScopedTimer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ScopedTimer(Operation operation);
+    ScopedTimer(Operation operation, hv::ParameterId parameter);
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer(ScopedTimer&&) = delete;
+
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(ScopedTimer&&) = delete;
+
+    // Counts the call as an error as well.
+    void failed(bool hasFailed = true);
+
+private:
+    Operation operation;
+    hv::ParameterId parameter;
+    bool hasParameter;
+    bool hasFailed;
+    Clock::time_point start;
+};
+
+} // namespace instrumentation
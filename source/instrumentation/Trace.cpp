@@ -0,0 +1,122 @@
+#include "Trace.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace instrumentation
+{
+
+Trace::Scope::Scope(Trace& trace, std::string_view name, int track):
+    trace { trace },
+    span { trace.begin(name, track) }
+{}
+
+Trace::Scope::~Scope()
+{
+    trace.end(span);
+}
+
+Trace::Trace(bool enabled):
+    isEnabled { enabled },
+    clock { &Clock::system() },
+    origin { clock->now() }
+{}
+
+void Trace::reset(bool enabled, const Clock& clock)
+{
+    isEnabled = enabled;
+    this->clock = &clock;
+    origin = clock.now();
+    spans.clear();
+    tracks.clear();
+}
+
+bool Trace::enabled() const
+{
+    return isEnabled;
+}
+
+void Trace::nameTrack(int track, std::string_view name)
+{
+    if (isEnabled)
+        tracks.emplace_back(track, std::string(name));
+}
+
+std::size_t Trace::begin(std::string_view name, int track)
+{
+    if (!isEnabled)
+        return none;
+
+    spans.push_back({ std::string(name), track, now(), -1 });
+    return spans.size() - 1;
+}
+
+void Trace::end(std::size_t span)
+{
+    if (span >= spans.size() || spans[span].duration >= 0)
+        return;
+
+    spans[span].duration = now() - spans[span].start;
+}
+
+void Trace::write(const std::string& path) const
+{
+    json events = json::array();
+
+    // Track 0 goes first in the viewer, then the others by number.
+    for (const auto& [track, name] : tracks)
+    {
+        events.push_back({
+            { "name", "thread_name" },
+            { "ph", "M" },
+            { "pid", 1 },
+            { "tid", track },
+            { "args", { { "name", name } } }
+        });
+
+        events.push_back({
+            { "name", "thread_sort_index" },
+            { "ph", "M" },
+            { "pid", 1 },
+            { "tid", track },
+            { "args", { { "sort_index", track } } }
+        });
+    }
+
+    auto end = now();
+
+    for (const auto& span : spans)
+    {
+        events.push_back({
+            { "name", span.name },
+            { "cat", "test" },
+            { "ph", "X" },
+            { "pid", 1 },
+            { "tid", span.track },
+            { "ts", span.start },
+            { "dur", span.duration >= 0 ? span.duration : end - span.start }
+        });
+    }
+
+    std::ofstream out(path);
+
+    if (!out)
+        throw std::runtime_error("Cannot open " + path);
+
+    out << json { { "traceEvents", events }, { "displayTimeUnit", "ms" } }.dump();
+
+    if (!out)
+        throw std::runtime_error("Cannot write " + path);
+}
+
+// Microseconds since the trace started, the unit of the trace-event format.
+std::int64_t Trace::now() const
+{
+    return std::chrono::duration_cast<std::chrono::microseconds>(clock->now() - origin).count();
+}
+
+} // namespace instrumentation
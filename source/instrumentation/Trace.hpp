@@ -0,0 +1,87 @@
+// Trace.hpp
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "Clock.hpp"
+
+namespace instrumentation
+{
+
+// A timeline of what a run spent its time on, written as Chrome trace-event
+// JSON that chrome://tracing or ui.perfetto.dev open offline. Each span sits
+// on a track, and spans on one track nest by time, so a span begun inside
+// another shows up below it. Meant to be recorded by one thread. A disabled
+// trace records nothing, and begin() hands back a span that end() ignores.
+class Trace
+{
+public:
+    static constexpr std::size_t none = static_cast<std::size_t>(-1);
+
+    // Ends the span it was given when it goes out of scope.
+    class Scope
+    {
+    public:
+        Scope(Trace& trace, std::string_view name, int track = 0);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope(Scope&&) = delete;
+
+        Scope& operator=(const Scope&) = delete;
+        Scope& operator=(Scope&&) = delete;
+
+    private:
+        Trace& trace;
+        std::size_t span;
+    };
+
+    explicit Trace(bool enabled = false);
+
+    Trace(const Trace&) = delete;
+    Trace(Trace&&) = delete;
+
+    Trace& operator=(const Trace&) = delete;
+    Trace& operator=(Trace&&) = delete;
+
+    // Drops everything recorded and starts again from now on `clock`.
+    void reset(bool enabled, const Clock& clock = Clock::system());
+
+    bool enabled() const;
+
+    void nameTrack(int track, std::string_view name);
+
+    std::size_t begin(std::string_view name, int track = 0);
+    void end(std::size_t span);
+
+    // Spans still open are written as ending now. Throws if the file cannot
+    // be written.
+    void write(const std::string& path) const;
+
+private:
+    struct Span
+    {
+        std::string name;
+        int track;
+        std::int64_t start;
+        std::int64_t duration;
+    };
+
+    std::int64_t now() const;
+
+private:
+    bool isEnabled;
+    const Clock* clock;
+    std::chrono::nanoseconds origin;
+    std::vector<Span> spans;
+    std::vector<std::pair<int, std::string>> tracks;
+};
+
+} // namespace instrumentation
@@ -0,0 +1,80 @@
+// ChannelSet.hpp
+
+#pragma once
+
+#include <span>
+#include <array>
+#include <bitset>
+#include <vector>
+#include <cstddef>
+#include <stdexcept>
+#include <initializer_list>
+
+// A set of crate channel numbers that lives entirely inline, so passing one
+// around or building one never touches the heap. The channels keep the order
+// they were inserted in, since values read for a set come back in that order,
+// and a bitmask of members drops duplicates.
+//
+// The capacity covers a full crate (16 slots of 48 channels). Inserting a
+// channel beyond it throws.
+class ChannelSet
+{
+public:
+    static constexpr std::size_t capacity = 16 * 48;
+
+    ChannelSet() = default;
+
+    ChannelSet(std::initializer_list<int> channels)
+    {
+        for (auto channel : channels)
+            insert(channel);
+    }
+
+    // Deliberately implicit: everything that used to take a std::vector<int>
+    // of channels keeps accepting one.
+    ChannelSet(const std::vector<int>& channels)
+    {
+        for (auto channel : channels)
+            insert(channel);
+    }
+
+    void insert(int channel)
+    {
+        if (channel < 0 || channel >= static_cast<int>(capacity))
+            throw std::runtime_error("Invalid Channel Number");
+
+        if (members.test(channel))
+            return;
+
+        members.set(channel);
+        channels[count++] = static_cast<unsigned short>(channel);
+    }
+
+    bool contains(int channel) const
+    {
+        return channel >= 0 && channel < static_cast<int>(capacity) && members.test(channel);
+    }
+
+    void clear()
+    {
+        members.reset();
+        count = 0;
+    }
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    int operator[](std::size_t i) const { return channels[i]; }
+
+    const unsigned short* begin() const { return channels.data(); }
+    const unsigned short* end() const { return channels.data() + count; }
+
+    std::span<const unsigned short> view() const { return { channels.data(), count }; }
+
+    std::vector<int> toVector() const { return { begin(), end() }; }
+
+private:
+    std::array<unsigned short, capacity> channels {};
+    std::bitset<capacity> members;
+    std::size_t count { 0 };
+};
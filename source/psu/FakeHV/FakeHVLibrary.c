@@ -44,8 +44,84 @@ static const int FakeHV_ParameterTypes[] = {
     PARAMETER_TYPE_UNSIGNED
 };
 
+/* The ranges an N1471 reports, for the float parameters. */
+static const float FakeHV_DefaultLimits[][2] = {
+    { 0.0f, 5500.0f },
+    { 0.0f, 5600.0f },
+    { 0.0f, 21.000f },
+    { 0.0f, 0.0f },
+    { 0.0f, 21.000f },
+    { 0.0f, 21.000f },
+    { 0.0f, 5600.0f },
+    { 1.0f, 500.00f },
+    { 1.0f, 500.00f },
+    { 0.0f, 1000.0f },
+    { 0.0f, 0.0f },
+    { 0.0f, 0.0f },
+    { 0.0f, 0.0f },
+    { 0.0f, 0.0f }
+};
+
 static int FakeHV_ErrorCode = 0;
 
+#define FAKEHV_MAX_SLOTS 16
+#define FAKEHV_MAX_CHANNELS_PER_SLOT 48
+
+#define FAKEHV_NUMBER_OF_PARAMETERS 14
+
+static unsigned short FakeHV_NumberOfSlots = 1;
+static unsigned short FakeHV_ChannelsPerSlot[FAKEHV_MAX_SLOTS] = { 4 };
+
+/* What was last written to every parameter of every channel. */
+typedef union {
+    float asFloat;
+    unsigned long asUnsigned;
+} FakeHV_Value;
+
+static FakeHV_Value FakeHV_State[FAKEHV_MAX_SLOTS][FAKEHV_MAX_CHANNELS_PER_SLOT][FAKEHV_NUMBER_OF_PARAMETERS];
+
+/* Ranges set by FakeHV_SetParameterLimits, used where FakeHV_HasLimits is. */
+static float FakeHV_Limits[FAKEHV_MAX_SLOTS][FAKEHV_NUMBER_OF_PARAMETERS][2];
+static int FakeHV_HasLimits[FAKEHV_MAX_SLOTS][FAKEHV_NUMBER_OF_PARAMETERS];
+
+/* When set, a write to several channels at once only reaches the first. */
+static int FakeHV_SingleChannelSets = 0;
+
+/* When set, the link to the supply is down and every call fails. */
+static int FakeHV_LinkDown = 0;
+
+/* Index of the parameter whose reads fail with the link up, or -1. */
+static int FakeHV_FailingRead = -1;
+
+/* Where the parameters that move on their own sit in FakeHV_State. */
+#define FAKEHV_VSET 0
+#define FAKEHV_VMON 1
+#define FAKEHV_RUP 7
+#define FAKEHV_RDWN 8
+#define FAKEHV_CHSTATUS 12
+#define FAKEHV_PW 13
+
+#define FAKEHV_STATUS_ON 0x1
+#define FAKEHV_STATUS_RAMP_UP 0x2
+#define FAKEHV_STATUS_RAMP_DOWN 0x4
+
+/*
+ * Seconds since any fixed point, from whoever drives the simulation. Without
+ * one, nothing moves on its own and VMon reads back what was written to it.
+ */
+static double (*FakeHV_Now)(void) = NULL;
+
+/* A channel heading for a voltage at a fixed rate, since `start`. */
+typedef struct {
+    int active;
+    double start;
+    float from;
+    float to;
+    float rate;
+} FakeHV_Ramp;
+
+static FakeHV_Ramp FakeHV_Ramps[FAKEHV_MAX_SLOTS][FAKEHV_MAX_CHANNELS_PER_SLOT];
+
 enum {
     FAKEHV_NORMAL,
     FAKEHV_BAD_HANDLE,
@@ -55,9 +131,137 @@ enum {
     FAKEHV_INCORRECT_SLOT,
     FAKEHV_POINTER_IS_NULL,
     FAKEHV_INVALID_PARAMETER,
-    FAKEHV_TOO_MANY_CHANNELS
+    FAKEHV_TOO_MANY_CHANNELS,
+    FAKEHV_INVALID_CHANNEL,
+    FAKEHV_LINK_IS_DOWN,
+    FAKEHV_READ_FAILED,
+    FAKEHV_INVALID_PROPERTY
 };
 
+static int FakeHV_ChannelsAreValid(
+    unsigned short slot,
+    unsigned short channelListSize,
+    const unsigned short* listOfChannels
+)
+{
+    if (channelListSize > FakeHV_ChannelsPerSlot[slot])
+    {
+        FakeHV_ErrorCode = FAKEHV_TOO_MANY_CHANNELS;
+        return 0;
+    }
+
+    for (int i = 0; i < channelListSize; ++i)
+    {
+        if (listOfChannels[i] >= FakeHV_ChannelsPerSlot[slot])
+        {
+            FakeHV_ErrorCode = FAKEHV_INVALID_CHANNEL;
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static int FakeHV_HandleAndSlotAreValid(int handle, unsigned short slot)
+{
+    if (handle)
+    {
+        FakeHV_ErrorCode = FAKEHV_BAD_HANDLE;
+        return 0;
+    }
+
+    if (slot >= FakeHV_NumberOfSlots || FakeHV_ChannelsPerSlot[slot] == 0)
+    {
+        FakeHV_ErrorCode = FAKEHV_INCORRECT_SLOT;
+        return 0;
+    }
+
+    return 1;
+}
+
+static float FakeHV_VoltageNow(unsigned short slot, unsigned short channel)
+{
+    FakeHV_Ramp* ramp = &FakeHV_Ramps[slot][channel];
+
+    if (!FakeHV_Now || !ramp->active)
+        return FakeHV_State[slot][channel][FAKEHV_VMON].asFloat;
+
+    if (ramp->rate <= 0.0f)
+        return ramp->to;
+
+    float moved = (float) ((FakeHV_Now() - ramp->start) * ramp->rate);
+
+    if (ramp->to > ramp->from)
+        return (ramp->from + moved < ramp->to) ? ramp->from + moved : ramp->to;
+
+    return (ramp->from - moved > ramp->to) ? ramp->from - moved : ramp->to;
+}
+
+/* Brings VMon and the ramp bits of ChStatus up to date. */
+static void FakeHV_Advance(unsigned short slot, unsigned short channel)
+{
+    FakeHV_Value* state = FakeHV_State[slot][channel];
+    FakeHV_Ramp* ramp = &FakeHV_Ramps[slot][channel];
+
+    if (!FakeHV_Now || !ramp->active)
+        return;
+
+    float voltage = FakeHV_VoltageNow(slot, channel);
+    unsigned long status = state[FAKEHV_CHSTATUS].asUnsigned;
+
+    status &= ~(unsigned long) (FAKEHV_STATUS_ON | FAKEHV_STATUS_RAMP_UP | FAKEHV_STATUS_RAMP_DOWN);
+
+    if (state[FAKEHV_PW].asUnsigned)
+        status |= FAKEHV_STATUS_ON;
+
+    if (voltage < ramp->to)
+        status |= FAKEHV_STATUS_RAMP_UP;
+    else if (voltage > ramp->to)
+        status |= FAKEHV_STATUS_RAMP_DOWN;
+
+    state[FAKEHV_VMON].asFloat = voltage;
+    state[FAKEHV_CHSTATUS].asUnsigned = status;
+}
+
+/*
+ * Switching a channel, or changing its set voltage, starts a ramp from
+ * wherever it is now, at RUp going up and RDwn going down.
+ */
+static void FakeHV_StartRamp(unsigned short slot, unsigned short channel)
+{
+    FakeHV_Value* state = FakeHV_State[slot][channel];
+    FakeHV_Ramp* ramp = &FakeHV_Ramps[slot][channel];
+
+    if (!FakeHV_Now)
+        return;
+
+    float from = FakeHV_VoltageNow(slot, channel);
+    float to = state[FAKEHV_PW].asUnsigned ? state[FAKEHV_VSET].asFloat : 0.0f;
+
+    ramp->active = 1;
+    ramp->start = FakeHV_Now();
+    ramp->from = from;
+    ramp->to = to;
+    ramp->rate = (to > from) ? state[FAKEHV_RUP].asFloat : state[FAKEHV_RDWN].asFloat;
+
+    FakeHV_Advance(slot, channel);
+}
+
+/* Returns FAKEHV_NUMBER_OF_PARAMETERS for a name that is not known. */
+static unsigned short FakeHV_FindParameter(const char* parameter)
+{
+    if (parameter == NULL)
+        return FAKEHV_NUMBER_OF_PARAMETERS;
+
+    for (unsigned short i = 0; i < FAKEHV_NUMBER_OF_PARAMETERS; ++i)
+    {
+        if (strcmp(parameter, FakeHV_ValidParameters[i]) == 0)
+            return i;
+    }
+
+    return FAKEHV_NUMBER_OF_PARAMETERS;
+}
+
 int FakeHV_InitializeSystem(
     /* In */ int system,
     /* In */ int linkType,
@@ -67,6 +271,12 @@ int FakeHV_InitializeSystem(
     /* Out */ int* handle
 )
 {
+    if (FakeHV_LinkDown)
+    {
+        FakeHV_ErrorCode = FAKEHV_LINK_IS_DOWN;
+        return FAKEHV_LINK_DOWN;
+    }
+
     if (handle == NULL)
     {
         FakeHV_ErrorCode = FAKEHV_BAD_HANDLE;
@@ -95,6 +305,12 @@ int FakeHV_GetCrateMap(
     /* Out-Allocated */ unsigned char** listOfFirmwarePrefixesIndexedBySlot
 )
 {
+    if (FakeHV_LinkDown)
+    {
+        FakeHV_ErrorCode = FAKEHV_LINK_IS_DOWN;
+        return FAKEHV_LINK_DOWN;
+    }
+
     if (handle)
     {
         FakeHV_ErrorCode = FAKEHV_BAD_HANDLE;
@@ -107,13 +323,14 @@ int FakeHV_GetCrateMap(
         return -1;
     }
 
-    *numberOfSlots = 1;
+    *numberOfSlots = FakeHV_NumberOfSlots;
     int n = (*numberOfSlots);
 
     typedef unsigned short UShort;
     typedef unsigned char UChar;
 
-    // For allocating the right amount of characters.
+    // Models and descriptions are NUL-terminated strings packed back to back,
+    // one per slot, with an empty string for an empty slot.
     const char* message = "VIRTUAL";
     const int m = strlen(message) + 1;
 
@@ -189,59 +406,58 @@ int FakeHV_GetCrateMap(
 
     // Now for assignment. This is confusing because of pass by reference.
     // Remember that we have references, so we'll need to dereference first.
-    // These are hardcoded as they are known ahead of time.
-    (*listOfChannelsIndexedBySlot)[0] = 4;
+    char* model = *listOfModelsIndexedBySlot;
+    char* description = *descriptionList;
+
+    for (int i = 0; i < n; ++i)
+    {
+        const char* name = FakeHV_ChannelsPerSlot[i] ? message : "";
 
-    // (*listOfModelsIndexedBySlot) = "VIRTUAL";
-    // (*descriptionList) = "VIRTUAL";
-    strcpy(*listOfModelsIndexedBySlot, "VIRTUAL");
-    strcpy(*descriptionList, "VIRTUAL");
+        (*listOfChannelsIndexedBySlot)[i] = FakeHV_ChannelsPerSlot[i];
 
-    (*listOfSerialNumbersIndexedBySlot)[0] = 0;
-    (*listOfFirmwareSuffixesIndexedBySlot)[0] = 0;
-    (*listOfFirmwarePrefixesIndexedBySlot)[0] = 0;
+        strcpy(model, name);
+        strcpy(description, name);
+        model += strlen(name) + 1;
+        description += strlen(name) + 1;
+
+        (*listOfSerialNumbersIndexedBySlot)[i] = (UShort) i;
+        (*listOfFirmwareSuffixesIndexedBySlot)[i] = 0;
+        (*listOfFirmwarePrefixesIndexedBySlot)[i] = 0;
+    }
 
     return 0;
 }
 
 
-int FakeHV_GetChannelParameter(
+int FakeHV_GetChannelParameterById(
     /* In */ int handle,
     /* In */ unsigned short slot,
-    /* In */ const char* parameter,
+    /* In */ unsigned short parameterId,
     /* In */ unsigned short channelListSize,
     /* In */ const unsigned short* listOfChannelsToRead,
     /* Out */ void* listOfParameterValues
 )
 {
-    if (handle)
+    if (FakeHV_LinkDown)
     {
-        FakeHV_ErrorCode = FAKEHV_BAD_HANDLE;
-        return -1;
+        FakeHV_ErrorCode = FAKEHV_LINK_IS_DOWN;
+        return FAKEHV_LINK_DOWN;
     }
 
-    // Particular value is hardcoded. 
-    if (slot)
-    {
-        FakeHV_ErrorCode = FAKEHV_INCORRECT_SLOT;
+    if (!FakeHV_HandleAndSlotAreValid(handle, slot))
         return -1;
-    }
 
-    int isInList = 0;
-    int index = 0;
-    for (int i = 0; i < 14; ++i)
+    if (parameterId >= FAKEHV_NUMBER_OF_PARAMETERS)
     {
-        if (strcmp(parameter, FakeHV_ValidParameters[i]) == 0)
-        {
-            isInList = 1;
-            index = 0;
-            break;
-        }
+        FakeHV_ErrorCode = FAKEHV_INVALID_PARAMETER;
+        return -1;
     }
 
-    if (!isInList)
+    int index = parameterId;
+
+    if (index == FakeHV_FailingRead)
     {
-        FakeHV_ErrorCode = FAKEHV_INVALID_PARAMETER;
+        FakeHV_ErrorCode = FAKEHV_READ_FAILED;
         return -1;
     }
 
@@ -260,21 +476,23 @@ int FakeHV_GetChannelParameter(
     // We cannot really enforce this. We could end up accessing memory that
     // isn't ours if we get the wrong channelListSize in comparison to the
     // memory of listOfChannelsToRead...would prefer std::span if we had it.
-    if (channelListSize > 4)
-    {
-        FakeHV_ErrorCode = FAKEHV_TOO_MANY_CHANNELS;
+    if (!FakeHV_ChannelsAreValid(slot, channelListSize, listOfChannelsToRead))
         return -1;
-    }
 
     for (int i = 0; i < channelListSize; ++i)
     {
+        if (index == FAKEHV_VMON || index == FAKEHV_CHSTATUS)
+            FakeHV_Advance(slot, listOfChannelsToRead[i]);
+
+        FakeHV_Value* value = &FakeHV_State[slot][listOfChannelsToRead[i]][index];
+
         if (FakeHV_ParameterTypes[index] == PARAMETER_TYPE_FLOAT)
         {
-            ((float*) listOfParameterValues)[i] = 0.00f;
+            ((float*) listOfParameterValues)[i] = value->asFloat;
         }
         else if (FakeHV_ParameterTypes[index] == PARAMETER_TYPE_UNSIGNED)
         {
-            ((unsigned long*) listOfParameterValues)[i] = 0;
+            ((unsigned long*) listOfParameterValues)[i] = value->asUnsigned;
         }
         else
         {
@@ -286,62 +504,165 @@ int FakeHV_GetChannelParameter(
     return 0;
 }
 
-int FakeHV_SetChannelParameter(
+int FakeHV_SetChannelParameterById(
     /* In */ int handle,
     /* In */ unsigned short slot,
-    /* In */ const char* parameter,
+    /* In */ unsigned short parameterId,
     /* In */ unsigned short channelListSize,
     /* In */ const unsigned short* listOfChannelsToWrite,
     /* In */ void* newParameterValue
 )
 {
-    // Yes this is totally a copy and paste.
-    if (handle)
+    if (FakeHV_LinkDown)
     {
-        FakeHV_ErrorCode = FAKEHV_BAD_HANDLE;
+        FakeHV_ErrorCode = FAKEHV_LINK_IS_DOWN;
+        return FAKEHV_LINK_DOWN;
+    }
+
+    if (!FakeHV_HandleAndSlotAreValid(handle, slot))
+        return -1;
+
+    if (parameterId >= FAKEHV_NUMBER_OF_PARAMETERS)
+    {
+        FakeHV_ErrorCode = FAKEHV_INVALID_PARAMETER;
         return -1;
     }
 
-    // Particular value is hardcoded. 
-    if (slot)
+    int index = parameterId;
+
+    if (listOfChannelsToWrite == NULL)
     {
-        FakeHV_ErrorCode = FAKEHV_INCORRECT_SLOT;
+        FakeHV_ErrorCode = FAKEHV_POINTER_IS_NULL;
+        return -1;
+    }
+
+    if (!FakeHV_ChannelsAreValid(slot, channelListSize, listOfChannelsToWrite))
+        return -1;
+
+    if (newParameterValue == NULL)
+    {
+        FakeHV_ErrorCode = FAKEHV_POINTER_IS_NULL;
         return -1;
     }
 
-    int isInList = 0;
-    int index = 0;
-    for (int i = 0; i < 14; ++i)
+    int channelsWritten = FakeHV_SingleChannelSets && channelListSize > 1 ? 1 : channelListSize;
+
+    for (int i = 0; i < channelsWritten; ++i)
     {
-        if (strcmp(parameter, FakeHV_ValidParameters[i]) != 0)
-        {
-            isInList = 1;
-            index = 0;
-            break;
-        }
+        FakeHV_Value* value = &FakeHV_State[slot][listOfChannelsToWrite[i]][index];
+
+        if (FakeHV_ParameterTypes[index] == PARAMETER_TYPE_FLOAT)
+            value->asFloat = *((float*) newParameterValue);
+        else
+            value->asUnsigned = *((unsigned long*) newParameterValue);
+
+        if (index == FAKEHV_PW || index == FAKEHV_VSET)
+            FakeHV_StartRamp(slot, listOfChannelsToWrite[i]);
+    }
+
+    return 0;
+}
+
+int FakeHV_GetChannelParameter(
+    /* In */ int handle,
+    /* In */ unsigned short slot,
+    /* In */ const char* parameter,
+    /* In */ unsigned short channelListSize,
+    /* In */ const unsigned short* listOfChannelsToRead,
+    /* Out */ void* listOfParameterValues
+)
+{
+    // The handle and slot are checked before the name is looked at.
+    if (!FakeHV_HandleAndSlotAreValid(handle, slot))
+        return -1;
+
+    return FakeHV_GetChannelParameterById(
+        handle,
+        slot,
+        FakeHV_FindParameter(parameter),
+        channelListSize,
+        listOfChannelsToRead,
+        listOfParameterValues
+    );
+}
+
+int FakeHV_SetChannelParameter(
+    /* In */ int handle,
+    /* In */ unsigned short slot,
+    /* In */ const char* parameter,
+    /* In */ unsigned short channelListSize,
+    /* In */ const unsigned short* listOfChannelsToWrite,
+    /* In */ void* newParameterValue
+)
+{
+    if (!FakeHV_HandleAndSlotAreValid(handle, slot))
+        return -1;
+
+    return FakeHV_SetChannelParameterById(
+        handle,
+        slot,
+        FakeHV_FindParameter(parameter),
+        channelListSize,
+        listOfChannelsToWrite,
+        newParameterValue
+    );
+}
+
+int FakeHV_GetChannelParameterProperty(
+    /* In */ int handle,
+    /* In */ unsigned short slot,
+    /* In */ unsigned short channel,
+    /* In */ const char* parameter,
+    /* In */ const char* property,
+    /* Out */ void* value
+)
+{
+    if (FakeHV_LinkDown)
+    {
+        FakeHV_ErrorCode = FAKEHV_LINK_IS_DOWN;
+        return FAKEHV_LINK_DOWN;
     }
 
-    if (!isInList)
+    if (!FakeHV_HandleAndSlotAreValid(handle, slot))
+        return -1;
+
+    if (!FakeHV_ChannelsAreValid(slot, 1, &channel))
+        return -1;
+
+    unsigned short index = FakeHV_FindParameter(parameter);
+
+    if (index == FAKEHV_NUMBER_OF_PARAMETERS || FakeHV_ParameterTypes[index] != PARAMETER_TYPE_FLOAT)
     {
         FakeHV_ErrorCode = FAKEHV_INVALID_PARAMETER;
         return -1;
     }
 
-    if (listOfChannelsToWrite == NULL)
+    if (property == NULL || value == NULL)
     {
         FakeHV_ErrorCode = FAKEHV_POINTER_IS_NULL;
         return -1;
     }
 
-    if (channelListSize > 4)
+    const float* limits = FakeHV_HasLimits[slot][index] ? FakeHV_Limits[slot][index] : FakeHV_DefaultLimits[index];
+
+    // A board that reports no range for the parameter has no such property.
+    if (limits[0] > limits[1])
     {
-        FakeHV_ErrorCode = FAKEHV_TOO_MANY_CHANNELS;
+        FakeHV_ErrorCode = FAKEHV_INVALID_PROPERTY;
         return -1;
     }
 
-    if (newParameterValue == NULL)
+    if (strcmp(property, "Minval") == 0)
     {
-        FakeHV_ErrorCode = FAKEHV_POINTER_IS_NULL;
+        *((float*) value) = limits[0];
+    }
+    else if (strcmp(property, "Maxval") == 0)
+    {
+        *((float*) value) = limits[1];
+    }
+    else
+    {
+        FakeHV_ErrorCode = FAKEHV_INVALID_PROPERTY;
         return -1;
     }
 
@@ -370,6 +691,14 @@ char* FakeHV_GetError(/* In */ int handle)
         return "Error [7]: Invalid Parameter Received";
     case FAKEHV_TOO_MANY_CHANNELS:
         return "Error [8]: Invalid Number of Channels Received";
+    case FAKEHV_INVALID_CHANNEL:
+        return "Error [9]: Channel Not Present In Slot";
+    case FAKEHV_LINK_IS_DOWN:
+        return "Error [10]: Communication Link Is Down";
+    case FAKEHV_READ_FAILED:
+        return "Error [11]: Parameter Could Not Be Read";
+    case FAKEHV_INVALID_PROPERTY:
+        return "Error [12]: Invalid Property Received";
     default:
         return "Error [?]: Unknown Error Code";
     }
@@ -385,4 +714,105 @@ int FakeHV_Free(/* In */ void* resource)
 
     free(resource);
     return 0;
+}
+
+int FakeHV_SetCrateLayout(
+    /* In */ unsigned short numberOfSlots,
+    /* In */ const unsigned short* channelsPerSlot
+)
+{
+    if (channelsPerSlot == NULL)
+    {
+        FakeHV_ErrorCode = FAKEHV_POINTER_IS_NULL;
+        return -1;
+    }
+
+    if (numberOfSlots == 0 || numberOfSlots > FAKEHV_MAX_SLOTS)
+    {
+        FakeHV_ErrorCode = FAKEHV_INCORRECT_SLOT;
+        return -1;
+    }
+
+    for (int i = 0; i < numberOfSlots; ++i)
+    {
+        if (channelsPerSlot[i] > FAKEHV_MAX_CHANNELS_PER_SLOT)
+        {
+            FakeHV_ErrorCode = FAKEHV_TOO_MANY_CHANNELS;
+            return -1;
+        }
+    }
+
+    FakeHV_NumberOfSlots = numberOfSlots;
+
+    for (int i = 0; i < FAKEHV_MAX_SLOTS; ++i)
+        FakeHV_ChannelsPerSlot[i] = (i < numberOfSlots) ? channelsPerSlot[i] : 0;
+
+    return 0;
+}
+
+int FakeHV_SetParameterLimits(
+    /* In */ unsigned short slot,
+    /* In */ const char* parameter,
+    /* In */ float minimum,
+    /* In */ float maximum
+)
+{
+    if (slot >= FAKEHV_MAX_SLOTS)
+    {
+        FakeHV_ErrorCode = FAKEHV_INCORRECT_SLOT;
+        return -1;
+    }
+
+    unsigned short index = FakeHV_FindParameter(parameter);
+
+    if (index == FAKEHV_NUMBER_OF_PARAMETERS || FakeHV_ParameterTypes[index] != PARAMETER_TYPE_FLOAT)
+    {
+        FakeHV_ErrorCode = FAKEHV_INVALID_PARAMETER;
+        return -1;
+    }
+
+    FakeHV_Limits[slot][index][0] = minimum;
+    FakeHV_Limits[slot][index][1] = maximum;
+    FakeHV_HasLimits[slot][index] = 1;
+
+    return 0;
+}
+
+void FakeHV_SetSingleChannelSets(/* In */ int enabled)
+{
+    FakeHV_SingleChannelSets = enabled;
+}
+
+void FakeHV_SetLinkDown(/* In */ int down)
+{
+    FakeHV_LinkDown = down;
+}
+
+void FakeHV_SetFailingRead(/* In */ const char* parameter)
+{
+    if (parameter == NULL)
+    {
+        FakeHV_FailingRead = -1;
+        return;
+    }
+
+    unsigned short index = FakeHV_FindParameter(parameter);
+    FakeHV_FailingRead = (index < FAKEHV_NUMBER_OF_PARAMETERS) ? index : -1;
+}
+
+void FakeHV_SetTimeSource(/* In */ double (*now)(void))
+{
+    FakeHV_Now = now;
+    memset(FakeHV_Ramps, 0, sizeof(FakeHV_Ramps));
+}
+
+void FakeHV_Reset(void)
+{
+    memset(FakeHV_State, 0, sizeof(FakeHV_State));
+    memset(FakeHV_Ramps, 0, sizeof(FakeHV_Ramps));
+    memset(FakeHV_HasLimits, 0, sizeof(FakeHV_HasLimits));
+    FakeHV_Now = NULL;
+    FakeHV_SingleChannelSets = 0;
+    FakeHV_LinkDown = 0;
+    FakeHV_FailingRead = -1;
 }
\ No newline at end of file
@@ -7,6 +7,9 @@
 extern "C" {
 #endif /* __cplusplus */
 
+/* What every call returns while the link is down, see FakeHV_SetLinkDown. */
+#define FAKEHV_LINK_DOWN -2
+
 int FakeHV_InitializeSystem(
     /* In */ int system,
     /* In */ int linkType,
@@ -47,10 +50,105 @@ int FakeHV_SetChannelParameter(
     /* In */ void* newParameterValue
 );
 
+/*
+ * The same, with the parameter given by its index in the parameter table
+ * (VSet, VMon, ISet, ImonRange, IMonL, IMonH, MaxV, RUp, RDwn, Trip, PDwn,
+ * Polarity, ChStatus, Pw) rather than by name, so no string is compared.
+ */
+int FakeHV_GetChannelParameterById(
+    /* In */ int handle,
+    /* In */ unsigned short slot,
+    /* In */ unsigned short parameterId,
+    /* In */ unsigned short channelListSize,
+    /* In */ const unsigned short* listOfChannelsToRead,
+    /* Out */ void* listOfParameterValues
+);
+
+int FakeHV_SetChannelParameterById(
+    /* In */ int handle,
+    /* In */ unsigned short slot,
+    /* In */ unsigned short parameterId,
+    /* In */ unsigned short channelListSize,
+    /* In */ const unsigned short* listOfChannelsToWrite,
+    /* In */ void* newParameterValue
+);
+
+/*
+ * Reads a property of a channel parameter, as CAENHV_GetChParamProp does.
+ * Only "Minval" and "Maxval" of the float parameters are known, and are
+ * written to `value` as a float. Every board reports the ranges of an N1471
+ * unless FakeHV_SetParameterLimits says otherwise.
+ */
+int FakeHV_GetChannelParameterProperty(
+    /* In */ int handle,
+    /* In */ unsigned short slot,
+    /* In */ unsigned short channel,
+    /* In */ const char* parameter,
+    /* In */ const char* property,
+    /* Out */ void* value
+);
+
 char* FakeHV_GetError(/* In */ int handle);
 
+/* 
+ * Describes the virtual crate. Slot k holds a board with channelsPerSlot[k]
+ * channels, or is empty when that is 0. The default is a single four channel
+ * board in slot 0, like an N1470.
+ */
+int FakeHV_SetCrateLayout(
+    /* In */ unsigned short numberOfSlots,
+    /* In */ const unsigned short* channelsPerSlot
+);
+
 int FakeHV_Free(/* In */ void* resource);
 
+/*
+ * Makes the board in `slot` report its own range for one float parameter
+ * (by name, such as "VSet"), to mimic boards other than the N1471. A minimum
+ * above the maximum makes it report no range for the parameter at all.
+ */
+int FakeHV_SetParameterLimits(
+    /* In */ unsigned short slot,
+    /* In */ const char* parameter,
+    /* In */ float minimum,
+    /* In */ float maximum
+);
+
+/*
+ * Mimics supplies that only apply a multi-channel write to the first channel
+ * in the list, which is what the batched set in HVInterface has to detect.
+ */
+void FakeHV_SetSingleChannelSets(/* In */ int enabled);
+
+/*
+ * Mimics the USB link dropping: while down, every call fails with
+ * FAKEHV_LINK_DOWN, including attempts to connect again. The values written
+ * survive, as they would on a supply that stayed powered.
+ */
+void FakeHV_SetLinkDown(/* In */ int down);
+
+/*
+ * Makes every read of one parameter (by name, such as "IMonH") fail with -1
+ * while the link stays up, as a supply does that answers but cannot serve a
+ * reading. Other parameters read as usual. NULL makes reads succeed again.
+ */
+void FakeHV_SetFailingRead(/* In */ const char* parameter);
+
+/*
+ * Makes channels ramp: once `now` is set, switching a channel on or off, or
+ * changing its VSet, moves VMon toward the new target at RUp or RDwn volts
+ * per second, with the ON, RAMP_UP and RAMP_DOWN bits of ChStatus to match.
+ * `now` returns seconds since any fixed point, so a program can run the
+ * supply on a clock of its own. NULL turns ramping off again.
+ */
+void FakeHV_SetTimeSource(/* In */ double (*now)(void));
+
+/*
+ * Forgets every value written so far, brings the link back up, makes every
+ * read succeed, turns ramping off and puts back the N1471 ranges.
+ */
+void FakeHV_Reset(void);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
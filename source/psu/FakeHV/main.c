@@ -14,7 +14,9 @@ enum {
     FAKEHV_INCORRECT_SLOT,
     FAKEHV_POINTER_IS_NULL,
     FAKEHV_INVALID_PARAMETER,
-    FAKEHV_TOO_MANY_CHANNELS
+    FAKEHV_TOO_MANY_CHANNELS,
+    FAKEHV_INVALID_CHANNEL,
+    FAKEHV_LINK_IS_DOWN
 };
 
 void test_valid_connection()
@@ -444,6 +446,224 @@ void test_free()
     puts("Values freed");
 }
 
+void test_crate_map_multiple_slots()
+{
+    int handle = 0;
+    const unsigned short layout[] = { 4, 0, 12 };
+    unsigned short numberOfSlots;
+    unsigned short* listOfChannelsIndexedBySlot;
+    char* listOfModelsIndexedBySlot;
+    char* descriptionList;
+    unsigned short* listOfSerialNumbersIndexedBySlot;
+    unsigned char* listOfFirmwareSuffixesIndexedBySlot;
+    unsigned char* listOfFirmwarePrefixesIndexedBySlot;
+
+    assert(FakeHV_SetCrateLayout(3, layout) == 0);
+
+    int result = FakeHV_GetCrateMap(
+        handle,
+        &numberOfSlots,
+        &listOfChannelsIndexedBySlot,
+        &listOfModelsIndexedBySlot,
+        &descriptionList,
+        &listOfSerialNumbersIndexedBySlot,
+        &listOfFirmwareSuffixesIndexedBySlot,
+        &listOfFirmwarePrefixesIndexedBySlot
+    );
+
+    assert(result == 0);
+    assert(numberOfSlots == 3);
+    assert(listOfChannelsIndexedBySlot[1] == 0);
+    assert(listOfChannelsIndexedBySlot[2] == 12);
+
+    // Names are packed one after another, empty for the empty slot.
+    const char* model = listOfModelsIndexedBySlot;
+    assert(strcmp(model, "VIRTUAL") == 0);
+    model += strlen(model) + 1;
+    assert(strcmp(model, "") == 0);
+    model += strlen(model) + 1;
+    assert(strcmp(model, "VIRTUAL") == 0);
+
+    const unsigned short channels[] = { 0, 11 };
+    float values[2];
+    assert(FakeHV_GetChannelParameter(handle, 2, "VMon", 2, channels, values) == 0);
+    assert(FakeHV_GetChannelParameter(handle, 1, "VMon", 1, channels, values) == -1);
+    assert(FakeHV_GetChannelParameter(handle, 0, "VMon", 2, channels, values) == -1);
+
+    free(listOfChannelsIndexedBySlot);
+    free(listOfModelsIndexedBySlot);
+    free(descriptionList);
+    free(listOfSerialNumbersIndexedBySlot);
+    free(listOfFirmwareSuffixesIndexedBySlot);
+    free(listOfFirmwarePrefixesIndexedBySlot);
+
+    const unsigned short defaultLayout[] = { 4 };
+    FakeHV_SetCrateLayout(1, defaultLayout);
+    puts("[TEST] test_crate_map_multiple_slots: PASSED");
+}
+
+void test_set_then_get()
+{
+    int handle = 0;
+    const unsigned short channels[] = { 0, 1, 2, 3 };
+    float value = 1500.0f;
+    float readBack[4];
+
+    assert(FakeHV_SetChannelParameter(handle, 0, "VSet", 4, channels, &value) == 0);
+    assert(FakeHV_GetChannelParameter(handle, 0, "VSet", 4, channels, readBack) == 0);
+    assert(readBack[0] == 1500.0f && readBack[3] == 1500.0f);
+
+    // Only the first channel of a multi-channel write takes.
+    value = 2000.0f;
+    FakeHV_SetSingleChannelSets(1);
+    assert(FakeHV_SetChannelParameter(handle, 0, "VSet", 4, channels, &value) == 0);
+    assert(FakeHV_GetChannelParameter(handle, 0, "VSet", 4, channels, readBack) == 0);
+    assert(readBack[0] == 2000.0f && readBack[1] == 1500.0f);
+
+    FakeHV_Reset();
+    assert(FakeHV_GetChannelParameter(handle, 0, "VSet", 4, channels, readBack) == 0);
+    assert(readBack[0] == 0.0f);
+    puts("[TEST] test_set_then_get: PASSED");
+}
+
+void test_link_down()
+{
+    int handle = 0;
+    const unsigned short channels[] = { 0, 1 };
+    float value = 1200.0f;
+    float readBack[2];
+
+    assert(FakeHV_SetChannelParameter(handle, 0, "VSet", 2, channels, &value) == 0);
+
+    FakeHV_SetLinkDown(1);
+    assert(FakeHV_GetChannelParameter(handle, 0, "VSet", 2, channels, readBack) == FAKEHV_LINK_DOWN);
+    assert(FakeHV_SetChannelParameter(handle, 0, "VSet", 2, channels, &value) == FAKEHV_LINK_DOWN);
+    assert(FakeHV_InitializeSystem(0, 0, "", "", "", &handle) == FAKEHV_LINK_DOWN);
+    assert(strcmp(FakeHV_GetError(handle), "Error [10]: Communication Link Is Down") == 0);
+
+    // Values survive the link coming back.
+    FakeHV_SetLinkDown(0);
+    assert(FakeHV_InitializeSystem(0, 0, "", "", "", &handle) == 0);
+    assert(FakeHV_GetChannelParameter(handle, 0, "VSet", 2, channels, readBack) == 0);
+    assert(readBack[0] == 1200.0f && readBack[1] == 1200.0f);
+
+    FakeHV_Reset();
+    puts("[TEST] test_link_down: PASSED");
+}
+
+void test_failing_read()
+{
+    int handle = 0;
+    const unsigned short channels[] = { 0, 1 };
+    float current = 12.5f;
+    float readBack[2] = { -1.0f, -1.0f };
+
+    assert(FakeHV_SetChannelParameter(handle, 0, "IMonH", 2, channels, &current) == 0);
+
+    // The current cannot be read, but the link and everything else are fine.
+    FakeHV_SetFailingRead("IMonH");
+    assert(FakeHV_GetChannelParameter(handle, 0, "IMonH", 2, channels, readBack) == -1);
+    assert(strcmp(FakeHV_GetError(handle), "Error [11]: Parameter Could Not Be Read") == 0);
+    assert(readBack[0] == -1.0f && readBack[1] == -1.0f);
+    assert(FakeHV_GetChannelParameter(handle, 0, "VMon", 2, channels, readBack) == 0);
+    assert(FakeHV_InitializeSystem(0, 0, "", "", "", &handle) == 0);
+
+    FakeHV_SetFailingRead(NULL);
+    assert(FakeHV_GetChannelParameter(handle, 0, "IMonH", 2, channels, readBack) == 0);
+    assert(readBack[0] == 12.5f && readBack[1] == 12.5f);
+
+    FakeHV_Reset();
+    puts("[TEST] test_failing_read: PASSED");
+}
+
+void test_parameter_limits()
+{
+    int handle = 0;
+    float minimum = -1.0f;
+    float maximum = -1.0f;
+    unsigned long polarity;
+
+    // An N1471 unless told otherwise.
+    assert(FakeHV_GetChannelParameterProperty(handle, 0, 0, "VSet", "Minval", &minimum) == 0);
+    assert(FakeHV_GetChannelParameterProperty(handle, 0, 0, "VSet", "Maxval", &maximum) == 0);
+    assert(minimum == 0.0f && maximum == 5500.0f);
+
+    // An N1470 in slot 0 reaches 8 kV and 3 mA.
+    assert(FakeHV_SetParameterLimits(0, "VSet", 0.0f, 8000.0f) == 0);
+    assert(FakeHV_SetParameterLimits(0, "ISet", 0.0f, 3000.0f) == 0);
+    assert(FakeHV_GetChannelParameterProperty(handle, 0, 3, "VSet", "Maxval", &maximum) == 0);
+    assert(maximum == 8000.0f);
+    assert(FakeHV_GetChannelParameterProperty(handle, 0, 3, "ISet", "Maxval", &maximum) == 0);
+    assert(maximum == 3000.0f);
+
+    // A board can report no range, and switches never have one.
+    assert(FakeHV_SetParameterLimits(0, "Trip", 1.0f, 0.0f) == 0);
+    assert(FakeHV_GetChannelParameterProperty(handle, 0, 0, "Trip", "Maxval", &maximum) == -1);
+    assert(strcmp(FakeHV_GetError(handle), "Error [12]: Invalid Property Received") == 0);
+    assert(FakeHV_GetChannelParameterProperty(handle, 0, 0, "VSet", "Exp", &maximum) == -1);
+    assert(FakeHV_GetChannelParameterProperty(handle, 0, 0, "Pw", "Maxval", &polarity) == -1);
+    assert(FakeHV_GetChannelParameterProperty(handle, 0, 4, "VSet", "Maxval", &maximum) == -1);
+    assert(FakeHV_SetParameterLimits(0, "Polarity", 0.0f, 1.0f) == -1);
+
+    FakeHV_Reset();
+    assert(FakeHV_GetChannelParameterProperty(handle, 0, 0, "VSet", "Maxval", &maximum) == 0);
+    assert(maximum == 5500.0f);
+
+    puts("[TEST] test_parameter_limits: PASSED");
+}
+
+static double fakeTime = 0.0;
+
+static double fakeNow(void)
+{
+    return fakeTime;
+}
+
+void test_ramp()
+{
+    int handle = 0;
+    const unsigned short channels[] = { 0 };
+    float voltage = 1000.0f;
+    float rate = 100.0f;
+    unsigned long on = 1;
+    unsigned long off = 0;
+    float vmon;
+    unsigned long status;
+
+    fakeTime = 0.0;
+    FakeHV_SetTimeSource(fakeNow);
+
+    assert(FakeHV_SetChannelParameter(handle, 0, "VSet", 1, channels, &voltage) == 0);
+    assert(FakeHV_SetChannelParameter(handle, 0, "RUp", 1, channels, &rate) == 0);
+    assert(FakeHV_SetChannelParameter(handle, 0, "RDwn", 1, channels, &rate) == 0);
+    assert(FakeHV_SetChannelParameter(handle, 0, "Pw", 1, channels, &on) == 0);
+
+    // Half way up after five seconds, and there after ten.
+    fakeTime = 5.0;
+    assert(FakeHV_GetChannelParameter(handle, 0, "VMon", 1, channels, &vmon) == 0);
+    assert(FakeHV_GetChannelParameter(handle, 0, "ChStatus", 1, channels, &status) == 0);
+    assert(vmon == 500.0f);
+    assert(status == 0x3);
+
+    fakeTime = 12.0;
+    assert(FakeHV_GetChannelParameter(handle, 0, "VMon", 1, channels, &vmon) == 0);
+    assert(FakeHV_GetChannelParameter(handle, 0, "ChStatus", 1, channels, &status) == 0);
+    assert(vmon == 1000.0f);
+    assert(status == 0x1);
+
+    // And back down from there.
+    assert(FakeHV_SetChannelParameter(handle, 0, "Pw", 1, channels, &off) == 0);
+
+    fakeTime = 14.0;
+    assert(FakeHV_GetChannelParameter(handle, 0, "VMon", 1, channels, &vmon) == 0);
+    assert(FakeHV_GetChannelParameter(handle, 0, "ChStatus", 1, channels, &status) == 0);
+    assert(vmon == 800.0f);
+    assert(status == 0x4);
+
+    FakeHV_Reset();
+    puts("[TEST] test_ramp: PASSED");
+}
+
 int main(int argc, char** argv)
 {
     test_valid_connection();
@@ -451,6 +671,7 @@ int main(int argc, char** argv)
     test_crate_map_bad_handle();
     test_crate_map_bad_number_of_slots();
     test_crate_map_return_values();
+    test_crate_map_multiple_slots();
     test_get_channel_bad_slot();
     test_get_channel_bad_parameter();
     test_get_channel_bad_channels_list();
@@ -462,6 +683,11 @@ int main(int argc, char** argv)
     test_set_channel_bad_parameter();
     test_set_channel_bad_list_of_channels();
     test_set_channel_new_parameter_is_null();
+    test_set_then_get();
+    test_link_down();
+    test_failing_read();
+    test_parameter_limits();
+    test_ramp();
     test_get_error();
     test_free();
     puts("Testing complete.");
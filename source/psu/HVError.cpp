@@ -0,0 +1,48 @@
+#include "HVError.hpp"
+
+#include <cstring>
+
+#include <fmt/core.h>
+
+void HVError::describe(const char* text)
+{
+    if (!text)
+        return;
+
+    std::strncpy(detail.data(), text, detail.size() - 1);
+    detail.back() = '\0';
+}
+
+std::string HVError::message() const
+{
+    switch (code)
+    {
+        case Code::InvalidChannel:
+            if (size)
+                return fmt::format("Invalid Channel Number {}. The crate has {} channels.", channel, size);
+            return "Invalid Channel Number";
+
+        case Code::TooManySlots:
+            return "Too many slots in one request";
+
+        case Code::BufferSize:
+            return fmt::format("{} values requested into room for {}", size, room);
+
+        case Code::GetParameter:
+            return fmt::format(
+                "GetChannelParameter Error [{}] for parameter [{}] on slot {}: {}",
+                result,
+                hv::info(parameter).name,
+                slot,
+                detail.data()
+            );
+
+        case Code::SetParameter:
+            return fmt::format("SetChannelParameter Error {}: {}", result, detail.data());
+
+        case Code::NotConnected:
+            return "Not connected to the power supply";
+    }
+
+    return "Unknown HVInterface Error";
+}
@@ -0,0 +1,40 @@
+// HVError.hpp
+
+#pragma once
+
+#include <array>
+#include <string>
+
+#include "Parameters.hpp"
+
+// What went wrong in a call to the supply, as returned by the non-throwing
+// HVInterface API. Building one costs no allocation: the message is only
+// formatted when somebody asks for it, and the library's own description of
+// the error is copied into a fixed buffer, since the library reuses its
+// buffer on the next failure.
+struct HVError
+{
+    enum class Code
+    {
+        InvalidChannel,
+        TooManySlots,
+        BufferSize,
+        GetParameter,
+        SetParameter,
+        NotConnected
+    };
+
+    Code code;
+    int result                  { 0 };
+    hv::ParameterId parameter   { hv::ParameterId::VSet };
+    unsigned short slot         { 0 };
+    int channel                 { -1 };
+    std::size_t size            { 0 };
+    std::size_t room            { 0 };
+    bool linkLost               { false };
+    std::array<char, 128> detail {};
+
+    void describe(const char* text);
+
+    std::string message() const;
+};
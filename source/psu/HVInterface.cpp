@@ -1,5 +1,7 @@
 #include "HVInterface.hpp"
 
+#include <cmath>
+#include <algorithm>
 #include <exception>
 
 #include <fmt/core.h>
@@ -8,13 +10,13 @@
 #include <spdlog/spdlog.h>
 #include <spdlog/sinks/stdout_color_sinks.h>
 
+#include <instrumentation/Metrics.hpp>
+
 #ifdef VIRTUALIZE_CONNECTION
     #include "FakeHV/FakeHVLibrary.h"
     #define InitializeSystem    FakeHV_InitializeSystem
     #define DeinitializeSystem  FakeHV_DeinitializeSystem
     #define GetCrateMap         FakeHV_GetCrateMap
-    #define GetChannelParameter FakeHV_GetChannelParameter
-    #define SetChannelParameter FakeHV_SetChannelParameter
     #define GetError            FakeHV_GetError
     #define Free                FakeHV_Free
 #else
@@ -22,36 +24,290 @@
     #define InitializeSystem    CAENHV_InitSystem
     #define DeinitializeSystem  CAENHV_DeinitSystem
     #define GetCrateMap         CAENHV_GetCrateMap
-    #define GetChannelParameter CAENHV_GetChParam
-    #define SetChannelParameter CAENHV_SetChParam
     #define GetError            CAENHV_GetError
     #define Free                CAENHV_Free
 #endif
 
-using CHVector = std::vector<int>;
-using FloatVector = std::vector<float>;
-using ULongVector = std::vector<unsigned long>;
 using SpdlogLogger = std::shared_ptr<spdlog::logger>;
 
-static std::vector<unsigned short> convert(std::vector<int> channels)
+using namespace std::chrono_literals;
+
+// How long a value read from the supply stays good. Polarity is set by the
+// hardware and only changes with the board, so it lives until we reconnect.
+// The configuration parameters only change when somebody writes them, which
+// we see when it is us. Anything that is monitored is never cached.
+static std::array<std::chrono::milliseconds, hv::parameterCount> defaultTimeToLive()
+{
+    std::array<std::chrono::milliseconds, hv::parameterCount> ttl;
+    ttl.fill(0ms);
+
+    ttl[hv::index(hv::Polarity.id)] = std::chrono::milliseconds::max();
+    ttl[hv::index(hv::VSet.id)] = 10s;
+    ttl[hv::index(hv::ISet.id)] = 10s;
+    ttl[hv::index(hv::MaxV.id)] = 10s;
+    ttl[hv::index(hv::RUp.id)] = 10s;
+    ttl[hv::index(hv::RDwn.id)] = 10s;
+    ttl[hv::index(hv::Trip.id)] = 10s;
+    ttl[hv::index(hv::PDwn.id)] = 10s;
+    ttl[hv::index(hv::ImonRange.id)] = 10s;
+
+    return ttl;
+}
+
+// Runs one library call under a timer, counting a nonzero result as an error.
+template <typename Call>
+static int timed(instrumentation::Operation operation, Call&& call)
+{
+    instrumentation::ScopedTimer timer(operation);
+    int result = (int) call();
+    timer.failed(result != 0);
+    return result;
+}
+
+// FakeHV takes the parameter id directly. The CAEN wrapper wants the name,
+// which the registry holds as a string literal, so neither builds a string.
+// Every call is timed into the global metrics, per parameter.
+static int getChannelParameter(
+    int handle, 
+    unsigned short slot, 
+    hv::ParameterId parameter, 
+    unsigned short channelListSize, 
+    const unsigned short* listOfChannels, 
+    void* listOfValues
+)
+{
+    instrumentation::ScopedTimer timer(instrumentation::Operation::GetChannelParameter, parameter);
+
+#ifdef VIRTUALIZE_CONNECTION
+    int result = FakeHV_GetChannelParameterById(
+        handle, slot, static_cast<unsigned short>(parameter), channelListSize, listOfChannels, listOfValues
+    );
+#else
+    int result = (int) CAENHV_GetChParam(
+        handle, slot, hv::info(parameter).name, channelListSize, listOfChannels, listOfValues
+    );
+#endif
+
+    timer.failed(result != 0);
+    return result;
+}
+
+static int setChannelParameter(
+    int handle, 
+    unsigned short slot, 
+    hv::ParameterId parameter, 
+    unsigned short channelListSize, 
+    const unsigned short* listOfChannels, 
+    void* value
+)
+{
+    instrumentation::ScopedTimer timer(instrumentation::Operation::SetChannelParameter, parameter);
+
+#ifdef VIRTUALIZE_CONNECTION
+    int result = FakeHV_SetChannelParameterById(
+        handle, slot, static_cast<unsigned short>(parameter), channelListSize, listOfChannels, value
+    );
+#else
+    int result = (int) CAENHV_SetChParam(
+        handle, slot, hv::info(parameter).name, channelListSize, listOfChannels, value
+    );
+#endif
+
+    timer.failed(result != 0);
+    return result;
+}
+
+// A property of a channel parameter, such as its "Minval", as the board
+// reports it.
+static int getChannelParameterProperty(
+    int handle, 
+    unsigned short slot, 
+    unsigned short channel, 
+    hv::ParameterId parameter, 
+    const char* property, 
+    void* value
+)
+{
+#ifdef VIRTUALIZE_CONNECTION
+    return FakeHV_GetChannelParameterProperty(handle, slot, channel, hv::info(parameter).name, property, value);
+#else
+    return (int) CAENHV_GetChParamProp(handle, slot, channel, hv::info(parameter).name, property, value);
+#endif
+}
+
+// Results that mean the link to the supply is gone, rather than that the
+// request was bad. The handle is of no more use after one of these.
+static bool linkLost(int result)
+{
+#ifdef VIRTUALIZE_CONNECTION
+    return result == FAKEHV_LINK_DOWN;
+#else
+    switch (result)
+    {
+        case CAENHV_WRITEERR:
+        case CAENHV_READERR:
+        case CAENHV_TIMEERR:
+        case CAENHV_DOWN:
+        case CAENHV_COMMUNICATIONERROR:
+        case CAENHV_NOTCONNECTED:
+            return true;
+        default:
+            return false;
+    }
+#endif
+}
+
+// The channels of one request grouped by slot, in the order the slots first
+// appear, with where each channel sits in the caller's list so the results
+// can be put back in order. Batch b is [first[b], first[b + 1]). Everything
+// is inline, so grouping a request allocates nothing.
+struct SlotBatches
+{
+    static constexpr std::size_t maxSlots = 32;
+
+    std::size_t count { 0 };
+    std::array<unsigned short, maxSlots> slot;
+    std::array<std::size_t, maxSlots + 1> first;
+    std::array<unsigned short, ChannelSet::capacity> channels;
+    std::array<unsigned short, ChannelSet::capacity> positions;
+
+    std::span<const unsigned short> channelsOf(std::size_t b) const
+    {
+        return { channels.data() + first[b], first[b + 1] - first[b] };
+    }
+
+    std::span<const unsigned short> positionsOf(std::size_t b) const
+    {
+        return { positions.data() + first[b], first[b + 1] - first[b] };
+    }
+};
+
+static std::expected<ChannelAddress, HVError> locate(int channel, const std::vector<ChannelAddress>& channelMap)
+{
+    if (channelMap.empty())
+    {
+        if (channel < 0 || channel > 0xFFFF)
+            return std::unexpected(HVError { .code = HVError::Code::InvalidChannel, .channel = channel });
+
+        return ChannelAddress { 0, static_cast<unsigned short>(channel) };
+    }
+
+    if (channel < 0 || channel >= static_cast<int>(channelMap.size()))
+    {
+        return std::unexpected(HVError {
+            .code = HVError::Code::InvalidChannel,
+            .channel = channel,
+            .size = channelMap.size()
+        });
+    }
+
+    return channelMap[channel];
+}
+
+static std::expected<void, HVError> group(const ChannelSet& channels, const std::vector<ChannelAddress>& channelMap, SlotBatches& batches)
 {
-    if (channels.size() > 4)
-        throw std::runtime_error("Too Many Channels. Expected 4.");
+    std::array<ChannelAddress, ChannelSet::capacity> addresses;
+    std::array<unsigned short, ChannelSet::capacity> batchOf;
+    std::array<std::size_t, SlotBatches::maxSlots> sizes {};
+
+    batches.count = 0;
+
+    for (std::size_t i = 0; i < channels.size(); ++i)
+    {
+        auto address = locate(channels[i], channelMap);
+
+        if (!address)
+            return std::unexpected(address.error());
+
+        addresses[i] = *address;
+
+        // A crate has a handful of slots, so a linear search is enough.
+        std::size_t b = 0;
+
+        while (b < batches.count && batches.slot[b] != addresses[i].slot)
+            ++b;
+
+        if (b == batches.count)
+        {
+            if (batches.count == SlotBatches::maxSlots)
+                return std::unexpected(HVError { .code = HVError::Code::TooManySlots, .slot = addresses[i].slot });
 
-    if (channels.size() < 0)
-        throw std::runtime_error("Too Few Channels. Expected At Least 1.");
+            batches.slot[batches.count++] = addresses[i].slot;
+        }
+
+        batchOf[i] = static_cast<unsigned short>(b);
+        ++sizes[b];
+    }
+
+    batches.first[0] = 0;
+
+    for (std::size_t b = 0; b < batches.count; ++b)
+        batches.first[b + 1] = batches.first[b] + sizes[b];
 
-    std::vector<unsigned short> convertedChannels;
+    // Reused as the next free place in each batch.
+    for (std::size_t b = 0; b < batches.count; ++b)
+        sizes[b] = batches.first[b];
 
-    for (const auto& elem : channels)
+    for (std::size_t i = 0; i < channels.size(); ++i)
     {
-        if (elem < 0 || elem > 0xFFFF)
-            throw std::runtime_error("Invalid Channel Number");
+        auto k = sizes[batchOf[i]]++;
 
-        convertedChannels.push_back(std::make_unsigned<short>::type(elem));
+        batches.channels[k] = addresses[i].channel;
+        batches.positions[k] = static_cast<unsigned short>(i);
     }
 
-    return convertedChannels;
+    return {};
+}
+
+// Errors that are thrown are logged once, where they are thrown.
+[[noreturn]] static void raise(const HVError& error, SpdlogLogger logger)
+{
+    auto msg = error.message();
+
+    if (logger)
+        logger->error(msg);
+
+    throw std::runtime_error(msg);
+}
+
+// The ranges the board in `slot` reports for the float parameters we write,
+// read from its first channel; the channels of a board share them. A board
+// that does not answer for a parameter leaves it unknown.
+static std::array<ParameterLimits, hv::parameterCount> get_limits(SpdlogLogger logger, int handle, unsigned short slot)
+{
+    std::array<ParameterLimits, hv::parameterCount> limits;
+
+    for (const auto& parameter : { hv::VSet.id, hv::ISet.id, hv::MaxV.id, hv::RUp.id, hv::RDwn.id, hv::Trip.id })
+    {
+        float minimum = 0.0f;
+        float maximum = 0.0f;
+
+        auto result = timed(instrumentation::Operation::ParameterLimits, [&] {
+            return getChannelParameterProperty(handle, slot, 0, parameter, "Minval", &minimum);
+        });
+
+        if (!result)
+        {
+            result = timed(instrumentation::Operation::ParameterLimits, [&] {
+                return getChannelParameterProperty(handle, slot, 0, parameter, "Maxval", &maximum);
+            });
+        }
+
+        if (result || minimum > maximum)
+        {
+            if (logger)
+                logger->debug("Slot {} reports no range for {}", slot, hv::info(parameter).name);
+
+            continue;
+        }
+
+        limits[hv::index(parameter)] = { .Minimum = minimum, .Maximum = maximum, .Known = true };
+
+        if (logger)
+            logger->debug("Slot {}: {} from {} to {}", slot, hv::info(parameter).name, minimum, maximum);
+    }
+
+    return limits;
 }
 
 static PowerSupplyProperties get_crate_map(SpdlogLogger logger, int handle)
@@ -67,16 +323,18 @@ static PowerSupplyProperties get_crate_map(SpdlogLogger logger, int handle)
     unsigned char* listOfFirmwareSuffixesIndexedBySlot = nullptr;
     unsigned char* listOfFirmwarePrefixesIndexedBySlot = nullptr;
 
-    auto result = (int) GetCrateMap(
-        handle,
-        &numberOfSlots,
-        &listOfChannelsIndexedBySlot,
-        &listOfModelsIndexedBySlot,
-        &descriptionList,
-        &listOfSerialNumbersIndexedBySlot,
-        &listOfFirmwareSuffixesIndexedBySlot,
-        &listOfFirmwarePrefixesIndexedBySlot
-    );
+    auto result = timed(instrumentation::Operation::CrateMap, [&] {
+        return GetCrateMap(
+            handle,
+            &numberOfSlots,
+            &listOfChannelsIndexedBySlot,
+            &listOfModelsIndexedBySlot,
+            &descriptionList,
+            &listOfSerialNumbersIndexedBySlot,
+            &listOfFirmwareSuffixesIndexedBySlot,
+            &listOfFirmwarePrefixesIndexedBySlot
+        );
+    });
 
     if (result)
     {
@@ -103,16 +361,40 @@ static PowerSupplyProperties get_crate_map(SpdlogLogger logger, int handle)
         throw std::runtime_error(msg);
     }
 
-    properties.Board = "Board 0";
-    properties.Model = listOfModelsIndexedBySlot[0];
-    properties.Description = descriptionList[0];
-    properties.NumberOfSlots = std::to_string(numberOfSlots);
-    properties.ChannelsAvailable = std::to_string(listOfChannelsIndexedBySlot[0]);
-    properties.Serial = std::to_string(listOfSerialNumbersIndexedBySlot[0]);
-    properties.Firmware = \
-        std::to_string(listOfFirmwarePrefixesIndexedBySlot[0]) 
-        + "."
-        + std::to_string(listOfFirmwareSuffixesIndexedBySlot[0]);
+    // Models and descriptions come as NUL-terminated strings packed one after
+    // the other, one per slot, so we walk them rather than index them.
+    const char* model = listOfModelsIndexedBySlot;
+    const char* description = descriptionList;
+
+    int channelsAvailable = 0;
+    std::vector<unsigned short> populated;
+
+    for (unsigned short slot = 0; slot < numberOfSlots; ++slot)
+    {
+        SlotProperties slotProperties;
+
+        slotProperties.Slot = slot;
+        slotProperties.Channels = listOfChannelsIndexedBySlot[slot];
+        slotProperties.Model = model;
+        slotProperties.Description = description;
+        slotProperties.Serial = std::to_string(listOfSerialNumbersIndexedBySlot[slot]);
+        slotProperties.Firmware = \
+            std::to_string(listOfFirmwarePrefixesIndexedBySlot[slot]) 
+            + "."
+            + std::to_string(listOfFirmwareSuffixesIndexedBySlot[slot]);
+
+        model += slotProperties.Model.size() + 1;
+        description += slotProperties.Description.size() + 1;
+
+        if (slotProperties.Channels)
+        {
+            channelsAvailable += slotProperties.Channels;
+            populated.push_back(slot);
+            slotProperties.Limits = get_limits(logger, handle, slot);
+        }
+
+        properties.Slots.push_back(slotProperties);
+    }
 
     Free(listOfChannelsIndexedBySlot);
     Free(listOfModelsIndexedBySlot);
@@ -121,137 +403,274 @@ static PowerSupplyProperties get_crate_map(SpdlogLogger logger, int handle)
     Free(listOfFirmwareSuffixesIndexedBySlot);
     Free(listOfFirmwarePrefixesIndexedBySlot);
 
-    return properties;
-}
+    properties.NumberOfSlots = std::to_string(numberOfSlots);
+    properties.ChannelsAvailable = std::to_string(channelsAvailable);
 
-template <typename T>
-static void setParameters(std::string parameter, T value, CHVector channels, SpdlogLogger logger, int handle)
-{
-    std::vector<unsigned short> v;
-    try
-    {
-        v = convert(channels);
-    }
-    catch(const std::exception& e)
+    // The summary describes the first board. The rest are in Slots.
+    if (!populated.empty())
     {
-        logger->error("HVInterface Error: {}", e.what());
-        throw;
-    }
-
-    // We create explicit variables, which will be passed into the function.
-    unsigned short slot = 0;
-    const char* param = parameter.c_str();
+        const auto& first = properties.Slots[populated.front()];
 
-    // BUG: It appears that simultaneous sets to parameters (i.e. passing more
-    // than a single channel in) do not actually set all channels. We'll have to
-    // iterate then.
+        properties.Board = fmt::format("Board {}", fmt::join(populated, ", "));
+        properties.Model = first.Model;
+        properties.Description = first.Description;
+        properties.Serial = first.Serial;
+        properties.Firmware = first.Firmware;
+    }
 
-    // unsigned short channelListSize = (unsigned short) channels.size();
-    // const unsigned short* listOfChannelsToWrite = channels.data();
+    return properties;
+}
 
-    unsigned short channelListSize = 1;
-    unsigned short listOfChannelsToWrite[1];
+// Some firmware only applies a write to several channels to the first one in
+// the list. Whether a given firmware does is found out on the first batched
+// write and remembered for the rest of the process.
+enum class BatchedSet
+{
+    Unknown,
+    Works,
+    Broken
+};
 
+static std::mutex batchedSetMutex;
+static std::map<std::string, BatchedSet> batchedSetSupport;
 
-    for (int i = 0; i < v.size(); ++i)
+static std::string firmwareOf(unsigned short slot, const PowerSupplyProperties& properties)
+{
+    for (const auto& slotProperties : properties.Slots)
     {
-        listOfChannelsToWrite[0] = v[i];
+        if (slotProperties.Slot == slot)
+            return slotProperties.Model + " " + slotProperties.Firmware;
+    }
 
-        auto result = (int) SetChannelParameter(
-            handle,
-            slot,
-            param,
-            channelListSize,
-            (const unsigned short*) listOfChannelsToWrite,
-            (void*) &value
-        );
+    return "unknown";
+}
 
-        if (result)
-        {
-            std::string msg = "SetChannelParameter Error ";
-            msg += std::to_string(result) + ": ";
-            msg += GetError(handle);
+static BatchedSet batchedSetFor(const std::string& firmware)
+{
+    std::lock_guard<std::mutex> lock(batchedSetMutex);
+    auto support = batchedSetSupport.find(firmware);
+    return (support == batchedSetSupport.end()) ? BatchedSet::Unknown : support->second;
+}
 
-            if (logger)
-                logger->error(msg);
+static void rememberBatchedSet(const std::string& firmware, BatchedSet support, SpdlogLogger logger)
+{
+    std::lock_guard<std::mutex> lock(batchedSetMutex);
+    batchedSetSupport[firmware] = support;
 
-            throw std::runtime_error(msg);
-        }
+    if (logger)
+        logger->info("Batched sets {} on {}", (support == BatchedSet::Works) ? "work" : "do not work", firmware);
+}
 
-        std::string msg = \
-            "CH" + std::to_string(v[i]) + ": "
-            + "Parameter " + parameter 
-            + " was set to " + std::to_string(value);
+template <typename T>
+static std::expected<void, HVError> writeSlot(
+    hv::ParameterId parameter, 
+    T value, 
+    unsigned short slot, 
+    std::span<const unsigned short> channels, 
+    int handle
+)
+{
+    auto result = setChannelParameter(
+        handle,
+        slot,
+        parameter,
+        (unsigned short) channels.size(),
+        channels.data(),
+        (void*) &value
+    );
 
-        if (logger)
-            logger->debug(msg);
+    if (result)
+    {
+        HVError error { .code = HVError::Code::SetParameter, .result = result, .parameter = parameter, .slot = slot };
+        error.linkLost = linkLost(result);
+        error.describe(GetError(handle));
+        return std::unexpected(error);
     }
+
+    return {};
 }
 
+// Reads one value per channel of the slot into `values`, which must be as
+// long as `channels`.
 template <typename T>
-static std::vector<T> getParameters(std::string parameter, CHVector channels, SpdlogLogger logger, int handle)
+static std::expected<void, HVError> readSlot(
+    hv::ParameterId parameter, 
+    unsigned short slot, 
+    std::span<const unsigned short> channels, 
+    std::span<T> values, 
+    int handle
+)
 {
-    std::vector<unsigned short> v;
-    try
+    auto result = getChannelParameter(
+        handle,
+        slot,
+        parameter,
+        (unsigned short) channels.size(),
+        channels.data(),
+        (void*) values.data()
+    );
+
+    if (result)
     {
-        v = convert(channels);
+        HVError error { .code = HVError::Code::GetParameter, .result = result, .parameter = parameter, .slot = slot };
+        error.linkLost = linkLost(result);
+        error.describe(GetError(handle));
+        return std::unexpected(error);
     }
-    catch(const std::exception& e)
+
+    return {};
+}
+
+// Puts the channels of `channels` whose read-back does not match `value`
+// into `result` and returns how many there are.
+template <typename T>
+static std::size_t missed(
+    hv::ParameterId parameter, 
+    std::span<const unsigned short> channels, 
+    std::span<const T> readBack, 
+    T value, 
+    std::span<unsigned short> result
+)
+{
+    std::size_t count = 0;
+
+    for (std::size_t k = 0; k < channels.size(); ++k)
     {
-        logger->error("HVInterface Error: {}", e.what());
-        throw;
+        if (!hv::matches(parameter, readBack[k], value))
+            result[count++] = channels[k];
     }
 
-    unsigned short slot = 0;
-    unsigned short channelListSize = (unsigned short) v.size();
-    const unsigned short* listOfChannelsToRead = v.data();
-    const char* param = parameter.c_str();
+    return count;
+}
 
-    std::vector<T> returnVector(v.size(), (T) 0);
+template <typename T>
+static std::expected<void, HVError> setParameters(
+    hv::ParameterId parameter, 
+    T value, 
+    const ChannelSet& channels, 
+    const std::vector<ChannelAddress>& channelMap, 
+    const PowerSupplyProperties& properties, 
+    SpdlogLogger logger, 
+    int handle
+)
+{
+    SlotBatches batches;
 
-    auto result = (int) GetChannelParameter(
-        handle,
-        slot,
-        param,
-        channelListSize,
-        listOfChannelsToRead,
-        (void*) returnVector.data()
-    );
+    if (auto grouped = group(channels, channelMap, batches); !grouped)
+        return grouped;
 
-    if (result)
+    for (std::size_t b = 0; b < batches.count; ++b)
     {
-        std::string msg = "GetChannelParameter Error [";
-        msg += std::to_string(result) + "] for parameter [";
-        msg += parameter + "]: ";
-        msg += GetError(handle);
+        auto slot = batches.slot[b];
+        auto slotChannels = batches.channelsOf(b);
+        auto firmware = firmwareOf(slot, properties);
+        auto support = batchedSetFor(firmware);
+
+        // Firmware known to drop all but the first channel gets one channel
+        // per call, as does a single channel.
+        if (slotChannels.size() == 1 || support == BatchedSet::Broken)
+        {
+            for (const auto& channel : slotChannels)
+            {
+                if (auto written = writeSlot<T>(parameter, value, slot, { &channel, 1 }, handle); !written)
+                    return written;
+            }
+        }
+        else
+        {
+            if (auto written = writeSlot<T>(parameter, value, slot, slotChannels, handle); !written)
+                return written;
+
+            if (support == BatchedSet::Unknown)
+            {
+                std::array<T, ChannelSet::capacity> readBack;
+                std::array<unsigned short, ChannelSet::capacity> retry;
+                std::array<unsigned short, ChannelSet::capacity> stillMissed;
+
+                // One read tells us which channels took the write. Only those
+                // that did not are written again, one at a time.
+                auto values = std::span<T>(readBack).first(slotChannels.size());
+                if (auto read = readSlot<T>(parameter, slot, slotChannels, values, handle); !read)
+                    return read;
+
+                auto retries = missed<T>(parameter, slotChannels, values, value, retry);
+
+                for (std::size_t k = 0; k < retries; ++k)
+                {
+                    if (auto written = writeSlot<T>(parameter, value, slot, { &retry[k], 1 }, handle); !written)
+                        return written;
+                }
+
+                if (retries == 0)
+                {
+                    rememberBatchedSet(firmware, BatchedSet::Works, logger);
+                }
+                else
+                {
+                    // If the single writes did not take either, the supply
+                    // is storing a different value (e.g. rounding), which says
+                    // nothing about batched writes.
+                    auto retried = std::span<const unsigned short>(retry).first(retries);
+                    auto again = std::span<T>(readBack).first(retries);
+
+                    if (auto read = readSlot<T>(parameter, slot, retried, again, handle); !read)
+                        return read;
+
+                    if (missed<T>(parameter, retried, again, value, stillMissed) < retries)
+                        rememberBatchedSet(firmware, BatchedSet::Broken, logger);
+                }
+            }
+        }
 
         if (logger)
-            logger->error(msg);
-
-        throw std::runtime_error(msg);
+            logger->debug("Slot {}: Parameter {} was set to {} on [ {} ]", slot, hv::info(parameter).name, value, fmt::join(slotChannels, ", "));
     }
 
-    /*
-    std::string msg = "Parameter " + parameter + " received: ( ";
-    for (int i = 0; i < channelListSize; ++i)
+    return {};
+}
+
+// Reads one value per channel into `values`, in the order of `channels`, with
+// one call per slot however many channels are on it. Nothing is logged on
+// failure; that is up to the caller.
+template <typename T>
+static std::expected<void, HVError> getParameters(
+    hv::ParameterId parameter, 
+    const ChannelSet& channels, 
+    std::span<T> values, 
+    const std::vector<ChannelAddress>& channelMap, 
+    SpdlogLogger logger, 
+    int handle
+)
+{
+    SlotBatches batches;
+
+    if (auto grouped = group(channels, channelMap, batches); !grouped)
+        return grouped;
+
+    std::array<T, ChannelSet::capacity> slotValues;
+
+    for (std::size_t b = 0; b < batches.count; ++b)
     {
-        msg += std::to_string(returnVector[i]) + ", ";
-    }
-    msg += ")";
+        auto slotChannels = batches.channelsOf(b);
+        auto positions = batches.positionsOf(b);
+        auto received = std::span<T>(slotValues).first(slotChannels.size());
 
-    if (logger)
-        logger->debug(msg);
+        if (auto read = readSlot<T>(parameter, batches.slot[b], slotChannels, received, handle); !read)
+            return read;
 
-    */
+        for (std::size_t k = 0; k < positions.size(); ++k)
+            values[positions[k]] = received[k];
+    }
 
-    logger->debug("Parameter \'{}\' received: [ {} ]", parameter, fmt::join(returnVector, ", "));
+    logger->debug("Parameter \'{}\' received: [ {} ]", hv::info(parameter).name, fmt::join(values, ", "));
 
-    return returnVector;
+    return {};
 }
 
 HVInterface::HVInterface():
     handle { -1 },
-    connected { false }
+    connected { false },
+    cacheTimeToLive { defaultTimeToLive() }
 {
     try
     {
@@ -300,14 +719,16 @@ void HVInterface::connectToPSU(msu_smdt::Port port)
     const char* password = "";
     int handle = -1;
 
-    auto result = (int) InitializeSystem(
-        system,
-        linkType,
-        (void*) connection.c_str(),
-        username,
-        password,
-        &handle
-    );
+    auto result = timed(instrumentation::Operation::Connect, [&] {
+        return InitializeSystem(
+            system,
+            linkType,
+            (void*) connection.c_str(),
+            username,
+            password,
+            &handle
+        );
+    });
 
     if (result)
     {
@@ -323,16 +744,47 @@ void HVInterface::connectToPSU(msu_smdt::Port port)
 
     this->handle = handle;
     this->connected = true;
+    this->port = port;
+
+    invalidateCache();
 
     if (logger)
         logger->debug("Successfully Connected");
+
+    // Older systems may not support the crate map. We can still talk to them
+    // as a single board on slot 0.
+    try
+    {
+        properties = get_crate_map(logger, handle);
+    }
+    catch (const std::exception& ex)
+    {
+        if (logger)
+            logger->warn("No crate map available, assuming a single board: {}", ex.what());
+
+        properties = PowerSupplyProperties();
+    }
+
+    channelMap.clear();
+
+    for (const auto& slot : properties.Slots)
+    {
+        for (unsigned short channel = 0; channel < slot.Channels; ++channel)
+            channelMap.push_back({ slot.Slot, channel });
+    }
+
+    if (logger)
+        logger->debug("Crate has {} channels on {} slots", channelMap.size(), properties.Slots.size());
 }
 
 void HVInterface::disconnectFromPSU()
 {
-    auto result = (int) DeinitializeSystem(handle);
+    auto result = timed(instrumentation::Operation::Disconnect, [&] {
+        return DeinitializeSystem(handle);
+    });
 
-    if (result)
+    // After the link is lost there is nothing left to close cleanly.
+    if (result && connected)
     {
         std::string msg = "DeinitializeSystem Error ";
         msg += std::to_string(result) + ": ";
@@ -346,11 +798,35 @@ void HVInterface::disconnectFromPSU()
 
     this->handle = -1;
     this->connected = false;
+    this->properties = PowerSupplyProperties();
+    this->channelMap.clear();
+
+    invalidateCache();
 
     if (logger)
         logger->debug("Successfully Disconnected");
 }
 
+bool HVInterface::reconnect()
+{
+    if (handle != -1)
+        timed(instrumentation::Operation::Disconnect, [&] { return DeinitializeSystem(handle); });
+
+    handle = -1;
+    connected = false;
+
+    try
+    {
+        connectToPSU(port);
+    }
+    catch (const std::exception& ex)
+    {
+        return false;
+    }
+
+    return true;
+}
+
 bool HVInterface::isConnectedToPSU()
 {
     return connected;
@@ -361,59 +837,203 @@ PowerSupplyProperties HVInterface::getProperties()
     return properties;
 }
 
-void HVInterface::setParametersFloat(std::string parameter, float value, CHVector channels)
+ChannelAddress HVInterface::address(int channel) const
 {
-    try
-    {
-        setParameters<float>(parameter, value, channels, this->logger, this->handle);
-    }
-    catch (const std::runtime_error& e)
+    auto address = locate(channel, channelMap);
+
+    if (!address)
+        throw std::runtime_error(address.error().message());
+
+    return *address;
+}
+
+int HVInterface::channelCount() const
+{
+    return static_cast<int>(channelMap.size());
+}
+
+void HVInterface::setCacheTimeToLive(hv::ParameterId parameter, std::chrono::milliseconds ttl)
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    cacheTimeToLive[hv::index(parameter)] = ttl;
+}
+
+void HVInterface::invalidateCache()
+{
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    floatCache.clear();
+    longCache.clear();
+}
+
+std::chrono::milliseconds HVInterface::timeToLive(hv::ParameterId parameter)
+{
+    return cacheTimeToLive[hv::index(parameter)];
+}
+
+void HVInterface::checkLimits(hv::ParameterId parameter, float value, float minimum, float maximum, const ChannelSet& channels)
+{
+    bool warned = false;
+
+    for (std::size_t i = 0; i < channels.size(); ++i)
     {
-        logger->error("{}", e.what());
-        throw;
+        // A channel that is not in the crate is reported by the write.
+        auto address = locate(channels[i], channelMap);
+
+        if (!address)
+            continue;
+
+        const ParameterLimits* limits = nullptr;
+
+        if (address->slot < properties.Slots.size())
+            limits = &properties.Slots[address->slot].Limits[hv::index(parameter)];
+
+        if (limits && limits->Known)
+        {
+            if (!inRange(value, limits->Minimum, limits->Maximum))
+                outOfRange(parameter, value, limits->Minimum, limits->Maximum);
+        }
+        else if (!warned && !inRange(value, minimum, maximum))
+        {
+            logger->warn(
+                "{} value {} is outside the N1471 range of {} to {}, and slot {} reports no range of its own; writing it anyway",
+                hv::info(parameter).name,
+                value,
+                minimum,
+                maximum,
+                address->slot
+            );
+
+            warned = true;
+        }
     }
-    
 }
 
-void HVInterface::setParametersLong(std::string parameter, unsigned long value, CHVector channels)
+void HVInterface::outOfRange(hv::ParameterId parameter, double value, double minimum, double maximum)
 {
-    try
+    auto msg = fmt::format("{} value {} out of range [{}, {}]", hv::info(parameter).name, value, minimum, maximum);
+    logger->error(msg);
+    throw std::runtime_error(msg);
+}
+
+template <>
+ParameterCache<float>& HVInterface::cacheFor<float>()
+{
+    return floatCache;
+}
+
+template <>
+ParameterCache<unsigned long>& HVInterface::cacheFor<unsigned long>()
+{
+    return longCache;
+}
+
+template <typename T>
+void HVInterface::write(hv::ParameterId parameter, T value, const ChannelSet& channels)
+{
+    if (!connected)
+        fail(HVError { .code = HVError::Code::NotConnected });
+
     {
-        setParameters<unsigned long>(parameter, value, channels, this->logger, this->handle);
+        // Whatever happens, the cached values for these channels are stale.
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        cacheFor<T>().invalidate(parameter, channels);
     }
-    catch (const std::runtime_error& e)
+
+    auto result = setParameters<T>(parameter, value, channels, this->channelMap, this->properties, this->logger, this->handle);
+
+    if (!result)
     {
-        logger->error("{}", e.what());
-        throw;
+        noteFailure(result.error());
+        fail(result.error());
     }
 }
 
-FloatVector HVInterface::getParametersFloat(std::string parameter, CHVector channels)
+template <typename T>
+std::expected<void, HVError> HVInterface::tryRead(
+    hv::ParameterId parameter, 
+    const ChannelSet& channels, 
+    std::span<T> values, 
+    bool useCache
+)
 {
-    try
+    if (values.size() != channels.size())
+        return std::unexpected(HVError { .code = HVError::Code::BufferSize, .size = channels.size(), .room = values.size() });
+
+    if (!connected)
+        return std::unexpected(HVError { .code = HVError::Code::NotConnected });
+
+    std::chrono::milliseconds ttl;
+
     {
-        return getParameters<float>(parameter, channels, this->logger, this->handle);
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        ttl = timeToLive(parameter);
     }
-    catch (const std::runtime_error& e)
+
+    if (!useCache || ttl == 0ms)
     {
-        logger->error("{}", e.what());
-        throw;
+        auto read = getParameters<T>(parameter, channels, values, channelMap, logger, handle);
+
+        if (!read)
+            noteFailure(read.error());
+
+        return read;
     }
-}
 
-ULongVector HVInterface::getParametersLong(std::string parameter, CHVector channels)
-{
-    try
+    auto& cache = cacheFor<T>();
+    std::array<std::size_t, ChannelSet::capacity> missing;
+    std::size_t count;
+
     {
-        return getParameters<unsigned long>(parameter, channels, this->logger, this->handle);
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        count = cache.lookup(parameter, channels, ttl, values, missing);
     }
-    catch (const std::runtime_error& e)
+
+    if (count == 0)
+        return {};
+
+    // Only the channels we do not know are read, still in one call per slot.
+    ChannelSet toRead;
+
+    for (std::size_t k = 0; k < count; ++k)
+        toRead.insert(channels[missing[k]]);
+
+    std::array<T, ChannelSet::capacity> fetched;
+    auto received = std::span<T>(fetched).first(count);
+
+    if (auto read = getParameters<T>(parameter, toRead, received, channelMap, logger, handle); !read)
+    {
+        noteFailure(read.error());
+        return read;
+    }
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+
+    for (std::size_t k = 0; k < count; ++k)
     {
-        logger->error("{}", e.what());
-        throw;
+        values[missing[k]] = received[k];
+        cache.store(parameter, toRead[k], received[k]);
     }
+
+    return {};
+}
+
+void HVInterface::fail(const HVError& error)
+{
+    raise(error, logger);
 }
 
+void HVInterface::noteFailure(const HVError& error)
+{
+    // Logged once per loss, however many calls fail after it.
+    if (error.linkLost && connected.exchange(false))
+        logger->warn("Lost the link to the power supply: {}", error.message());
+}
+
+template std::expected<void, HVError> HVInterface::tryRead<float>(hv::ParameterId, const ChannelSet&, std::span<float>, bool);
+template std::expected<void, HVError> HVInterface::tryRead<unsigned long>(hv::ParameterId, const ChannelSet&, std::span<unsigned long>, bool);
+template void HVInterface::write<float>(hv::ParameterId, float, const ChannelSet&);
+template void HVInterface::write<unsigned long>(hv::ParameterId, unsigned long, const ChannelSet&);
+
 bool HVInterface::checkAlarm()
 {
 #ifdef VIRTUALIZE_CONNECTION
@@ -425,13 +1045,15 @@ bool HVInterface::checkAlarm()
 
     unsigned long resultList[] = { 512 };
 
-    auto result = (int) CAENHV_GetBdParam(
-        handle,
-        numberOfSlots,
-        slotList,
-        parameter,
-        (void*) resultList
-    );
+    auto result = timed(instrumentation::Operation::BoardParameter, [&] {
+        return CAENHV_GetBdParam(
+            handle,
+            numberOfSlots,
+            slotList,
+            parameter,
+            (void*) resultList
+        );
+    });
 
     if (result)
     {
@@ -463,13 +1085,15 @@ bool HVInterface::checkInterlock()
 
     unsigned long resultList[] = { 512 };
 
-    auto result = (int) CAENHV_GetBdParam(
-        handle,
-        numberOfSlots,
-        slotList,
-        parameter,
-        (void*) resultList
-    );
+    auto result = timed(instrumentation::Operation::BoardParameter, [&] {
+        return CAENHV_GetBdParam(
+            handle,
+            numberOfSlots,
+            slotList,
+            parameter,
+            (void*) resultList
+        );
+    });
 
     if (result)
     {
@@ -500,13 +1124,15 @@ void HVInterface::clearAlarm()
     const char* parameter = "ClrAlarm";
     unsigned long value = 0;
 
-    auto result = (int) CAENHV_SetBdParam(
-        handle,
-        numberOfSlots,
-        slotList,
-        parameter,
-        (void*) &value
-    );
+    auto result = timed(instrumentation::Operation::BoardParameter, [&] {
+        return CAENHV_SetBdParam(
+            handle,
+            numberOfSlots,
+            slotList,
+            parameter,
+            (void*) &value
+        );
+    });
 
     if (result)
     {
@@ -535,13 +1161,15 @@ void HVInterface::setInterlock(bool state)
     if (state)
         value = 1;
 
-    auto result = (int) CAENHV_SetBdParam(
-        handle,
-        numberOfSlots,
-        slotList,
-        parameter,
-        (void*) &value
-    );
+    auto result = timed(instrumentation::Operation::BoardParameter, [&] {
+        return CAENHV_SetBdParam(
+            handle,
+            numberOfSlots,
+            slotList,
+            parameter,
+            (void*) &value
+        );
+    });
 
     if (result)
     {
@@ -1,12 +1,55 @@
 #pragma once
 
+#include <map>
+#include <span>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+#include <expected>
 #include <string>
+#include <vector>
 #include <memory>
 #include <stdexcept>
+#include <type_traits>
 
 #include <spdlog/spdlog.h>
 
 #include "Port.hpp"
+#include "HVError.hpp"
+#include "ChannelSet.hpp"
+#include "Parameters.hpp"
+#include "ParameterCache.hpp"
+
+// The range a board reports for one of its float parameters.
+struct ParameterLimits
+{
+    float Minimum                   { 0.0f };
+    float Maximum                   { 0.0f };
+    bool Known                      { false };
+};
+
+// What the crate map reports for one slot. Empty slots have no channels.
+// Limits are read from the board's first channel when it is connected, and
+// indexed by hv::index(id); those the board did not report are not Known.
+struct SlotProperties
+{
+    unsigned short Slot             { 0 };
+    unsigned short Channels         { 0 };
+    std::string Model               { "" };
+    std::string Description         { "" };
+    std::string Serial              { "" };
+    std::string Firmware            { "" };
+
+    std::array<ParameterLimits, hv::parameterCount> Limits;
+};
+
+// Where a channel lives in the crate.
+struct ChannelAddress
+{
+    unsigned short slot;
+    unsigned short channel;
+};
 
 struct PowerSupplyProperties
 {
@@ -17,6 +60,8 @@ struct PowerSupplyProperties
     std::string ChannelsAvailable   { "N/A" };
     std::string Serial              { "N/A" };
     std::string Firmware            { "N/A" };
+
+    std::vector<SlotProperties> Slots;
 };
 
 class HVInterface 
@@ -35,13 +80,73 @@ public:
     void disconnectFromPSU();
     bool isConnectedToPSU();
 
+    // A call that fails because the link is gone (as opposed to a bad
+    // request) marks the interface disconnected; further calls fail with
+    // HVError::Code::NotConnected without touching the library. reconnect()
+    // drops the dead handle and connects to the last port again. It returns
+    // false if that did not work, and can be called again.
+    bool reconnect();
+
     PowerSupplyProperties getProperties();
 
-    void setParametersFloat(std::string parameter, float value, std::vector<int> channels);
-    void setParametersLong(std::string parameter, unsigned long value, std::vector<int> channels);
-    
-    std::vector<float> getParametersFloat(std::string parameter, std::vector<int> channels);
-    std::vector<unsigned long> getParametersLong(std::string parameter, std::vector<int> channels);
+    // Channels are numbered across the whole crate: the channels of the first
+    // populated slot come first, then those of the next, and so on. Without a
+    // crate map every channel is taken to be on slot 0.
+    ChannelAddress address(int channel) const;
+    int channelCount() const;
+
+    // Slow-changing parameters are answered from a cache while they are
+    // younger than their time-to-live. Writing a parameter through this
+    // interface drops the cached values of the channels written. Pass
+    // useCache = false to always ask the supply.
+    //
+    // The values come back in the order of `channels`. The overloads taking
+    // a span fill it in place and do not allocate; `values` must be as long
+    // as `channels`.
+    //
+    // tryGet reports a failed read by returning the error rather than by
+    // throwing or logging it, so a polling loop on a flaky link decides for
+    // itself what a failure is worth. get throws, and logs the error once.
+    template <const auto& P>
+    std::expected<void, HVError> tryGet(const ChannelSet& channels, std::span<hv::ValueType<P>> values, bool useCache = true)
+    {
+        return tryRead<hv::ValueType<P>>(P.id, channels, values, useCache);
+    }
+
+    template <const auto& P>
+    void get(const ChannelSet& channels, std::span<hv::ValueType<P>> values, bool useCache = true)
+    {
+        if (auto result = tryGet<P>(channels, values, useCache); !result)
+            fail(result.error());
+    }
+
+    template <const auto& P>
+    std::vector<hv::ValueType<P>> get(const ChannelSet& channels, bool useCache = true)
+    {
+        std::vector<hv::ValueType<P>> values(channels.size());
+        get<P>(channels, std::span(values), useCache);
+        return values;
+    }
+
+    // A float value outside the range a channel's board reports throws. One
+    // outside the nominal range of the descriptor, on a board that reported
+    // none, is logged and written anyway.
+    template <const auto& P>
+    void set(hv::ValueType<P> value, const ChannelSet& channels)
+    {
+        static_assert(P.writable, "This parameter is read-only");
+
+        if constexpr (std::is_same_v<hv::ValueType<P>, float>)
+            checkLimits(P.id, value, P.minimum, P.maximum, channels);
+        else if (!inRange(value, P.minimum, P.maximum))
+            outOfRange(P.id, static_cast<double>(value), P.minimum, P.maximum);
+
+        write(P.id, value, channels);
+    }
+
+    // A time-to-live of zero turns caching off for the parameter.
+    void setCacheTimeToLive(hv::ParameterId parameter, std::chrono::milliseconds ttl);
+    void invalidateCache();
 
     bool checkAlarm();
     bool checkInterlock();
@@ -49,9 +154,50 @@ public:
     void clearAlarm();
     void setInterlock(bool state);
 
+private:
+    template <typename T>
+    std::expected<void, HVError> tryRead(
+        hv::ParameterId parameter, 
+        const ChannelSet& channels, 
+        std::span<T> values, 
+        bool useCache
+    );
+
+    template <typename T>
+    void write(hv::ParameterId parameter, T value, const ChannelSet& channels);
+
+    template <typename T>
+    ParameterCache<T>& cacheFor();
+
+    static bool inRange(float value, float minimum, float maximum)
+    {
+        constexpr float epsilon = 0.001f;
+        return value >= minimum - epsilon && value <= maximum + epsilon;
+    }
+
+    static bool inRange(unsigned long value, unsigned long minimum, unsigned long maximum)
+    {
+        return value >= minimum && value <= maximum;
+    }
+
+    void checkLimits(hv::ParameterId parameter, float value, float minimum, float maximum, const ChannelSet& channels);
+
+    [[noreturn]] void outOfRange(hv::ParameterId parameter, double value, double minimum, double maximum);
+    [[noreturn]] void fail(const HVError& error);
+    void noteFailure(const HVError& error);
+
+    std::chrono::milliseconds timeToLive(hv::ParameterId parameter);
+
 private:
     int handle;
-    bool connected;
+    std::atomic<bool> connected;
+    msu_smdt::Port port;
     PowerSupplyProperties properties;
+    std::vector<ChannelAddress> channelMap;
+
+    std::mutex cacheMutex;
+    ParameterCache<float> floatCache;
+    ParameterCache<unsigned long> longCache;
+    std::array<std::chrono::milliseconds, hv::parameterCount> cacheTimeToLive;
     std::shared_ptr<spdlog::logger> logger;
 };
\ No newline at end of file
@@ -1,19 +1,30 @@
+#include <cmath>
+#include <thread>
+#include <algorithm>
 #include <exception>
 
 #include <spdlog/sinks/stdout_color_sinks.h>
 
 #include "PSUController.hpp"
 
-using CHVector = std::vector<int>;
+using namespace std::chrono_literals;
 
-constexpr float VSetMax = 5500.0f;
-constexpr float ISetMax = 21.000f;
-constexpr float MaxVMax = 5600.0f;
-constexpr float RUpMax  = 500.00f;
-constexpr float RDwnMax = 500.00f;
-constexpr float TripMax = 1000.0f;
+// The channels whose shadowed value is unknown or differs from `value`.
+template <typename T>
+static ChannelSet dirtyChannels(hv::ParameterId parameter, const std::map<int, T>& shadow, const ChannelSet& channels, T value)
+{
+    ChannelSet dirty;
+
+    for (auto channel : channels)
+    {
+        auto it = shadow.find(channel);
 
-constexpr float epsilon = 0.001f;
+        if (it == shadow.end() || !hv::matches(parameter, it->second, value))
+            dirty.insert(channel);
+    }
+
+    return dirty;
+}
 
 PSUController::PSUController():
     forceClosed { false }
@@ -35,6 +46,8 @@ void PSUController::connectToPSU(msu_smdt::Port port)
 {
     try
     {
+        invalidateConfiguration();
+        powerState.clear();
         interface.connectToPSU(port);
         interface.clearAlarm();
         interface.setInterlock(true);
@@ -48,6 +61,9 @@ void PSUController::connectToPSU(msu_smdt::Port port)
 
 void PSUController::disconnectFromPSU()
 {
+    invalidateConfiguration();
+    powerState.clear();
+
     try
     {
         interface.disconnectFromPSU();
@@ -59,79 +75,173 @@ void PSUController::disconnectFromPSU()
     }
 }
 
-void PSUController::powerOnChannels(CHVector channels)
+bool PSUController::isConnected()
+{
+    return interface.isConnectedToPSU();
+}
+
+bool PSUController::reconnect(const std::atomic<bool>& cancel, ReconnectPolicy policy)
+{
+    // What the channels should look like once we are back, since the shadow
+    // is rebuilt as it is written again.
+    auto floats = shadowFloat;
+    auto longs = shadowLong;
+    auto power = powerState;
+
+    auto delay = policy.initialDelay;
+
+    for (int attempt = 1; attempt <= policy.attempts; ++attempt)
+    {
+        // Slept in short steps, so that stopping a test is not held up.
+        for (auto slept = 0ms; slept < delay; slept += 100ms)
+        {
+            if (cancel)
+                return false;
+
+            std::this_thread::sleep_for(std::min(100ms, delay - slept));
+        }
+
+        logger->warn("Reconnecting to the power supply, attempt {} of {}", attempt, policy.attempts);
+
+        if (interface.reconnect())
+        {
+            try
+            {
+                interface.clearAlarm();
+                interface.setInterlock(true);
+
+                invalidateConfiguration();
+                restore<hv::VSet>(floats[hv::VSet.id]);
+                restore<hv::ISet>(floats[hv::ISet.id]);
+                restore<hv::MaxV>(floats[hv::MaxV.id]);
+                restore<hv::RUp>(floats[hv::RUp.id]);
+                restore<hv::RDwn>(floats[hv::RDwn.id]);
+                restore<hv::Trip>(floats[hv::Trip.id]);
+                restore<hv::PDwn>(longs[hv::PDwn.id]);
+
+                // Power last, once the channels are configured again.
+                ChannelSet on;
+                ChannelSet off;
+
+                for (auto [channel, state] : power)
+                    (state ? on : off).insert(channel);
+
+                if (!off.empty())
+                    powerOffChannels(off);
+                if (!on.empty())
+                    powerOnChannels(on);
+
+                logger->info("Reconnected to the power supply and restored the channels");
+                return true;
+            }
+            catch (const std::exception& exception)
+            {
+                logger->error("Cannot restore the channels after reconnecting: {}", exception.what());
+            }
+        }
+
+        delay = std::min(delay * 2, policy.maximumDelay);
+    }
+
+    logger->error("Giving up on the power supply after {} attempts", policy.attempts);
+    return false;
+}
+
+PowerSupplyProperties PSUController::getProperties()
+{
+    return interface.getProperties();
+}
+
+void PSUController::powerOnChannels(const ChannelSet& channels)
 {
     try
     {
-        interface.setParametersLong("Pw", 1, channels);
+        interface.set<hv::Pw>(1, channels);
     }
     catch (const std::exception& exception)
     {
         logger->error("Caught exception in PSUController: {}", exception.what());
         throw;
     }
+
+    for (auto channel : channels)
+        powerState[channel] = 1;
 }
 
-void PSUController::powerOffChannels(CHVector channels)
+void PSUController::powerOffChannels(const ChannelSet& channels)
 {
     try
     {
-        interface.setParametersLong("Pw", 0, channels);
+        interface.set<hv::Pw>(0, channels);
     }
     catch (const std::exception& exception)
     {
         logger->error("Caught exception in PSUController: {}", exception.what());
         throw;
     }
+
+    for (auto channel : channels)
+        powerState[channel] = 0;
 }
 
-std::vector<float> PSUController::getTestVoltages(CHVector channels)
+std::vector<float> PSUController::getTestVoltages(const ChannelSet& channels)
 {
-    std::vector<float> returnVector(channels.size(), -1.00f);
-
     try
     {
-        returnVector = interface.getParametersFloat("VSet", channels);
+        return interface.get<hv::VSet>(channels);
     }
     catch (const std::exception& exception)
     {
         logger->error("Caught exception in PSUController: {}", exception.what());
         throw;
     }
+}
 
-    return returnVector;
+void PSUController::setTestVoltages(const ChannelSet& channels, float voltage)
+{
+    write<hv::VSet>(voltage, channels);
 }
 
-void PSUController::setTestVoltages(CHVector channels, float voltage)
+void PSUController::setTestCurrents(const ChannelSet& channels, float current)
 {
-    if (voltage < 0.00f - epsilon || voltage > VSetMax + epsilon)
-    {
-        logger->error("Voltage value out of range");
-        throw std::runtime_error("Voltage value out of range");
-    }
+    write<hv::ISet>(current, channels);
+}
 
-    try
-    {
-        interface.setParametersFloat("VSet", voltage, channels);
-    }
-    catch (const std::exception& exception)
-    {
-        logger->error("Caught exception in PSUController: {}", exception.what());
-        throw;
-    }
+void PSUController::setMaxVoltages(const ChannelSet& channels, float voltage)
+{
+    write<hv::MaxV>(voltage, channels);
 }
 
-void PSUController::setTestCurrents(CHVector channels, float current)
+void PSUController::setOverCurrentLimits(const ChannelSet& channels, float time)
 {
-    if (current < 0.00f - epsilon || current > ISetMax + epsilon)
-    {
-        logger->error("Current out of range");
-        throw std::runtime_error("Current out of range");
-    }
+    write<hv::Trip>(time, channels);
+}
 
+void PSUController::setRampUpRate(const ChannelSet& channels, float rate)
+{
+    write<hv::RUp>(rate, channels);
+}
+
+void PSUController::setRampDownRate(const ChannelSet& channels, float rate)
+{
+    write<hv::RDwn>(rate, channels);
+}
+
+void PSUController::killChannelsAfterTest(const ChannelSet& channels, bool kill)
+{
+    unsigned long value = 1;
+
+    if (kill)
+        value = 0;
+
+    write<hv::PDwn>(value, channels);
+}
+
+std::vector<float> PSUController::readVoltages(const ChannelSet& channels)
+{
     try
     {
-        interface.setParametersFloat("ISet", current, channels);
+        return interface.get<hv::VMon>(channels);
     }
     catch (const std::exception& exception)
     {
@@ -140,17 +250,11 @@ void PSUController::setTestCurrents(CHVector channels, float current)
     }
 }
 
-void PSUController::setMaxVoltages(CHVector channels, float voltage)
+std::vector<float> PSUController::readCurrents(const ChannelSet& channels)
 {
-    if (voltage < 0.00f - epsilon || voltage > MaxVMax + epsilon)
-    {
-        logger->error("Voltage value out of range");
-        throw std::runtime_error("Voltage value out of range");
-    }
-
     try
     {
-        interface.setParametersFloat("MaxV", voltage, channels);
+        return interface.get<hv::IMonH>(channels);
     }
     catch (const std::exception& exception)
     {
@@ -159,17 +263,11 @@ void PSUController::setMaxVoltages(CHVector channels, float voltage)
     }
 }
 
-void PSUController::setOverCurrentLimits(CHVector channels, float time)
+std::vector<unsigned long> PSUController::readPolarities(const ChannelSet& channels)
 {
-    if (time < 0.00f - epsilon || time > TripMax + epsilon)
-    {
-        logger->error("Over Current Time value out of range");
-        throw std::runtime_error("Over Current Time value out of range");
-    }
-
     try
     {
-        interface.setParametersFloat("Trip", time, channels);
+        return interface.get<hv::Polarity>(channels);
     }
     catch (const std::exception& exception)
     {
@@ -178,17 +276,11 @@ void PSUController::setOverCurrentLimits(CHVector channels, float time)
     }
 }
 
-void PSUController::setRampUpRate(CHVector channels, float rate)
+std::vector<unsigned long> PSUController::readStatuses(const ChannelSet& channels)
 {
-    if (rate < 1.00f - epsilon || rate > RUpMax + epsilon)
-    {
-        logger->error("Ramp Up Rate out of range");
-        throw std::runtime_error("Ramp Up Rate out of range");
-    }
-
     try
     {
-        interface.setParametersFloat("RUp", rate, channels);
+        return interface.get<hv::ChStatus>(channels);
     }
     catch (const std::exception& exception)
     {
@@ -197,17 +289,11 @@ void PSUController::setRampUpRate(CHVector channels, float rate)
     }
 }
 
-void PSUController::setRampDownRate(CHVector channels, float rate)
+void PSUController::readVoltages(const ChannelSet& channels, std::span<float> voltages)
 {
-    if (rate < 1.00f - epsilon || rate > RDwnMax + epsilon)
-    {
-        logger->error("Ramp Down Rate out of range");
-        throw std::runtime_error("Ramp Down Rate out of range");
-    }
-
     try
     {
-        interface.setParametersFloat("RDwn", rate, channels);
+        interface.get<hv::VMon>(channels, voltages);
     }
     catch (const std::exception& exception)
     {
@@ -216,16 +302,11 @@ void PSUController::setRampDownRate(CHVector channels, float rate)
     }
 }
 
-void PSUController::killChannelsAfterTest(CHVector channels, bool kill)
+void PSUController::readCurrents(const ChannelSet& channels, std::span<float> currents)
 {
     try
     {
-        unsigned long value = 1;
-
-        if (kill)
-            value = 0;
-
-        interface.setParametersLong("PDwn", value, channels);
+        interface.get<hv::IMonH>(channels, currents);
     }
     catch (const std::exception& exception)
     {
@@ -234,70 +315,146 @@ void PSUController::killChannelsAfterTest(CHVector channels, bool kill)
     }
 }
 
-std::vector<float> PSUController::readVoltages(CHVector channels)
+void PSUController::readStatuses(const ChannelSet& channels, std::span<unsigned long> statuses)
 {
-    std::vector<float> returnVector(channels.size(), -1.00f);
-
     try
     {
-        returnVector = interface.getParametersFloat("VMon", channels);
+        interface.get<hv::ChStatus>(channels, statuses);
     }
     catch (const std::exception& exception)
     {
         logger->error("Caught exception in PSUController: {}", exception.what());
         throw;
     }
+}
+
+std::expected<void, HVError> PSUController::tryReadVoltages(const ChannelSet& channels, std::span<float> voltages)
+{
+    return interface.tryGet<hv::VMon>(channels, voltages);
+}
+
+std::expected<void, HVError> PSUController::tryReadCurrents(const ChannelSet& channels, std::span<float> currents)
+{
+    return interface.tryGet<hv::IMonH>(channels, currents);
+}
 
-    return returnVector;
+std::expected<void, HVError> PSUController::tryReadStatuses(const ChannelSet& channels, std::span<unsigned long> statuses)
+{
+    return interface.tryGet<hv::ChStatus>(channels, statuses);
 }
 
-std::vector<float> PSUController::readCurrents(CHVector channels)
+std::expected<void, HVError> PSUController::tryGetTestVoltages(const ChannelSet& channels, std::span<float> voltages)
 {
-    std::vector<float> returnVector(channels.size(), -1.00f);
+    return interface.tryGet<hv::VSet>(channels, voltages);
+}
 
+bool PSUController::verifyConfiguration(const ChannelSet& channels)
+{
     try
     {
-        returnVector = interface.getParametersFloat("IMonH", channels);
+        // Not short-circuited: every parameter is checked.
+        return verify<hv::VSet>(channels)
+             & verify<hv::ISet>(channels)
+             & verify<hv::MaxV>(channels)
+             & verify<hv::RUp>(channels)
+             & verify<hv::RDwn>(channels)
+             & verify<hv::Trip>(channels)
+             & verify<hv::PDwn>(channels);
     }
     catch (const std::exception& exception)
     {
         logger->error("Caught exception in PSUController: {}", exception.what());
+        invalidateConfiguration();
         throw;
     }
+}
+
+void PSUController::invalidateConfiguration()
+{
+    shadowFloat.clear();
+    shadowLong.clear();
+}
 
-    return returnVector;
+template <>
+std::map<int, float>& PSUController::shadowFor<float>(hv::ParameterId parameter)
+{
+    return shadowFloat[parameter];
 }
 
-std::vector<unsigned long> PSUController::readPolarities(CHVector channels)
+template <>
+std::map<int, unsigned long>& PSUController::shadowFor<unsigned long>(hv::ParameterId parameter)
 {
-    std::vector<unsigned long> returnVector(channels.size(), false);
+    return shadowLong[parameter];
+}
 
-    try
-    {
-        returnVector = interface.getParametersLong("Polarity", channels);
-    }
-    catch (const std::exception& exception)
+template <const auto& P>
+void PSUController::restore(const std::map<int, hv::ValueType<P>>& values)
+{
+    // Channels that shared a value are written together again.
+    std::map<hv::ValueType<P>, ChannelSet> channelsByValue;
+
+    for (auto [channel, value] : values)
+        channelsByValue[value].insert(channel);
+
+    for (const auto& [value, channels] : channelsByValue)
+        write<P>(value, channels);
+}
+
+template <const auto& P>
+bool PSUController::verify(const ChannelSet& channels)
+{
+    using T = hv::ValueType<P>;
+    auto& shadow = shadowFor<T>(P.id);
+
+    // Only what we think we know needs checking.
+    if (shadow.empty())
+        return true;
+
+    bool consistent = true;
+    auto values = interface.get<P>(channels, false);
+
+    for (std::size_t i = 0; i < channels.size(); ++i)
     {
-        logger->error("Caught exception in PSUController: {}", exception.what());
-        throw;
+        auto it = shadow.find(channels[i]);
+
+        if (it == shadow.end() || hv::matches(P.id, it->second, values[i]))
+            continue;
+
+        logger->warn("CH{}: {} was changed outside of the program", channels[i], P.name);
+        shadow.erase(it);
+        consistent = false;
     }
 
-    return returnVector;
+    return consistent;
 }
 
-std::vector<unsigned long> PSUController::readStatuses(CHVector channels)
+template <const auto& P>
+void PSUController::write(hv::ValueType<P> value, const ChannelSet& channels)
 {
-    std::vector<unsigned long> returnVector(channels.size(), 0);
+    using T = hv::ValueType<P>;
+    auto& shadow = shadowFor<T>(P.id);
+    auto dirty = dirtyChannels(P.id, shadow, channels, value);
+
+    if (dirty.empty())
+    {
+        logger->debug("{} = {} already in effect", P.name, value);
+        return;
+    }
 
     try
     {
-        returnVector = interface.getParametersLong("ChStatus", channels);
+        interface.set<P>(value, dirty);
     }
     catch (const std::exception& exception)
     {
+        // We no longer know what the supply holds for these channels.
+        for (auto channel : dirty)
+            shadow.erase(channel);
+
         logger->error("Caught exception in PSUController: {}", exception.what());
         throw;
     }
 
-    return returnVector;
+    for (auto channel : dirty)
+        shadow[channel] = value;
 }
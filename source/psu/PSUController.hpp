@@ -1,13 +1,38 @@
 #pragma once
 
+#include <map>
+#include <atomic>
+#include <chrono>
+#include <string>
 #include <vector>
+#include <span>
 #include <memory>
+#include <expected>
 
 #include <spdlog/spdlog.h>
 
+#include "ChannelSet.hpp"
 #include "HVInterface.hpp"
 #include "Port.hpp"
 
+// How hard to try to get a lost power supply back: the delay before the
+// first attempt doubles after every failure, up to maximumDelay.
+struct ReconnectPolicy
+{
+    int attempts                            { 8 };
+    std::chrono::milliseconds initialDelay  { 500 };
+    std::chrono::milliseconds maximumDelay  { 30000 };
+};
+
+// Keeps a shadow copy of the configuration parameters last written to each
+// channel (VSet, ISet, MaxV, RUp, RDwn, Trip and PDwn), so applying the same
+// settings again only writes the values that actually changed. The shadow is
+// dropped on connect and disconnect. verifyConfiguration() reads the values
+// back and forgets any that were changed behind our back, e.g. from the front
+// panel.
+//
+// The shadow, with the power state last asked for, is also what is written
+// back by reconnect() after the link to the supply drops.
 class PSUController
 {
 public:
@@ -23,30 +48,73 @@ public:
     void connectToPSU(msu_smdt::Port port);
     void disconnectFromPSU();
 
-    void powerOnChannels(std::vector<int> channels);
-    void powerOffChannels(std::vector<int> channels);
+    // False once a call has found the link to the supply gone.
+    bool isConnected();
+
+    // Reconnects following `policy` and restores the configuration and power
+    // state of every channel. Gives up early once `cancel` is set. Returns
+    // whether the supply is back.
+    bool reconnect(const std::atomic<bool>& cancel, ReconnectPolicy policy = {});
+
+    PowerSupplyProperties getProperties();
+
+    void powerOnChannels(const ChannelSet& channels);
+    void powerOffChannels(const ChannelSet& channels);
+
+    std::vector<float> getTestVoltages(const ChannelSet& channels);
+
+    void setTestVoltages(const ChannelSet& channels, float voltage);
+    void setTestCurrents(const ChannelSet& channels, float current);
 
-    std::vector<float> getTestVoltages(std::vector<int> channels);
+    void setMaxVoltages(const ChannelSet& channels, float voltage);
+    void setOverCurrentLimits(const ChannelSet& channels, float time);
 
-    void setTestVoltages(std::vector<int> channels, float voltage);
-    void setTestCurrents(std::vector<int> channels, float current);
+    void setRampUpRate(const ChannelSet& channels, float rate);
+    void setRampDownRate(const ChannelSet& channels, float rate);
 
-    void setMaxVoltages(std::vector<int> channels, float voltage);
-    void setOverCurrentLimits(std::vector<int> channels, float time);
+    void killChannelsAfterTest(const ChannelSet& channels, bool kill);
 
-    void setRampUpRate(std::vector<int> channels, float rate);
-    void setRampDownRate(std::vector<int> channels, float rate);
+    std::vector<float> readVoltages(const ChannelSet& channels);
+    std::vector<float> readCurrents(const ChannelSet& channels);
+    std::vector<unsigned long> readPolarities(const ChannelSet& channels);
+
+    std::vector<unsigned long> readStatuses(const ChannelSet& channels);
+
+    // The same reads into buffers the caller owns, one value per channel, so
+    // a polling loop does not allocate.
+    void readVoltages(const ChannelSet& channels, std::span<float> voltages);
+    void readCurrents(const ChannelSet& channels, std::span<float> currents);
+    void readStatuses(const ChannelSet& channels, std::span<unsigned long> statuses);
+
+    // As above, but a failed read is returned rather than thrown or logged,
+    // for the acquisition loop to report as it sees fit.
+    std::expected<void, HVError> tryReadVoltages(const ChannelSet& channels, std::span<float> voltages);
+    std::expected<void, HVError> tryReadCurrents(const ChannelSet& channels, std::span<float> currents);
+    std::expected<void, HVError> tryReadStatuses(const ChannelSet& channels, std::span<unsigned long> statuses);
+    std::expected<void, HVError> tryGetTestVoltages(const ChannelSet& channels, std::span<float> voltages);
+
+    // Compares the shadow with the supply. Returns false if anything differed.
+    bool verifyConfiguration(const ChannelSet& channels);
+    void invalidateConfiguration();
+
+private:
+    template <const auto& P>
+    void write(hv::ValueType<P> value, const ChannelSet& channels);
 
-    void killChannelsAfterTest(std::vector<int> channels, bool kill);
+    template <const auto& P>
+    void restore(const std::map<int, hv::ValueType<P>>& values);
 
-    std::vector<float> readVoltages(std::vector<int> channels);
-    std::vector<float> readCurrents(std::vector<int> channels);
-    std::vector<unsigned long> readPolarities(std::vector<int> channels);
+    template <const auto& P>
+    bool verify(const ChannelSet& channels);
 
-    std::vector<unsigned long> readStatuses(std::vector<int> channels);
+    template <typename T>
+    std::map<int, T>& shadowFor(hv::ParameterId parameter);
 
 private:
     bool forceClosed;
+    std::map<hv::ParameterId, std::map<int, float>> shadowFloat;
+    std::map<hv::ParameterId, std::map<int, unsigned long>> shadowLong;
+    std::map<int, unsigned long> powerState;
     HVInterface interface;
     std::shared_ptr<spdlog::logger> logger;
 };
\ No newline at end of file
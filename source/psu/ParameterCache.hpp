@@ -0,0 +1,92 @@
+// ParameterCache.hpp
+
+#pragma once
+
+#include <map>
+#include <span>
+#include <chrono>
+#include <cstddef>
+
+#include "ChannelSet.hpp"
+#include "Parameters.hpp"
+
+// Values read from the supply, per parameter and channel, with the time they
+// were read. Whether a value is still good is up to the caller, who passes
+// the time-to-live of the parameter along with each lookup.
+template <typename T>
+class ParameterCache
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Fills in the values that are younger than `ttl`, puts the positions in
+    // `channels` of those that have to be read into `missing`, and returns
+    // how many there are. Nothing is allocated.
+    std::size_t lookup(
+        hv::ParameterId parameter, 
+        const ChannelSet& channels, 
+        std::chrono::milliseconds ttl, 
+        std::span<T> values,
+        std::span<std::size_t> missing
+    ) const
+    {
+        std::size_t count = 0;
+        auto now = Clock::now();
+        auto found = entries.find(parameter);
+
+        for (std::size_t i = 0; i < channels.size(); ++i)
+        {
+            if (found != entries.end())
+            {
+                auto entry = found->second.find(channels[i]);
+
+                // Compared in milliseconds, so that a ttl of max() does not
+                // overflow when converted to the clock's resolution.
+                if (entry != found->second.end() && age(now, entry->second) < ttl)
+                {
+                    values[i] = entry->second.value;
+                    continue;
+                }
+            }
+
+            missing[count++] = i;
+        }
+
+        return count;
+    }
+
+    void store(hv::ParameterId parameter, int channel, T value)
+    {
+        entries[parameter][channel] = { value, Clock::now() };
+    }
+
+    void invalidate(hv::ParameterId parameter, const ChannelSet& channels)
+    {
+        auto found = entries.find(parameter);
+
+        if (found == entries.end())
+            return;
+
+        for (auto channel : channels)
+            found->second.erase(channel);
+    }
+
+    void clear()
+    {
+        entries.clear();
+    }
+
+private:
+    struct Entry
+    {
+        T value;
+        Clock::time_point fetched;
+    };
+
+    static std::chrono::milliseconds age(Clock::time_point now, const Entry& entry)
+    {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(now - entry.fetched);
+    }
+
+    std::map<hv::ParameterId, std::map<int, Entry>> entries;
+};
@@ -0,0 +1,168 @@
+// Parameters.hpp
+
+#pragma once
+
+#include <cmath>
+#include <array>
+#include <cstddef>
+#include <algorithm>
+#include <optional>
+#include <string_view>
+#include <type_traits>
+
+// Every channel parameter we use, described once at compile time: its name on
+// the wire, its value type, its unit and its nominal range.
+//
+//     auto currents = interface.get<hv::IMonH>(channels);
+//     interface.set<hv::VSet>(3015.0f, channels);
+//
+// The value type of a call follows from the descriptor, writes to read-only
+// parameters do not compile, and nothing builds a string per call. The ids are
+// what backends that support them (FakeHV) are given instead of the name.
+//
+// The nominal ranges of the float parameters are those of the N1471 (4 x
+// 5.5 kV / 20 uA), the board the stations were built around. Other boards of
+// the N1470 family go well beyond them, so a write is checked against the
+// range the board itself reports (see SlotProperties::Limits), and these are
+// only a fallback to warn against when it reports none. The unsigned ranges
+// are switches and status bits, the same on every board, and always hold.
+namespace hv
+{
+
+enum class ParameterId : unsigned short
+{
+    VSet,
+    VMon,
+    ISet,
+    ImonRange,
+    IMonL,
+    IMonH,
+    MaxV,
+    RUp,
+    RDwn,
+    Trip,
+    PDwn,
+    Polarity,
+    ChStatus,
+    Pw
+};
+
+inline constexpr std::size_t parameterCount = 14;
+
+enum class ParameterType
+{
+    Float,
+    Unsigned
+};
+
+template <typename T>
+struct Parameter
+{
+    using value_type = T;
+
+    ParameterId id;
+    const char* name;
+    const char* unit;
+    T minimum;
+    T maximum;
+    bool writable;
+};
+
+inline constexpr Parameter<float>           VSet        { ParameterId::VSet,      "VSet",      "V",   0.0f, 5500.0f, true  };
+inline constexpr Parameter<float>           VMon        { ParameterId::VMon,      "VMon",      "V",   0.0f, 5600.0f, false };
+inline constexpr Parameter<float>           ISet        { ParameterId::ISet,      "ISet",      "uA",  0.0f, 21.000f, true  };
+inline constexpr Parameter<unsigned long>   ImonRange   { ParameterId::ImonRange, "ImonRange", "",    0,    1,       true  };
+inline constexpr Parameter<float>           IMonL       { ParameterId::IMonL,     "IMonL",     "uA",  0.0f, 21.000f, false };
+inline constexpr Parameter<float>           IMonH       { ParameterId::IMonH,     "IMonH",     "uA",  0.0f, 21.000f, false };
+inline constexpr Parameter<float>           MaxV        { ParameterId::MaxV,      "MaxV",      "V",   0.0f, 5600.0f, true  };
+inline constexpr Parameter<float>           RUp         { ParameterId::RUp,       "RUp",       "V/s", 1.0f, 500.00f, true  };
+inline constexpr Parameter<float>           RDwn        { ParameterId::RDwn,      "RDwn",      "V/s", 1.0f, 500.00f, true  };
+inline constexpr Parameter<float>           Trip        { ParameterId::Trip,      "Trip",      "s",   0.0f, 1000.0f, true  };
+inline constexpr Parameter<unsigned long>   PDwn        { ParameterId::PDwn,      "PDwn",      "",    0,    1,       true  };
+inline constexpr Parameter<unsigned long>   Polarity    { ParameterId::Polarity,  "Polarity",  "",    0,    1,       false };
+inline constexpr Parameter<unsigned long>   ChStatus    { ParameterId::ChStatus,  "ChStatus",  "",    0,    0xFFFF,  false };
+inline constexpr Parameter<unsigned long>   Pw          { ParameterId::Pw,        "Pw",        "",    0,    1,       true  };
+
+// The value type of a descriptor, e.g. ValueType<VSet> is float.
+template <const auto& P>
+using ValueType = typename std::remove_cvref_t<decltype(P)>::value_type;
+
+// The same information, indexed by id, for code that only has an id.
+//
+// `tolerance` is how far a float read back from the board may be from the
+// value written and still be the same value: the board stores and reports
+// values at its own resolution.
+struct ParameterInfo
+{
+    ParameterId id;
+    const char* name;
+    ParameterType type;
+    float tolerance;
+};
+
+inline constexpr std::array<ParameterInfo, parameterCount> registry {{
+    { VSet.id,      VSet.name,      ParameterType::Float,    0.1f  },
+    { VMon.id,      VMon.name,      ParameterType::Float,    0.1f  },
+    { ISet.id,      ISet.name,      ParameterType::Float,    0.01f },
+    { ImonRange.id, ImonRange.name, ParameterType::Unsigned, 0.0f  },
+    { IMonL.id,     IMonL.name,     ParameterType::Float,    0.01f },
+    { IMonH.id,     IMonH.name,     ParameterType::Float,    0.01f },
+    { MaxV.id,      MaxV.name,      ParameterType::Float,    0.1f  },
+    { RUp.id,       RUp.name,       ParameterType::Float,    1.0f  },
+    { RDwn.id,      RDwn.name,      ParameterType::Float,    1.0f  },
+    { Trip.id,      Trip.name,      ParameterType::Float,    0.1f  },
+    { PDwn.id,      PDwn.name,      ParameterType::Unsigned, 0.0f  },
+    { Polarity.id,  Polarity.name,  ParameterType::Unsigned, 0.0f  },
+    { ChStatus.id,  ChStatus.name,  ParameterType::Unsigned, 0.0f  },
+    { Pw.id,        Pw.name,        ParameterType::Unsigned, 0.0f  },
+}};
+
+constexpr std::size_t index(ParameterId id)
+{
+    return static_cast<std::size_t>(id);
+}
+
+constexpr const ParameterInfo& info(ParameterId id)
+{
+    return registry[index(id)];
+}
+
+// Whether a value read back from the board is the value that was written.
+// Every comparison of the two goes through here, so that a value rounded by
+// the board is never taken for one that was changed.
+inline bool matches(ParameterId id, float readBack, float value)
+{
+    return std::abs(readBack - value) <= std::max(info(id).tolerance, 0.001f * std::abs(value));
+}
+
+inline bool matches(ParameterId, unsigned long readBack, unsigned long value)
+{
+    return readBack == value;
+}
+
+constexpr std::optional<ParameterId> findParameter(std::string_view name)
+{
+    for (const auto& parameter : registry)
+    {
+        if (name == parameter.name)
+            return parameter.id;
+    }
+
+    return std::nullopt;
+}
+
+constexpr bool registryIsIndexedById()
+{
+    for (std::size_t i = 0; i < registry.size(); ++i)
+    {
+        if (index(registry[i].id) != i)
+            return false;
+    }
+
+    return true;
+}
+
+static_assert(registryIsIndexedById(), "The registry must be in ParameterId order");
+static_assert(findParameter("IMonH") == ParameterId::IMonH);
+
+} // namespace hv
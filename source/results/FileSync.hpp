@@ -0,0 +1,85 @@
+// FileSync.hpp
+
+#pragma once
+
+#include <cstdio>
+#include <cstdint>
+#include <filesystem>
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+// Flushes a stream and asks the OS to put it on the disk.
+inline bool syncFile(std::FILE* file)
+{
+    if (std::fflush(file) != 0)
+        return false;
+
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Renames and new files are only durable once their directory is synced. There
+// is no equivalent on Windows, where the rename itself is journaled.
+inline void syncDirectory(const std::filesystem::path& directory)
+{
+#ifndef _WIN32
+    int fd = open(directory.empty() ? "." : directory.c_str(), O_RDONLY);
+
+    if (fd >= 0)
+    {
+        fsync(fd);
+        close(fd);
+    }
+#endif
+}
+
+// Puts everything written to the file system that holds `file` on the disk in
+// one call, where the OS has one (syncfs on Linux). Streams must be flushed
+// first. Returns false elsewhere, and the caller syncs file by file.
+inline bool syncFileSystem(std::FILE* file)
+{
+#if defined(__linux__)
+    return syncfs(fileno(file)) == 0;
+#else
+    return false;
+#endif
+}
+
+// The length of a file up to its last newline, found by reading back from the
+// end. Whatever follows is a line cut short by a crash, or one still being
+// written.
+inline std::uint64_t wholeLines(std::FILE* file)
+{
+    constexpr long chunk = 4096;
+    char buffer[chunk];
+
+    if (std::fseek(file, 0, SEEK_END) != 0)
+        return 0;
+
+    long end = std::ftell(file);
+
+    while (end > 0)
+    {
+        long start = (end > chunk) ? end - chunk : 0;
+        auto length = static_cast<std::size_t>(end - start);
+
+        if (std::fseek(file, start, SEEK_SET) != 0 || std::fread(buffer, 1, length, file) != length)
+            return 0;
+
+        for (std::size_t i = length; i > 0; --i)
+            if (buffer[i - 1] == '\n')
+                return static_cast<std::uint64_t>(start) + i;
+
+        end = start;
+    }
+
+    return 0;
+}
@@ -0,0 +1,22 @@
+// ResultRecord.hpp
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#include <common/TestTypes.hpp>
+
+// The final result for one barcode at the end of a run.
+struct ResultRecord
+{
+    std::string barcode { "" };
+    std::string date { "" };
+    std::string user { "" };
+    TubeData data;
+
+    // Identifies the run the result came from, and when it was taken (seconds
+    // since the epoch). Used by the results store for its indices.
+    std::string runId { "" };
+    std::int64_t timestamp { 0 };
+};
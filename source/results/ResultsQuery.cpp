@@ -0,0 +1,127 @@
+// ResultsQuery.cpp
+//
+// Command line access to the results store.
+//
+//  dccs-results <store> barcode <barcode>     every result for a barcode
+//  dccs-results <store> latest <barcode>      the newest result for a barcode
+//  dccs-results <store> run <run id>          every result from a run
+//  dccs-results <store> date <from> [to]      results between two YYYY-MM-DD dates
+//  dccs-results <store> runs                  list the known run ids
+//  dccs-results <store> count                 number of stored results
+
+#include <string>
+#include <vector>
+#include <exception>
+
+#include <fmt/core.h>
+
+#include <spdlog/spdlog.h>
+
+#include "ResultsStore.hpp"
+
+static void usage()
+{
+    fmt::print(stderr, 
+        "usage: dccs-results <store> barcode <barcode>\n"
+        "       dccs-results <store> latest <barcode>\n"
+        "       dccs-results <store> run <run id>\n"
+        "       dccs-results <store> date <from YYYY-MM-DD> [to YYYY-MM-DD]\n"
+        "       dccs-results <store> runs\n"
+        "       dccs-results <store> count\n"
+    );
+}
+
+static void print(const std::vector<ResultRecord>& records)
+{
+    fmt::print("barcode,run,date,user,channel,current,voltage,intrinsic_current,samples,mean,stddev,min,max,slope\n");
+
+    for (const auto& record : records)
+    {
+        const auto& data = record.data;
+        const auto& statistics = data.statistics;
+
+        fmt::print(
+            "{},{},{},{},{},{},{},{},{},{},{},{},{},{}\n",
+            record.barcode,
+            record.runId,
+            record.date,
+            record.user,
+            data.channel,
+            data.current,
+            data.voltage,
+            data.intrinsicCurrent,
+            statistics.count,
+            statistics.mean,
+            statistics.standardDeviation(),
+            statistics.min,
+            statistics.max,
+            statistics.slope()
+        );
+    }
+}
+
+int main(int argc, char** argv)
+{
+    spdlog::set_level(spdlog::level::warn);
+
+    if (argc < 3)
+    {
+        usage();
+        return 2;
+    }
+
+    std::string command = argv[2];
+    std::string argument = (argc > 3) ? argv[3] : "";
+
+    try
+    {
+        // Read-only, so that it can be run while a station is writing.
+        ResultsStore store(argv[1], ResultsStore::Mode::ReadOnly);
+
+        if (command == "barcode" && argc > 3)
+        {
+            print(store.findByBarcode(argument));
+        }
+        else if (command == "latest" && argc > 3)
+        {
+            auto record = store.latestForBarcode(argument);
+
+            if (!record)
+            {
+                fmt::print(stderr, "No results for {}\n", argument);
+                return 1;
+            }
+
+            print({ *record });
+        }
+        else if (command == "run" && argc > 3)
+        {
+            print(store.findByRun(argument));
+        }
+        else if (command == "date" && argc > 3)
+        {
+            print(store.findByDate(argument, (argc > 4) ? argv[4] : argument));
+        }
+        else if (command == "runs")
+        {
+            for (const auto& id : store.runs())
+                fmt::print("{}\n", id);
+        }
+        else if (command == "count")
+        {
+            fmt::print("{}\n", store.size());
+        }
+        else
+        {
+            usage();
+            return 2;
+        }
+    }
+    catch (const std::exception& ex)
+    {
+        fmt::print(stderr, "dccs-results: {}\n", ex.what());
+        return 1;
+    }
+
+    return 0;
+}
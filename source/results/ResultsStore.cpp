@@ -0,0 +1,458 @@
+// ResultsStore.cpp
+
+#include "ResultsStore.hpp"
+
+#include <ctime>
+#include <charconv>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <filesystem>
+
+#include <fmt/core.h>
+
+#include <nlohmann/json.hpp>
+
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#include "FileSync.hpp"
+
+namespace fs = std::filesystem;
+using json = nlohmann::json;
+
+static double numberOrNaN(const json& value)
+{
+    if (value.is_number())
+        return value.get<double>();
+
+    return std::numeric_limits<double>::quiet_NaN();
+}
+
+// The index is tab separated, so keys must not contain tabs or newlines.
+static std::string sanitize(std::string key)
+{
+    for (auto& c : key)
+        if (c == '\t' || c == '\n' || c == '\r')
+            c = ' ';
+
+    return key;
+}
+
+static json toJson(const ResultRecord& record)
+{
+    const auto& data = record.data;
+    const auto& statistics = data.statistics;
+
+    return json {
+        { "barcode", record.barcode },
+        { "run", record.runId },
+        { "timestamp", record.timestamp },
+        { "date", record.date },
+        { "user", record.user },
+        { "channel", data.channel },
+        { "index", data.index },
+        { "current", data.current },
+        { "voltage", data.voltage },
+        { "intrinsic_current", data.intrinsicCurrent },
+        { "count", statistics.count },
+        { "mean", statistics.mean },
+        { "m2", statistics.m2 },
+        { "min", statistics.min },
+        { "max", statistics.max },
+        { "mean_time", statistics.meanTime },
+        { "m2_time", statistics.m2Time },
+        { "co_moment", statistics.coMoment }
+    };
+}
+
+static ResultRecord fromJson(const json& j)
+{
+    ResultRecord record;
+
+    record.barcode = j.at("barcode").get<std::string>();
+    record.runId = j.at("run").get<std::string>();
+    record.timestamp = j.at("timestamp").get<std::int64_t>();
+    record.date = j.at("date").get<std::string>();
+    record.user = j.at("user").get<std::string>();
+
+    auto& data = record.data;
+    data.channel = j.at("channel").get<int>();
+    data.index = j.at("index").get<int>();
+    data.current = static_cast<float>(numberOrNaN(j.at("current")));
+    data.voltage = static_cast<float>(numberOrNaN(j.at("voltage")));
+    data.intrinsicCurrent = static_cast<float>(numberOrNaN(j.at("intrinsic_current")));
+
+    auto& statistics = data.statistics;
+    statistics.count = j.at("count").get<int>();
+    statistics.mean = numberOrNaN(j.at("mean"));
+    statistics.m2 = numberOrNaN(j.at("m2"));
+    statistics.min = numberOrNaN(j.at("min"));
+    statistics.max = numberOrNaN(j.at("max"));
+    statistics.meanTime = numberOrNaN(j.at("mean_time"));
+    statistics.m2Time = numberOrNaN(j.at("m2_time"));
+    statistics.coMoment = numberOrNaN(j.at("co_moment"));
+
+    return record;
+}
+
+// A record cut short by a crash is the only thing that can follow the last
+// newline in the log. Drop it, so that the next append starts a fresh line.
+static void dropTornTail(const std::string& path)
+{
+    if (!fs::exists(path))
+        return;
+
+    std::FILE* file = std::fopen(path.c_str(), "rb");
+
+    if (!file)
+        return;
+
+    auto end = wholeLines(file);
+    std::fclose(file);
+
+    if (end != fs::file_size(path))
+        fs::resize_file(path, end);
+}
+
+ResultsStore::ResultsStore(std::string directory, Mode mode):
+    mode { mode },
+    log { nullptr },
+    index { nullptr },
+    logSize { 0 }
+{
+    try
+    {
+        logger = spdlog::stdout_color_mt("ResultsStore");
+    }
+    catch (const spdlog::spdlog_ex& ex)
+    {
+        logger = spdlog::get("ResultsStore");
+    }
+
+    fs::path base(directory);
+
+    if (!base.empty() && mode == Mode::ReadWrite)
+        fs::create_directories(base);
+
+    logPath = (base / "results.log").string();
+    indexPath = (base / "results.idx").string();
+
+    if (mode == Mode::ReadWrite)
+        dropTornTail(logPath);
+
+    log = std::fopen(logPath.c_str(), (mode == Mode::ReadWrite) ? "ab" : "rb");
+
+    if (!log)
+    {
+        logger->error("Cannot open results store in '{}'", directory);
+        throw std::runtime_error("Cannot open results store in '" + directory + "'");
+    }
+
+    logSize = (mode == Mode::ReadWrite) ? fs::file_size(logPath) : wholeLines(log);
+    reader.open(logPath, std::ios::binary);
+
+    try
+    {
+        loadIndex();
+    }
+    catch (...)
+    {
+        std::fclose(log);
+        throw;
+    }
+}
+
+ResultsStore::~ResultsStore()
+{
+    if (log)
+        std::fclose(log);
+
+    if (index)
+        std::fclose(index);
+}
+
+std::string ResultsStore::dateKey(std::int64_t timestamp)
+{
+    std::time_t t = static_cast<std::time_t>(timestamp);
+    std::tm local {};
+
+#ifdef _WIN32
+    localtime_s(&local, &t);
+#else
+    localtime_r(&t, &local);
+#endif
+
+    return fmt::format("{:04}-{:02}-{:02}", local.tm_year + 1900, local.tm_mon + 1, local.tm_mday);
+}
+
+void ResultsStore::indexRecord(std::uint64_t offset, const Keys& keys)
+{
+    byBarcode.emplace(keys.barcode, offset);
+    byRun.emplace(keys.runId, offset);
+    byDate.emplace(keys.date, offset);
+}
+
+void ResultsStore::loadIndex()
+{
+    std::string contents;
+
+    {
+        std::ifstream in(indexPath, std::ios::binary);
+        std::ostringstream buffer;
+        buffer << in.rdbuf();
+        contents = buffer.str();
+    }
+
+    // Only whole lines count. A line cut short by a crash is dropped here and
+    // its record is picked up again by the log rescan below.
+    auto end = contents.rfind('\n');
+    std::uint64_t validBytes = (end == std::string::npos) ? 0 : end + 1;
+
+    std::uint64_t lastOffset = 0;
+    bool haveEntries = false;
+
+    std::istringstream lines(contents.substr(0, validBytes));
+    std::uint64_t lineStart = 0;
+    std::string line;
+
+    while (std::getline(lines, line))
+    {
+        std::istringstream fields(line);
+        std::string offset;
+        Keys keys;
+        std::uint64_t o = 0;
+
+        bool valid = std::getline(fields, offset, '\t')
+            && std::getline(fields, keys.barcode, '\t')
+            && std::getline(fields, keys.runId, '\t')
+            && std::getline(fields, keys.date);
+
+        if (valid)
+        {
+            auto [end, error] = std::from_chars(offset.data(), offset.data() + offset.size(), o);
+            valid = (error == std::errc {}) && end == offset.data() + offset.size();
+        }
+
+        // A damaged line means no entry in the index can be trusted to be
+        // complete, so it is dropped and rebuilt from the log below.
+        if (!valid)
+        {
+            logger->warn("Unreadable entry at byte {} of {}, rebuilding the index", lineStart, indexPath);
+
+            byBarcode.clear();
+            byRun.clear();
+            byDate.clear();
+
+            validBytes = 0;
+            haveEntries = false;
+            break;
+        }
+
+        lineStart += line.size() + 1;
+
+        // The log is synced first, so this only happens if it was cut by hand.
+        if (o >= logSize)
+            continue;
+
+        indexRecord(o, keys);
+
+        if (!haveEntries || o > lastOffset)
+            lastOffset = o;
+
+        haveEntries = true;
+    }
+
+    if (mode == Mode::ReadOnly)
+    {
+        // A missing index only means every record is re-indexed below.
+        index = std::fopen(indexPath.c_str(), "rb");
+    }
+    else
+    {
+        if (contents.size() > validBytes)
+            fs::resize_file(indexPath, validBytes);
+
+        index = std::fopen(indexPath.c_str(), "ab");
+    }
+
+    if (!index && mode == Mode::ReadWrite)
+    {
+        logger->error("Cannot open {}", indexPath);
+        throw std::runtime_error("Cannot open " + indexPath);
+    }
+
+    // Find where the indexed part of the log ends.
+    std::uint64_t position = 0;
+
+    if (haveEntries)
+    {
+        reader.clear();
+        reader.seekg(lastOffset);
+        std::getline(reader, line);
+        position = lastOffset + line.size() + 1;
+    }
+
+    // Anything after that was logged but not indexed.
+    std::size_t recovered = 0;
+    reader.clear();
+    reader.seekg(position);
+
+    while (position < logSize && std::getline(reader, line))
+    {
+        try
+        {
+            auto record = fromJson(json::parse(line));
+            Keys keys { 
+                sanitize(record.barcode), 
+                sanitize(record.runId), 
+                dateKey(record.timestamp) 
+            };
+
+            if (mode == Mode::ReadWrite)
+            {
+                auto entry = fmt::format("{}\t{}\t{}\t{}\n", position, keys.barcode, keys.runId, keys.date);
+                std::fwrite(entry.data(), 1, entry.size(), index);
+            }
+
+            indexRecord(position, keys);
+            ++recovered;
+        }
+        catch (const std::exception& ex)
+        {
+            logger->error("Skipping unreadable record at offset {}: {}", position, ex.what());
+        }
+
+        position += line.size() + 1;
+    }
+
+    if (recovered && mode == Mode::ReadWrite)
+    {
+        syncFile(index);
+        logger->info("Re-indexed {} results missing from the index", recovered);
+    }
+}
+
+void ResultsStore::append(const std::vector<ResultRecord>& records)
+{
+    if (mode == Mode::ReadOnly)
+        throw std::logic_error("Cannot append to a results store opened read-only");
+
+    std::lock_guard<std::mutex> lock(mutex);
+
+    std::string logChunk;
+    std::string indexChunk;
+    std::vector<std::pair<std::uint64_t, Keys>> added;
+
+    std::uint64_t offset = logSize;
+
+    for (const auto& record : records)
+    {
+        auto line = toJson(record).dump() + "\n";
+        Keys keys { sanitize(record.barcode), sanitize(record.runId), dateKey(record.timestamp) };
+
+        indexChunk += fmt::format("{}\t{}\t{}\t{}\n", offset, keys.barcode, keys.runId, keys.date);
+        added.emplace_back(offset, keys);
+
+        offset += line.size();
+        logChunk += line;
+    }
+
+    // The log is synced before the index, so the index never points past it.
+    if (std::fwrite(logChunk.data(), 1, logChunk.size(), log) != logChunk.size() || !syncFile(log))
+    {
+        logger->error("Cannot append to {}", logPath);
+        throw std::runtime_error("Cannot append to " + logPath);
+    }
+
+    logSize = offset;
+
+    if (std::fwrite(indexChunk.data(), 1, indexChunk.size(), index) != indexChunk.size() || !syncFile(index))
+        logger->error("Cannot append to {}. It will be rebuilt on the next open", indexPath);
+
+    for (const auto& [o, keys] : added)
+        indexRecord(o, keys);
+}
+
+std::size_t ResultsStore::size()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return byBarcode.size();
+}
+
+ResultRecord ResultsStore::readAt(std::uint64_t offset)
+{
+    std::string line;
+
+    reader.clear();
+    reader.seekg(offset);
+    std::getline(reader, line);
+
+    return fromJson(json::parse(line));
+}
+
+std::vector<ResultRecord> ResultsStore::readAll(const std::vector<std::uint64_t>& offsets)
+{
+    std::vector<ResultRecord> records;
+    records.reserve(offsets.size());
+
+    for (auto offset : offsets)
+        records.push_back(readAt(offset));
+
+    return records;
+}
+
+static std::vector<std::uint64_t> collect(
+    std::multimap<std::string, std::uint64_t>::const_iterator first,
+    std::multimap<std::string, std::uint64_t>::const_iterator last
+)
+{
+    std::vector<std::uint64_t> offsets;
+
+    for (; first != last; ++first)
+        offsets.push_back(first->second);
+
+    return offsets;
+}
+
+std::vector<ResultRecord> ResultsStore::findByBarcode(const std::string& barcode)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto [first, last] = byBarcode.equal_range(sanitize(barcode));
+    return readAll(collect(first, last));
+}
+
+std::optional<ResultRecord> ResultsStore::latestForBarcode(const std::string& barcode)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto [first, last] = byBarcode.equal_range(sanitize(barcode));
+
+    if (first == last)
+        return std::nullopt;
+
+    // Equal keys keep insertion order, so the last one is the newest.
+    return readAt(std::prev(last)->second);
+}
+
+std::vector<ResultRecord> ResultsStore::findByRun(const std::string& runId)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto [first, last] = byRun.equal_range(sanitize(runId));
+    return readAll(collect(first, last));
+}
+
+std::vector<ResultRecord> ResultsStore::findByDate(const std::string& from, const std::string& to)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return readAll(collect(byDate.lower_bound(from), byDate.upper_bound(to)));
+}
+
+std::vector<std::string> ResultsStore::runs()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> ids;
+
+    for (auto it = byRun.begin(); it != byRun.end(); it = byRun.upper_bound(it->first))
+        ids.push_back(it->first);
+
+    return ids;
+}
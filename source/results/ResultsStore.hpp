@@ -0,0 +1,98 @@
+// ResultsStore.hpp
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <memory>
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+
+#include <spdlog/spdlog.h>
+
+#include "ResultRecord.hpp"
+
+// An embedded, file-based store of every result ever taken at the station.
+//
+// Results are appended as one JSON document per line to `results.log`, which
+// is never rewritten. Alongside it, `results.idx` holds one line per record
+// with the record's offset in the log and its barcode, run and date keys. The
+// index is loaded into ordered maps when the store is opened, so every lookup
+// is a logarithmic search followed by direct reads at known offsets. If the
+// index is behind the log (e.g. after a crash between the two appends), the
+// missing tail of the log is re-indexed on open.
+//
+// A store opened read-only never changes either file, so it is safe to open
+// while a station is writing: a torn or half-written record at the end of
+// the log is ignored, and records missing from the index are indexed in
+// memory only. It sees the store as it was when opened.
+class ResultsStore
+{
+public:
+    enum class Mode
+    {
+        ReadWrite,
+        ReadOnly
+    };
+
+    explicit ResultsStore(std::string directory, Mode mode = Mode::ReadWrite);
+    ~ResultsStore();
+
+    ResultsStore(const ResultsStore&) = delete;
+    ResultsStore(ResultsStore&&) = delete;
+
+    ResultsStore& operator=(const ResultsStore&) = delete;
+    ResultsStore& operator=(ResultsStore&&) = delete;
+
+    // Throws on a read-only store.
+    void append(const std::vector<ResultRecord>& records);
+
+    std::size_t size();
+
+    // All results for a barcode, oldest first.
+    std::vector<ResultRecord> findByBarcode(const std::string& barcode);
+    std::optional<ResultRecord> latestForBarcode(const std::string& barcode);
+
+    std::vector<ResultRecord> findByRun(const std::string& runId);
+
+    // Results taken between two dates, inclusive, given as YYYY-MM-DD.
+    std::vector<ResultRecord> findByDate(const std::string& from, const std::string& to);
+
+    std::vector<std::string> runs();
+
+    static std::string dateKey(std::int64_t timestamp);
+
+private:
+    struct Keys
+    {
+        std::string barcode;
+        std::string runId;
+        std::string date;
+    };
+
+    void loadIndex();
+    void indexRecord(std::uint64_t offset, const Keys& keys);
+    std::vector<ResultRecord> readAll(const std::vector<std::uint64_t>& offsets);
+    ResultRecord readAt(std::uint64_t offset);
+
+private:
+    std::string logPath;
+    std::string indexPath;
+    Mode mode;
+
+    std::mutex mutex;
+    std::FILE* log;
+    std::FILE* index;
+    std::ifstream reader;
+    std::uint64_t logSize;
+
+    std::multimap<std::string, std::uint64_t> byBarcode;
+    std::multimap<std::string, std::uint64_t> byRun;
+    std::multimap<std::string, std::uint64_t> byDate;
+
+    std::shared_ptr<spdlog::logger> logger;
+};
@@ -0,0 +1,260 @@
+// ResultsWriter.cpp
+
+#include "ResultsWriter.hpp"
+
+#include <map>
+#include <cstdio>
+#include <cstdint>
+#include <filesystem>
+
+#include <fmt/core.h>
+
+#include <spdlog/sinks/stdout_color_sinks.h>
+
+#include "FileSync.hpp"
+
+namespace fs = std::filesystem;
+
+// A line cut short by a crash can only be at the end of a file. Drop it, so
+// that the next result starts a line of its own.
+static void dropTornLine(const fs::path& path)
+{
+    std::FILE* file = std::fopen(path.string().c_str(), "rb");
+
+    if (!file)
+        return;
+
+    std::fseek(file, 0, SEEK_END);
+    auto size = static_cast<std::uint64_t>(std::ftell(file));
+    auto whole = wholeLines(file);
+    std::fclose(file);
+
+    if (whole < size)
+        fs::resize_file(path, whole);
+}
+
+ResultsWriter::ResultsWriter(std::string directory, std::shared_ptr<ResultsStore> store):
+    directory { directory },
+    store { store },
+    writing { false },
+    stopping { false }
+{
+    try
+    {
+        logger = spdlog::stdout_color_mt("ResultsWriter");
+    }
+    catch (const spdlog::spdlog_ex& ex)
+    {
+        logger = spdlog::get("ResultsWriter");
+    }
+
+    worker = std::thread(&ResultsWriter::run, this);
+}
+
+ResultsWriter::~ResultsWriter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+
+    wake.notify_one();
+    worker.join();
+}
+
+void ResultsWriter::submit(std::vector<ResultRecord> records)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        for (auto& record : records)
+            pending.push_back(std::move(record));
+    }
+
+    wake.notify_one();
+}
+
+void ResultsWriter::submitReport(std::string name, std::string text)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        reports.emplace_back(std::move(name), std::move(text));
+    }
+
+    wake.notify_one();
+}
+
+void ResultsWriter::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this]() { return pending.empty() && reports.empty() && !writing; });
+}
+
+std::string ResultsWriter::formatLine(const ResultRecord& record)
+{
+    const auto& val = record.data;
+
+    return fmt::format(
+        "{},{},{},{},{},{},{},{},{},{},{}",
+        val.current,
+        record.date,
+        val.voltage,
+        record.user,
+        val.channel,
+        val.statistics.count,
+        val.statistics.mean,
+        val.statistics.standardDeviation(),
+        val.statistics.min,
+        val.statistics.max,
+        val.statistics.slope()
+    );
+}
+
+void ResultsWriter::run()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true)
+    {
+        wake.wait(lock, [this]() { return stopping || !pending.empty() || !reports.empty(); });
+
+        if (pending.empty() && reports.empty() && stopping)
+            return;
+
+        // Take everything queued so far as one batch.
+        std::vector<ResultRecord> batch(
+            std::make_move_iterator(pending.begin()), 
+            std::make_move_iterator(pending.end())
+        );
+        pending.clear();
+
+        auto texts = std::move(reports);
+        reports.clear();
+        writing = true;
+
+        lock.unlock();
+
+        if (!batch.empty())
+            writeBatch(batch);
+
+        for (const auto& [name, text] : texts)
+            writeReport(name, text);
+
+        lock.lock();
+
+        writing = false;
+
+        if (pending.empty() && reports.empty())
+            idle.notify_all();
+    }
+}
+
+void ResultsWriter::writeBatch(std::vector<ResultRecord>& batch)
+{
+    std::map<std::string, std::vector<const ResultRecord*>> byBarcode;
+
+    for (const auto& record : batch)
+        byBarcode[record.barcode].push_back(&record);
+
+    struct Appended
+    {
+        fs::path path;
+        std::FILE* file;
+    };
+
+    std::vector<Appended> appended;
+    fs::path base(directory);
+
+    // Only the new lines are written; the history already in a file stays
+    // where it is.
+    for (const auto& [barcode, records] : byBarcode)
+    {
+        fs::path path = base / (barcode + ".csv");
+
+        dropTornLine(path);
+
+        std::FILE* file = std::fopen(path.string().c_str(), "ab");
+
+        if (!file)
+        {
+            logger->error("Cannot open {} for writing", path.string());
+            continue;
+        }
+
+        std::string lines;
+
+        for (const auto* record : records)
+            lines += formatLine(*record) + "\n";
+
+        if (std::fwrite(lines.data(), 1, lines.size(), file) != lines.size() || std::fflush(file) != 0)
+            logger->error("Cannot write results for {}", barcode);
+
+        appended.push_back({ path, file });
+    }
+
+    // One sync for the whole batch where the OS can do that, and one per file
+    // where it cannot.
+    bool synced = !appended.empty() && syncFileSystem(appended.front().file);
+
+    for (auto& entry : appended)
+    {
+        if (!synced && !syncFile(entry.file))
+            logger->error("Cannot sync {}", entry.path.string());
+
+        std::fclose(entry.file);
+    }
+
+    if (!synced)
+        syncDirectory(base);
+
+    if (store)
+    {
+        try
+        {
+            store->append(batch);
+        }
+        catch (const std::exception& ex)
+        {
+            logger->error("Cannot add results to the results store: {}", ex.what());
+        }
+    }
+
+    logger->debug("Wrote {} results to {} files", batch.size(), appended.size());
+}
+
+void ResultsWriter::writeReport(const std::string& name, const std::string& text)
+{
+    fs::path base(directory);
+    fs::path destination = base / name;
+    fs::path temporary = base / (name + ".tmp");
+
+    std::FILE* file = std::fopen(temporary.string().c_str(), "wb");
+
+    if (!file)
+    {
+        logger->error("Cannot open {} for writing", temporary.string());
+        return;
+    }
+
+    if (std::fwrite(text.data(), 1, text.size(), file) != text.size() || !syncFile(file))
+    {
+        logger->error("Cannot write {}", destination.string());
+        std::fclose(file);
+        fs::remove(temporary);
+        return;
+    }
+
+    std::fclose(file);
+
+    std::error_code error;
+    fs::rename(temporary, destination, error);
+
+    if (error)
+    {
+        logger->error("Cannot replace {}: {}", destination.string(), error.message());
+        return;
+    }
+
+    syncDirectory(base);
+    logger->debug("Wrote {}", destination.string());
+}
@@ -0,0 +1,69 @@
+// ResultsWriter.hpp
+
+#pragma once
+
+#include <mutex>
+#include <deque>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <memory>
+#include <condition_variable>
+
+#include <spdlog/spdlog.h>
+
+#include "ResultRecord.hpp"
+#include "ResultsStore.hpp"
+
+// Writes results to `<directory>/<barcode>.csv` on a background thread.
+//
+// Everything submitted while the thread is busy is written as one batch. New
+// results are appended to the history in each file, and the batch is put on
+// the disk with a single syncfs where the OS has one, or a sync per file
+// where it does not. A line torn by a crash is dropped before the next
+// append. When a results store is given, every batch is also appended to the
+// store.
+class ResultsWriter
+{
+public:
+    explicit ResultsWriter(std::string directory, std::shared_ptr<ResultsStore> store = nullptr);
+    ~ResultsWriter();
+
+    ResultsWriter(const ResultsWriter&) = delete;
+    ResultsWriter(ResultsWriter&&) = delete;
+
+    ResultsWriter& operator=(const ResultsWriter&) = delete;
+    ResultsWriter& operator=(ResultsWriter&&) = delete;
+
+    void submit(std::vector<ResultRecord> records);
+
+    // Writes a text file, such as a run report, to `<directory>/<name>` in
+    // the same crash-safe way, replacing any file of that name.
+    void submitReport(std::string name, std::string text);
+
+    // Blocks until everything submitted so far is on disk.
+    void flush();
+
+    static std::string formatLine(const ResultRecord& record);
+
+private:
+    void run();
+    void writeBatch(std::vector<ResultRecord>& batch);
+    void writeReport(const std::string& name, const std::string& text);
+
+private:
+    std::string directory;
+    std::shared_ptr<ResultsStore> store;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::deque<ResultRecord> pending;
+    std::deque<std::pair<std::string, std::string>> reports;
+    bool writing;
+    bool stopping;
+
+    std::thread worker;
+    std::shared_ptr<spdlog::logger> logger;
+};
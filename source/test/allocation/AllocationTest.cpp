@@ -0,0 +1,153 @@
+// AllocationTest.cpp
+//
+// Polls a virtual supply the way the sampling loop does and fails if any of
+// the polls allocate. Every operator new in the process is counted, so this
+// only needs the FakeHV backend.
+
+#include <new>
+#include <array>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+
+#include <spdlog/spdlog.h>
+
+#include <psu/ChannelSet.hpp>
+#include <psu/PSUController.hpp>
+#include <psu/FakeHV/FakeHVLibrary.h>
+
+static std::atomic<bool> counting { false };
+static std::atomic<std::size_t> allocations { 0 };
+
+void* operator new(std::size_t size)
+{
+    if (counting)
+        ++allocations;
+
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+constexpr int polls = 1000;
+
+// Returns the number of allocations made by `polls` polls of `channels`.
+static std::size_t poll(PSUController& controller, const ChannelSet& channels)
+{
+    std::array<float, ChannelSet::capacity> voltages;
+    std::array<float, ChannelSet::capacity> currents;
+    std::array<unsigned long, ChannelSet::capacity> statuses;
+
+    auto n = channels.size();
+
+    // The first poll may set things up (e.g. the loggers' formatters).
+    controller.readCurrents(channels, std::span(currents).first(n));
+    controller.readVoltages(channels, std::span(voltages).first(n));
+    controller.readStatuses(channels, std::span(statuses).first(n));
+
+    allocations = 0;
+    counting = true;
+
+    for (int i = 0; i < polls; ++i)
+    {
+        controller.readCurrents(channels, std::span(currents).first(n));
+        controller.readVoltages(channels, std::span(voltages).first(n));
+        controller.readStatuses(channels, std::span(statuses).first(n));
+    }
+
+    counting = false;
+
+    return allocations;
+}
+
+// The same for reads that fail, through the non-throwing API.
+static std::size_t pollFailing(PSUController& controller, const ChannelSet& channels)
+{
+    std::array<float, ChannelSet::capacity> currents;
+    auto n = channels.size();
+
+    if (controller.tryReadCurrents(channels, std::span(currents).first(n)))
+        return polls;
+
+    allocations = 0;
+    counting = true;
+
+    for (int i = 0; i < polls; ++i)
+    {
+        if (controller.tryReadCurrents(channels, std::span(currents).first(n)))
+            break;
+    }
+
+    counting = false;
+
+    return allocations;
+}
+
+static bool check(const char* name, std::size_t count)
+{
+    std::printf("[TEST] %s: %zu allocations in %d polls: %s\n", name, count, polls, count ? "FAILED" : "PASSED");
+    return count == 0;
+}
+
+int main()
+{
+    spdlog::set_level(spdlog::level::info);
+
+    bool passed = true;
+
+    // Two boards, so every poll is split across slots.
+    const unsigned short layout[] = { 4, 4 };
+    FakeHV_SetCrateLayout(2, layout);
+
+    {
+        PSUController controller;
+        controller.connectToPSU(msu_smdt::Port {});
+
+        ChannelSet single { 2 };
+        ChannelSet board { 0, 1, 2, 3 };
+        ChannelSet crate { 7, 0, 5, 2, 6, 1, 4, 3 };
+
+        controller.setTestVoltages(crate, 3015.0f);
+        controller.powerOnChannels(crate);
+
+        passed &= check("single_channel", poll(controller, single));
+        passed &= check("one_slot", poll(controller, board));
+        passed &= check("two_slots_out_of_order", poll(controller, crate));
+
+        // Channel 9 is not in the crate.
+        passed &= check("failed_reads", pollFailing(controller, ChannelSet { 0, 9 }));
+
+        controller.powerOffChannels(crate);
+        controller.disconnectFromPSU();
+    }
+
+    FakeHV_Reset();
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -19,20 +19,20 @@ void TestControlOfPowerSupply()
     interface.clearAlarm();
     interface.setInterlock(true);
 
-    interface.setParametersFloat("VSet", 15.00f, {0, 1, 2, 3});
-    interface.setParametersFloat("ISet", 2.000f, {0, 1, 2, 3});
-    interface.setParametersFloat("MaxV", 100.0f, {0, 1, 2, 3});
-    interface.setParametersFloat("RUp", 15.00f, {0, 1, 2, 3});
-    interface.setParametersFloat("RDwn", 15.00f, {0, 1, 2, 3});
-    interface.setParametersFloat("Trip", 1000.0f, {0, 1, 2, 3});
-    interface.setParametersLong("PDwn", 0, {0, 1, 2, 3});
+    interface.set<hv::VSet>(15.00f, {0, 1, 2, 3});
+    interface.set<hv::ISet>(2.000f, {0, 1, 2, 3});
+    interface.set<hv::MaxV>(100.0f, {0, 1, 2, 3});
+    interface.set<hv::RUp>(15.00f, {0, 1, 2, 3});
+    interface.set<hv::RDwn>(15.00f, {0, 1, 2, 3});
+    interface.set<hv::Trip>(1000.0f, {0, 1, 2, 3});
+    interface.set<hv::PDwn>(0, {0, 1, 2, 3});
 
-    interface.setParametersLong("Pw", 1, {0, 1});
+    interface.set<hv::Pw>(1, {0, 1});
 
     for (int i = 0; i < 15; ++i)
     {
-        auto voltage = interface.getParametersFloat("VMon", {0, 1});
-        auto current = interface.getParametersFloat("IMonH", {0, 1});
+        auto voltage = interface.get<hv::VMon>({0, 1});
+        auto current = interface.get<hv::IMonH>({0, 1});
 
         logger->info(
             "\tCH0: ({} V, {} nA), CH1: ({} V, {} nA)", 
@@ -44,7 +44,7 @@ void TestControlOfPowerSupply()
         QThread::sleep(1);
     }
 
-    interface.setParametersLong("Pw", 0, {0, 1});
+    interface.set<hv::Pw>(0, {0, 1});
 }
 
 void TestPSUController()